@@ -1,20 +1,32 @@
+newoption {
+	trigger = "headless",
+	description = "Build with the headless graphics device for benchmarking without a GPU"
+}
+
 solution {"Spadengine"}
 	premake.gcc.cc = 'clang'
 	premake.gcc.cxx = 'clang++'
 	
 	
-	defines {"OPENGL4"}
+	-- The headless backend records the graphics calls without a window or a GPU.
+	if _OPTIONS["headless"] then
+		defines {"HEADLESS"}
+	else
+		defines {"OPENGL4"}
+	end
 	configurations { "DEBUG", "RELEASE" }
 
 	configuration "Debug"
 		defines { "DEBUG" }
 		flags   { "Symbols","NoExceptions" }
-		buildoptions { "-std=c++11" }
+		buildoptions { "-std=c++11", "-pthread" }
+		linkoptions { "-pthread" }
 
 	configuration "Release"
 		defines { "NDEBUG","RELEASE_BUILD" }
 		flags   { "Optimize","NoExceptions"}
-		buildoptions { "-std=c++11" }
+		buildoptions { "-std=c++11", "-pthread" }
+		linkoptions { "-pthread" }
 
 -- THIRD PARTY LIBRARIES
 	project "glad"
@@ -227,5 +239,54 @@ solution {"Spadengine"}
 				"../ThirdParty/SDL/include/",
 				"../ThirdParty/stb_image/Include/"}
 		links {"Spade","Game","Audio","Renderer","HID","Resources","Core","assimp","glad", "dl", "SDL2","Bullet","sndfile", "portaudio","freetype"}
+
+	project "BenchmarkSample"
+		kind "ConsoleApp"
+		language "C++"
+		location "../Samples/BenchmarkSample/"
+		files {"../Samples/BenchmarkSample/**.cpp"}
+		includedirs {"../Samples/BenchmarkSample/Include/",
+				"../Core/Include/",
+				"../Game/Include/",
+				"../HID/Include/",
+				"../Renderer/Include/",
+				"../Resources/Include/",
+				"../ThirdParty/assimp/include/",
+				"../ThirdParty/freetype/include/",
+				"../ThirdParty/glad/Include/",
+				"../ThirdParty/glm/include/",
+				"../ThirdParty/SDL/include/",
+				"../ThirdParty/stb_image/Include/"}
+		links {"Game","Renderer","HID","Resources","Core","assimp","glad", "dl", "SDL2", "freetype"}
+
+	project "TextureCooker"
+		kind "ConsoleApp"
+		language "C++"
+		location "../Samples/TextureCooker/"
+		files {"../Samples/TextureCooker/**.cpp"}
+		includedirs {"../Core/Include/",
+				"../Renderer/Include/",
+				"../Resources/Include/",
+				"../ThirdParty/assimp/include/",
+				"../ThirdParty/freetype/include/",
+				"../ThirdParty/glm/include/",
+				"../ThirdParty/SDL/include/",
+				"../ThirdParty/stb_image/Include/"}
+		links {"Resources","Renderer","Core","assimp","glad", "dl", "SDL2", "freetype"}
+
+	project "ModelCooker"
+		kind "ConsoleApp"
+		language "C++"
+		location "../Samples/ModelCooker/"
+		files {"../Samples/ModelCooker/**.cpp"}
+		includedirs {"../Core/Include/",
+				"../Renderer/Include/",
+				"../Resources/Include/",
+				"../ThirdParty/assimp/include/",
+				"../ThirdParty/freetype/include/",
+				"../ThirdParty/glm/include/",
+				"../ThirdParty/SDL/include/",
+				"../ThirdParty/stb_image/Include/"}
+		links {"Resources","Renderer","Core","assimp","glad", "dl", "SDL2", "freetype"}
 	 
 	
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <cfloat>
+
+#include "Core/Math.h"
+
+namespace sge
+{
+	/** \brief Axis aligned bounding box. */
+	struct AABB
+	{
+		math::vec3 min;	/**< Minimum corner. */
+		math::vec3 max;	/**< Maximum corner. */
+
+		AABB() : min(FLT_MAX), max(-FLT_MAX)
+		{
+		}
+
+		AABB(const math::vec3& min, const math::vec3& max) : min(min), max(max)
+		{
+		}
+
+		math::vec3 getCenter() const
+		{
+			return (min + max) * 0.5f;
+		}
+
+		math::vec3 getExtents() const
+		{
+			return (max - min) * 0.5f;
+		}
+
+		/** \brief Surface area of the box, used as the insertion cost metric. */
+		float getSurfaceArea() const
+		{
+			math::vec3 d = max - min;
+			return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+		}
+
+		bool isValid() const
+		{
+			return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+		}
+
+		void expand(const math::vec3& point)
+		{
+			min = math::min(min, point);
+			max = math::max(max, point);
+		}
+
+		void expand(const AABB& other)
+		{
+			min = math::min(min, other.min);
+			max = math::max(max, other.max);
+		}
+
+		bool contains(const AABB& other) const
+		{
+			return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+				other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+		}
+
+		bool overlaps(const AABB& other) const
+		{
+			return min.x <= other.max.x && other.min.x <= max.x &&
+				min.y <= other.max.y && other.min.y <= max.y &&
+				min.z <= other.max.z && other.min.z <= max.z;
+		}
+
+		static AABB merge(const AABB& a, const AABB& b)
+		{
+			return AABB(math::min(a.min, b.min), math::max(a.max, b.max));
+		}
+
+		/** \brief Transforms the box and returns the box enclosing the result.
+		*
+		*	Uses Arvo's method, so only the 3x3 part and translation of the matrix are touched.
+		*	\param const math::mat4& matrix : The transformation.
+		*	\return Returns the world space bounds.
+		*/
+		AABB transform(const math::mat4& matrix) const
+		{
+			math::vec3 translation(matrix[3]);
+			AABB result(translation, translation);
+
+			for (int i = 0; i < 3; i++)
+			{
+				for (int j = 0; j < 3; j++)
+				{
+					float a = matrix[j][i] * min[j];
+					float b = matrix[j][i] * max[j];
+
+					result.min[i] += a < b ? a : b;
+					result.max[i] += a < b ? b : a;
+				}
+			}
+
+			return result;
+		}
+	};
+
+	struct Sphere
+	{
+		math::vec3 center;
+		float radius;
+	};
+
+	struct Ray
+	{
+		math::vec3 origin;
+		math::vec3 direction;
+		float length;
+	};
+
+	/** \brief Plane in the form dot(normal, p) + distance = 0. */
+	struct Plane
+	{
+		math::vec3 normal;
+		float distance;
+	};
+
+	/** \brief View frustum described by its six planes, normals pointing inwards. */
+	struct Frustum
+	{
+		enum Side
+		{
+			LEFT,
+			RIGHT,
+			BOTTOM,
+			TOP,
+			FRONT,	// Near plane, NEAR is a macro on Windows.
+			BACK,	// Far plane.
+			COUNT
+		};
+
+		Plane planes[COUNT];
+
+		Frustum()
+		{
+		}
+
+		/** \brief Extracts the planes from a combined view projection matrix.
+		*
+		*	\param const math::mat4& viewProj : Projection * view, as given by CameraComponent::getViewProj.
+		*/
+		explicit Frustum(const math::mat4& viewProj)
+		{
+			math::mat4 m = math::transpose(viewProj);
+
+			setPlane(LEFT, m[3] + m[0]);
+			setPlane(RIGHT, m[3] - m[0]);
+			setPlane(BOTTOM, m[3] + m[1]);
+			setPlane(TOP, m[3] - m[1]);
+			setPlane(FRONT, m[3] + m[2]);
+			setPlane(BACK, m[3] - m[2]);
+		}
+
+		/** \brief Tests a box against the frustum.
+		*
+		*	\return Returns false only when the box is completely outside of some plane.
+		*/
+		bool intersects(const AABB& box) const
+		{
+			math::vec3 center = box.getCenter();
+			math::vec3 extents = box.getExtents();
+
+			for (int i = 0; i < COUNT; i++)
+			{
+				const Plane& p = planes[i];
+				float radius = math::dot(extents, math::abs(p.normal));
+
+				if (math::dot(p.normal, center) + p.distance < -radius)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		bool intersects(const Sphere& sphere) const
+		{
+			for (int i = 0; i < COUNT; i++)
+			{
+				if (math::dot(planes[i].normal, sphere.center) + planes[i].distance < -sphere.radius)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+	private:
+		void setPlane(Side side, const math::vec4& plane)
+		{
+			float length = math::length(math::vec3(plane));
+
+			planes[side].normal = math::vec3(plane) / length;
+			planes[side].distance = plane.w / length;
+		}
+	};
+
+	inline bool intersects(const AABB& box, const Sphere& sphere)
+	{
+		math::vec3 closest = math::clamp(sphere.center, box.min, box.max);
+		math::vec3 delta = closest - sphere.center;
+
+		return math::dot(delta, delta) <= sphere.radius * sphere.radius;
+	}
+
+	/** \brief Slab test between a ray and a box.
+	*
+	*	\param const math::vec3& inverseDirection : Component-wise 1 / ray.direction.
+	*	\param float& distance : Distance along the ray to the entry point when true is returned.
+	*/
+	inline bool intersects(const AABB& box, const Ray& ray, const math::vec3& inverseDirection, float& distance)
+	{
+		math::vec3 t0 = (box.min - ray.origin) * inverseDirection;
+		math::vec3 t1 = (box.max - ray.origin) * inverseDirection;
+
+		math::vec3 tmin = math::min(t0, t1);
+		math::vec3 tmax = math::max(t0, t1);
+
+		float enter = math::max(math::max(tmin.x, tmin.y), math::max(tmin.z, 0.0f));
+		float exit = math::min(math::min(tmax.x, tmax.y), math::min(tmax.z, ray.length));
+
+		distance = enter;
+
+		return enter <= exit;
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Game/Component.h"
+#include "Core/Bounds.h"
+#include "Core/Types.h"
+
+namespace sge
+{
+	class SpatialSystem;
+	class TransformComponent;
+
+	/** \brief Local space bounds of an Entity.
+	*
+	*	The SpatialSystem keeps a proxy in its tree for every BoundsComponent
+	*	and refits it whenever the Entity's TransformComponent changes. The proxy
+	*	is removed when the component is destroyed.
+	*/
+	class BoundsComponent : public Component
+	{
+		friend class SpatialSystem;
+
+	public:
+		BoundsComponent(Entity* ent);
+
+		/** \brief The destructor, removes the proxy from the SpatialSystem the component was added to. */
+		~BoundsComponent();
+
+		void update();
+
+		/** \brief Setter function for the local bounds.
+		*
+		* \param const AABB& bounds : Bounds in the Entity's local space, for example ModelResource::getBounds().
+		*/
+		void setLocalBounds(const AABB& bounds);
+
+		const AABB& getLocalBounds()
+		{
+			return localBounds;
+		}
+
+		/** \brief Getter function for the world space bounds.
+		*
+		* \return The bounds as of the latest SpatialSystem update.
+		*/
+		const AABB& getWorldBounds()
+		{
+			return worldBounds;
+		}
+
+	private:
+		TransformComponent* transform;
+		AABB localBounds;		/**< Bounds in local space. */
+		AABB worldBounds;		/**< Bounds in world space. */
+		SpatialSystem* system;	/**< SpatialSystem holding the proxy, nullptr when not added to one. */
+		int32 proxy;			/**< Proxy id in the SpatialSystem's tree. */
+		uint32 version;			/**< Transform version the world bounds were computed from. */
+		bool boundsChanged;		/**< Local bounds were changed since the last update. */
+	};
+}
@@ -32,14 +32,44 @@ namespace sge
             return viewProj;
         }
 
+        const sge::math::mat4& getView()
+        {
+            return view;
+        }
+
+        const sge::math::mat4& getProjection()
+        {
+            return proj;
+        }
+
+        float getNear() const
+        {
+            return nearPlane;
+        }
+
+        float getFar() const
+        {
+            return farPlane;
+        }
+
+        bool isPerspective() const
+        {
+            return perspective;
+        }
+
 	private:
         void updateView();
 
         Viewport viewport;
 
 		math::mat4 viewProj;
+		math::mat4 view;
 		math::mat4 proj;
 
+        float nearPlane;
+        float farPlane;
+        bool perspective;
+
         TransformComponent* transform;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <vector>
+
+#include "Core/Bounds.h"
+#include "Core/Types.h"
+
+namespace sge
+{
+	/** \brief Result of a ray query. */
+	struct RayHit
+	{
+		void* userData;	/**< User data of the hit proxy. */
+		float distance;	/**< Distance along the ray to the proxy's bounds. */
+	};
+
+	/** \brief Dynamic bounding volume hierarchy of axis aligned boxes.
+	*
+	*	Leaves store "fat" boxes that are enlarged by a margin and by the predicted movement,
+	*	so small movements don't touch the tree at all. When an object leaves its fat box
+	*	the leaf is removed and reinserted using the surface area heuristic and the tree is
+	*	kept balanced with AVL style rotations.
+	*
+	*	Batched queries test several volumes in a single traversal and report the results
+	*	into one output vector per volume. A batch can hold at most MAX_BATCH volumes.
+	*/
+	class DynamicAABBTree
+	{
+	public:
+		static const int32 NULL_NODE = -1;
+		static const size_t MAX_BATCH = 32;
+
+		/** \brief The constructor.
+		*
+		*	\param float margin : How much leaf boxes are enlarged in every direction.
+		*/
+		DynamicAABBTree(float margin = 0.1f);
+		~DynamicAABBTree();
+
+		/** \brief Creates a proxy for a box.
+		*
+		*	\param const AABB& aabb : Tight world space bounds.
+		*	\param void* userData : Data returned by the queries.
+		*	\return Returns the proxy id.
+		*/
+		int32 createProxy(const AABB& aabb, void* userData);
+
+		/** \brief Removes a proxy from the tree. */
+		void destroyProxy(int32 proxy);
+
+		/** \brief Refits a proxy after its bounds have changed.
+		*
+		*	\param const AABB& aabb : New tight bounds.
+		*	\param const math::vec3& displacement : Movement since the last update, used to predict the fat box.
+		*	\return Returns true if the leaf had to be reinserted.
+		*/
+		bool moveProxy(int32 proxy, const AABB& aabb, const math::vec3& displacement);
+
+		void* getUserData(int32 proxy) const
+		{
+			return nodes[proxy].userData;
+		}
+
+		const AABB& getFatAABB(int32 proxy) const
+		{
+			return nodes[proxy].aabb;
+		}
+
+		size_t getProxyCount() const
+		{
+			return proxyCount;
+		}
+
+		/** \brief Height of the tree, 0 for a single leaf. */
+		int32 getHeight() const;
+
+		void queryAABB(const AABB& aabb, std::vector<void*>& results) const;
+
+		void queryFrustum(const Frustum& frustum, std::vector<void*>& results) const;
+		void queryFrustums(size_t count, const Frustum frustums[], std::vector<void*> results[]) const;
+
+		void querySphere(const Sphere& sphere, std::vector<void*>& results) const;
+		void querySpheres(size_t count, const Sphere spheres[], std::vector<void*> results[]) const;
+
+		/** \brief Finds the proxies hit by a ray, sorted from the nearest to the farthest. */
+		void queryRay(const Ray& ray, std::vector<RayHit>& results) const;
+		void queryRays(size_t count, const Ray rays[], std::vector<RayHit> results[]) const;
+
+		/** \brief Checks the structure of the tree. Meant for debug builds. */
+		void validate() const;
+
+	private:
+		struct Node
+		{
+			AABB aabb;
+			void* userData;
+
+			union
+			{
+				int32 parent;
+				int32 next;
+			};
+
+			int32 child1;
+			int32 child2;
+			int32 height;	/**< 0 for leaves, -1 for free nodes. */
+
+			bool isLeaf() const
+			{
+				return child1 == NULL_NODE;
+			}
+		};
+
+		/** \brief Traversal stack entry of the batched queries. */
+		struct StackEntry
+		{
+			int32 node;
+			uint32 partial;	/**< Volumes that still intersect the node partially. */
+			uint32 inside;	/**< Volumes that contain the whole node. */
+		};
+
+		static const size_t STACK_SIZE = 256;
+
+		int32 allocateNode();
+		void freeNode(int32 node);
+
+		void insertLeaf(int32 leaf);
+		void removeLeaf(int32 leaf);
+
+		int32 balance(int32 index);
+
+		void collectLeaves(int32 node, uint32 mask, std::vector<void*> results[]) const;
+
+		int32 validateNode(int32 index) const;
+
+		std::vector<Node> nodes;
+		int32 root;
+		int32 freeList;
+		size_t proxyCount;
+		float margin;
+	};
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+
+#include "Core/Bounds.h"
+#include "Core/Math.h"
+#include "Core/Types.h"
+
+#include "Game/PointLightComponent.h"
+
+namespace sge
+{
+	class CameraComponent;
+
+	/** \brief Bins point lights into view space clusters for clustered forward shading.
+	*
+	*	The view volume of every camera is split into CLUSTER_X * CLUSTER_Y screen tiles and
+	*	CLUSTER_Z depth slices. Perspective cameras use exponentially spaced slices so the
+	*	clusters stay roughly cubical. Each cluster stores an offset and a count into a light
+	*	index list shared by all clusters, so a fragment only evaluates the lights reaching it.
+	*
+	*	The clusters of all cameras are stored back to back; CameraData::grid[3] is the index
+	*	of the first cluster of a camera.
+	*/
+	class LightGrid
+	{
+	public:
+		static const uint32 CLUSTER_X = 16;
+		static const uint32 CLUSTER_Y = 9;
+		static const uint32 CLUSTER_Z = 24;
+		static const uint32 CLUSTERS_PER_CAMERA = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+
+		/** \brief Light list of a single cluster, matches uvec2 in std430. */
+		struct Cluster
+		{
+			uint32 offset;	/**< First entry in the light index list. */
+			uint32 count;	/**< Number of lights. */
+		};
+
+		/** \brief What the pixel shader needs to find the cluster of a fragment, std140 compatible. */
+		struct CameraData
+		{
+			math::vec4 viewDepth;	/**< Dot with a world position gives the view space depth. */
+			math::vec4 tile;		/**< Viewport x, y and the tile width and height in pixels. */
+			math::vec4 depth;		/**< Slice scale, slice bias and 1 for logarithmic slices. */
+			int32 grid[4];			/**< Cluster counts on each axis and the first cluster. */
+		};
+
+		LightGrid();
+		~LightGrid();
+
+		/** \brief Rebuilds the clusters of every camera.
+		*
+		*	\param size_t cameraCount : Number of cameras.
+		*	\param CameraComponent* cameras[] : The cameras, their view must be up to date.
+		*	\param size_t lightCount : Number of point lights.
+		*	\param const PointLight lights[] : Point lights in world space.
+		*/
+		void build(size_t cameraCount, CameraComponent* cameras[], size_t lightCount, const PointLight lights[]);
+
+		const std::vector<Cluster>& getClusters() const
+		{
+			return clusters;
+		}
+
+		const std::vector<uint32>& getLightIndices() const
+		{
+			return lightIndices;
+		}
+
+		const CameraData& getCameraData(size_t camera) const
+		{
+			return cameraData[camera];
+		}
+
+		/** \brief Distance where the light's attenuation drops below 1/256 of its brightest channel. */
+		static float getLightRadius(const PointLight& light);
+
+	private:
+		void buildCamera(size_t camera, CameraComponent* component, size_t lightCount, const PointLight lights[]);
+
+		std::vector<Cluster> clusters;
+		std::vector<uint32> lightIndices;
+		std::vector<CameraData> cameraData;
+
+		// Scratch data reused between frames.
+		std::vector<float> radii;
+		std::vector<AABB> clusterBounds;
+		std::vector<uint32> pairs;
+	};
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Renderer/Enumerations.h"
+#include "Core/Types.h"
+
+namespace sge
+{
+	class GraphicsDevice;
+	class Mesh;
+	class TextureResource;
+
+	struct Buffer;
+	struct Texture;
+
+	/** \brief Packs the textures of meshes into texture arrays and lists the layers every mesh samples.
+	*
+	*	Textures with the same size, format and levels share an array, which grows as textures are added.
+	*	The layers of each material are kept in a storage buffer that the shaders index with the material
+	*	of the draw, so meshes whose textures share arrays are drawn without binding textures in between.
+	*/
+	class MaterialTable
+	{
+	public:
+		struct Material
+		{
+			Texture* arrays[3];		// Arrays of the diffuse, normal and specular texture, null for the ones the mesh lacks.
+			uint32 index;			// Entry of the material in the storage buffer.
+			const unsigned char* pixels[3];		// The layers of the textures are shared by their pixels.
+		};
+
+		MaterialTable(GraphicsDevice* device);
+		~MaterialTable();
+
+		/** \brief Adds the textures of a mesh to the arrays, must be called on the thread owning the device.
+		*
+		*	\return Returns false when a texture of the mesh wasn't created from a resource, the mesh then binds its own textures.
+		*/
+		bool add(const Mesh* mesh);
+
+		/** \brief Forgets a mesh before it is deleted, its layers and material are reused once no other mesh has them. */
+		void remove(const Mesh* mesh);
+
+		/** \brief True for the meshes added before, whether they got a material or not. */
+		bool contains(const Mesh* mesh) const;
+
+		/** \brief The material of a mesh, nullptr when it has none. */
+		const Material* find(const Mesh* mesh) const;
+
+		/** \brief The layers of every material as an ivec4 of diffuse, normal and specular layer. */
+		Buffer* getBuffer() const { return buffer; }
+
+		size_t getArrayCount() const { return arrays.size(); }
+
+	private:
+		struct TextureArray
+		{
+			Texture* texture;
+			size_t width;
+			size_t height;
+			size_t levels;
+			Format format;
+			size_t layers;
+			size_t capacity;
+			std::vector<int32> freeLayers;		// Layers of removed textures, filled before the array grows.
+		};
+
+		struct Layer
+		{
+			Texture* array;
+			int32 layer;
+			size_t references;
+		};
+
+		Layer addTexture(TextureResource* source);
+		void removeTexture(const unsigned char* pixels);
+
+		GraphicsDevice* device;
+		Buffer* buffer;
+		std::vector<TextureArray> arrays;
+		std::unordered_map<const unsigned char*, Layer> layers;		// Meshes loading the same file share the pixels.
+		std::unordered_map<const Mesh*, Material> materials;
+		std::unordered_set<const Mesh*> rejected;
+		std::vector<int32> materialData;
+		std::vector<uint32> freeMaterials;
+	};
+}
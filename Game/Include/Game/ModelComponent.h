@@ -41,6 +41,16 @@ namespace sge
 
 		void setCubeMap(CubeMap* cube);
 
+		/** \brief Marks whether the model uses the scene lights.
+		*
+		*	In the deferred render path lit models are drawn into the G-buffer with the
+		*	renderer's own pipeline, unlit ones (sky boxes, emissive objects) are drawn
+		*	with their own pipeline after lighting. Models are lit by default.
+		*/
+		void setLit(bool lit) { this->lit = lit; }
+
+		bool isLit() { return lit; }
+
 	private:
 		
 		CubeMap* myCube;
@@ -48,5 +58,6 @@ namespace sge
 		Pipeline* pipeline;
 		float shininess;
 		float glossyness;
+		bool lit;
 	};
 }
\ No newline at end of file
@@ -1,22 +1,31 @@
 #pragma once
 
+#include <condition_variable>
 #include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
+#include "Core/Bounds.h"
 #include "Core/Math.h"
+#include "Renderer/CommandList.h"
 #include "Renderer/GraphicsDevice.h"
+#include "Renderer/IndirectCommand.h"
 #include "Renderer/RenderQueue.h"
 
 #include "Game/LightComponent.h"
+#include "Game/LightGrid.h"
 #include "Game/PointLightComponent.h"
 #include "Game/DirLightComponent.h"
 #include "Game/SpotLightComponent.h"
 
 namespace sge
 {
-    const int MAX_DIR_LIGHTS = 10;
-    const int MAX_POINT_LIGHTS = 40;
 	class Window;
     class RenderComponent;
     class SpriteComponent;
@@ -24,8 +33,16 @@ namespace sge
     class TextComponent;
     class CameraComponent;
     class Entity;
+    class SpatialSystem;
+    class BoundsComponent;
+    class Mesh;
+    class ModelResource;
+    class TextureStreamer;
+    class TextureManager;
+    class MaterialTable;
     struct Pipeline;
     struct Buffer;
+    struct Query;
     struct Shader;
 
     struct Character
@@ -37,6 +54,28 @@ namespace sge
 		sge::math::vec2 advance;
     };
 
+    enum class RenderPath
+    {
+        FORWARD,
+        DEFERRED
+    };
+
+    // Counters of a rendered frame, for comparing render settings.
+    struct RenderStats
+    {
+        size_t drawCalls;           // Mesh draws of the main pass.
+        size_t depthDrawCalls;      // Mesh draws of the depth pre-pass.
+        size_t indirectCalls;       // Multi-draw calls the depth pre-pass was submitted with.
+        size_t occludedModels;      // Model draws skipped by occlusion culling.
+        size_t occlusionQueries;    // Bounding boxes tested by occlusion culling.
+        size_t textureBinds;        // Textures and cube maps bound for the main pass.
+        uint64 samples;             // Samples that passed the depth test in the main pass.
+        uint64 pixels;              // Pixels covered by the camera viewports.
+
+        // Average number of times a pixel was shaded, scaled by the sample count when multisampling.
+        float getOverdraw() const { return pixels ? static_cast<float>(samples) / pixels : 0.0f; }
+    };
+
     enum Clear
     {
         QUEUE           = 0x01,
@@ -63,6 +102,9 @@ namespace sge
 
 		GraphicsDevice* getDevice() const { return device; }
 
+        // Directory the linked shader programs are cached in, set before init. Programs aren't cached without one.
+        void setProgramCache(const std::string& directory) { programCache = directory; }
+
         // TODO should we take in entities or components? 
         void renderSprites(size_t count, Entity* sprites[]);
         void renderTexts(size_t count, Entity* texts[]);
@@ -72,6 +114,89 @@ namespace sge
         void addCameras(size_t count, Entity* cameras[]);
         void setRenderTarget(RenderTarget* renderTarget);
 
+        // Deferred rendering draws lit models into a G-buffer, accumulates the lights per
+        // camera viewport and composites the result over the current render target.
+        // Unlit models, sprites and texts are drawn forward on top. OpenGL 4 only.
+        void setRenderPath(RenderPath path);
+        RenderPath getRenderPath() const { return renderPath; }
+
+        // The depth pre-pass draws lit models with a position only stream and no color
+        // writes first, then the main pass shades them with an equal depth test, so every
+        // pixel is shaded once. Lit models must compute their position like VertexShaderDepth.glsl.
+        void setDepthPrePass(bool enabled);
+        bool getDepthPrePass() const { return depthPrePass; }
+
+        // With indirect draws the depth pre-pass of every lit model goes out as one multi-draw
+        // call per camera and vertex format. The positions of a mesh are copied into shared static
+        // buffers the first time it's drawn, the draw arguments and matrices are uploaded once per
+        // pass. Needs GL_ARB_shader_draw_parameters, OpenGL 4 only.
+        void setIndirectDraws(bool enabled);
+        bool getIndirectDraws() const { return indirectDraws; }
+
+        // GPU culling moves the frustum test of the indirect draws into a compute shader, which
+        // writes their arguments in place. The draw data is then uploaded once for every camera,
+        // culled draws keep their slot with no instances and still count as depth draws in the
+        // stats. Only used with indirect draws, which then ignore occlusion culling.
+        void setGpuCulling(bool enabled);
+        bool getGpuCulling() const { return gpuCulling; }
+
+        // With texture arrays the textures of lit meshes are copied into arrays of textures with the
+        // same size and format, and a storage buffer lists the layers of every mesh. Meshes sharing
+        // arrays then draw without binding textures in between, the arrays are bound once per model.
+        // Textures in arrays stay at full detail outside of the texture budget. OpenGL 4 only.
+        void setTextureArrays(bool enabled);
+        bool getTextureArrays() const { return textureArrays; }
+
+        // Occlusion culling tests the bounding box of every model with a BoundsComponent
+        // against the depth buffer after the main pass. A model whose box was hidden for
+        // a few frames in a row is skipped, the query results are read a frame late.
+        void setOcclusionCulling(bool enabled);
+        bool getOcclusionCulling() const { return occlusionCulling; }
+
+        // With record threads the model draws are recorded into command lists by that many
+        // threads before every pass, the render thread replays them in queue order. Zero
+        // records every model straight to the device while the queue is rendered.
+        void setRecordThreads(size_t count);
+        size_t getRecordThreads() const { return recordThreads; }
+
+        // A pipelined renderer submits on a render thread of its own. The frame is recorded into
+        // a frame packet with every draw's data copied in, present() hands it over and returns,
+        // so the caller simulates and records the next frame while this one is submitted. The
+        // device may then only be used through runOnDevice. The render thread never reads GPU
+        // results back, so occlusion culling is unavailable and no samples are counted.
+        void setPipelined(bool enabled);
+        bool isPipelined() const { return pipelined; }
+
+        // Runs code that uses the device directly, on the render thread when pipelined. Returns
+        // once it has run, after any frame packet handed over before it.
+        void runOnDevice(const std::function<void()>& function);
+
+        // A streamed texture is returned at once holding a placeholder color. A worker thread decodes
+        // the file into staging memory and present() copies finished textures into place, at most the
+        // upload budget of bytes per frame so streaming doesn't stall frames. A texture larger than the
+        // budget takes a frame of its own. OpenGL 4 only.
+        Texture* streamTexture(const std::string& path);
+        // Streamed textures are deleted through this, so the worker doesn't write into a deleted texture.
+        void deleteStreamedTexture(Texture* texture);
+        void setTextureUploadBudget(size_t bytes) { textureUploadBudget = bytes; }
+        size_t getTextureUploadBudget() const { return textureUploadBudget; }
+
+        // Keeps the model textures within a budget of video memory. Each texture keeps the mip levels
+        // its size on screen needs, the ones unused the longest fall back to their small levels when
+        // the budget runs out. Restored levels count against the upload budget. 0 keeps every level.
+        void setTextureBudget(size_t bytes);
+        size_t getTextureBudget() const;
+
+        // Bytes of the managed textures in video memory, 0 without a texture budget.
+        size_t getTextureMemory() const;
+
+        // Stats of the last frame whose GPU results are ready, usually the previous one.
+        const RenderStats& getStats() const { return stats; }
+
+        // When set, renderModels skips models whose bounds are outside of every camera.
+        // Models without a BoundsComponent are always rendered.
+        void setSpatialSystem(SpatialSystem* spatialSystem);
+
 		void begin();
 		void end();
         void render();
@@ -92,10 +217,50 @@ namespace sge
         void initSpriteRendering();
         void initTextRendering();
         void initModelRendering();
+        void initDeferredRendering();
+        void initDepthRendering();
+        void initOcclusionCulling();
+        void initIndirectRendering();
+        void initGpuCulling();
+
+        void renderDeferred();
+        void renderDepthPrePass();
+        void renderIndirectDepth();
+        void buildIndirectDraws();
+        void buildCulledDraws();
+        void addStaticMesh(Mesh* mesh);
+        void renderQueue();
+        void renderMainQueue();
+        bool isInCurrentPass(bool lit) const;
+        Pipeline* getModelPipeline(ModelComponent* model) const;
+        uint32 getMaterialFeatures(ModelComponent* model, const Mesh* mesh) const;
+        Pipeline* getPipelineVariant(Pipeline* pipeline, uint32 features) const;
+        void createPipelineVariants(ModelComponent* model);
+        void useTextures(ModelComponent* model);
+        void addMaterials(ModelComponent* model);
+        void releaseModel(ModelResource* model);
+        void runRenderThread();
+        void recordModelDraws();
+        void submitModelDraw(size_t index);
+
+        // Target is the GraphicsDevice or a CommandList, the draw only reads shared state.
+        template <typename Target>
+        void recordModel(Target* target, ModelComponent* model, size_t pass, RenderStats& stats) const;
+        template <typename Target>
+        void recordModelDepth(Target* target, ModelComponent* model, size_t pass, RenderStats& stats) const;
+
+        void renderOcclusionQueries();
+        bool isOccluded(ModelComponent* model, CameraComponent* camera) const;
+        void releaseOcclusionQueries(bool all);
+        void collectStats();
 
         void calculateLightData();
+        void calculateLightGrid();
+        void calculateVisibility();
+        void copyStorageData(Buffer* buffer, size_t slot, size_t size, const void* data);
 		
 		RenderQueue queue;
+        Window& window;
         GraphicsDevice* device;
         math::vec4 clearColor;
 
@@ -132,6 +297,12 @@ namespace sge
         Buffer* modelVertexUniformBuffer;
         Buffer* modelPixelUniformBuffer;
 
+        // Light data shared by every model, read by the pixel shader from storage buffers.
+        Buffer* dirLightBuffer;
+        Buffer* pointLightBuffer;
+        Buffer* clusterBuffer;
+        Buffer* lightIndexBuffer;
+
 #ifdef DIRECTX11
         __declspec(align(16))
 #endif
@@ -140,6 +311,13 @@ namespace sge
             sge::math::mat4 PV;
             sge::math::mat4 M;
 			float shininess;
+            float pad[3];
+            // Decodes the positions of packed meshes, identity otherwise.
+            sge::math::vec4 positionScale;
+            sge::math::vec4 positionOffset;
+            int32 packedVertices;
+            int32 material;             // Entry of the mesh in the material table.
+            int32 pad2[2];
         } modelVertexUniformData;
 
 #ifdef DIRECTX11
@@ -147,20 +325,198 @@ namespace sge
 #endif
         struct ModelPixelUniformData
         {
-            DirLight dirLights[MAX_DIR_LIGHTS];
-            PointLight pointLights[MAX_POINT_LIGHTS];
             sge::math::vec4 CamPos;
-            float numofpl;
+            LightGrid::CameraData cluster;
 			float numofdl;
-			float numofsl;
 			float glossyness;
-			int hasDiffuseTex;
-			int hasNormalTex;
-			int hasSpecularTex;
-			int hasCubeTex;
-			float pad;
+			float pad[2];
         } modelPixelUniformData;
 
+        // Permutations of the lit model pipelines, by pipeline and material features. Variants are
+        // created on the main thread before recording, so recording threads only read the map.
+        std::map<std::pair<Pipeline*, uint32>, Pipeline*> pipelineVariants;
+
+        // Deferred rendering data.
+        enum class DeferredPass
+        {
+            GEOMETRY,
+            FORWARD
+        };
+
+        RenderPath renderPath;
+        DeferredPass deferredPass;
+        RenderTarget* renderTarget;
+        RenderTarget* gBuffer;
+        RenderTarget* lightBuffer;
+        Pipeline* gBufferPipeline;
+        Pipeline* gBufferPackedPipeline;
+        Pipeline* deferredLightPipeline;
+        Pipeline* compositePipeline;
+        Shader* gBufferVertexShader;
+        Shader* gBufferPixelShader;
+        Shader* fullscreenVertexShader;
+        Shader* deferredLightPixelShader;
+        Shader* compositePixelShader;
+        Buffer* deferredPixelUniformBuffer;
+
+#ifdef DIRECTX11
+        __declspec(align(16))
+#endif
+        struct DeferredPixelUniformData
+        {
+            sge::math::mat4 inverseViewProj;
+            sge::math::vec4 viewport;
+            sge::math::vec4 CamPos;
+            LightGrid::CameraData cluster;
+            float numofdl;
+            float pad[3];
+        } deferredPixelUniformData;
+
+        // Depth pre-pass data.
+        bool depthPrePass;
+        bool depthPass;
+        Pipeline* depthPipeline;
+        Pipeline* depthPackedPipeline;
+        Shader* depthVertexShader;
+        Shader* depthPixelShader;
+
+        // Indirect depth pre-pass data. Mesh positions are appended to static blocks of one
+        // vertex format and never move, a batch is a range of draws using the same block.
+        struct StaticBlock
+        {
+            Buffer* buffer;
+            bool packed;
+            uint32 capacity;    // In vertices.
+            uint32 count;
+        };
+
+        struct IndirectDraw
+        {
+            int32 block;
+            DrawIndirectCommand command;
+        };
+
+        struct IndirectBatch
+        {
+            size_t camera;
+            int32 block;
+            size_t first;       // First draw in the indirect buffer.
+            size_t count;
+        };
+
+        // Read by VertexShaderDepthIndirect.glsl at the base instance of the draw.
+        struct IndirectDrawData
+        {
+            sge::math::mat4 M;
+            sge::math::vec4 positionScale;
+            sge::math::vec4 positionOffset;
+        };
+
+        // A draw tested by ComputeShaderCulling.glsl, with the bounds of its mesh.
+        struct CullInstance
+        {
+            sge::math::vec4 center;
+            sge::math::vec4 extents;
+            DrawIndirectCommand command;
+        };
+
+        bool indirectDraws;
+        Pipeline* indirectDepthPipeline;
+        Pipeline* indirectDepthPackedPipeline;
+        Shader* indirectDepthVertexShader;
+        Buffer* indirectBuffer;
+        Buffer* drawDataBuffer;
+        std::vector<StaticBlock> staticBlocks;
+        std::vector<ModelComponent*> indirectModels;
+        std::vector<IndirectDraw> passDraws;
+        std::vector<IndirectBatch> indirectBatches;
+        std::vector<DrawIndirectCommand> drawCommands;
+        std::vector<IndirectDrawData> drawData;
+
+        // Texture array data, the table is created when the arrays are first enabled.
+        bool textureArrays;
+        MaterialTable* materialTable;
+
+        // GPU culling data.
+        bool gpuCulling;
+        Pipeline* cullPipeline;
+        Shader* cullShader;
+        Buffer* cullInstanceBuffer;
+        Buffer* frustumBuffer;
+        std::vector<CullInstance> cullInstances;
+        std::vector<AABB> drawBounds;
+        std::vector<Frustum> frustums;
+
+        // Occlusion culling data, kept separately for every camera.
+        struct OcclusionCandidate
+        {
+            ModelComponent* model;
+            BoundsComponent* bounds;
+        };
+
+        struct OcclusionState
+        {
+            Query* query;
+            bool pending;       // The query hasn't been read back yet.
+            bool visible;
+            uint32 hiddenCount; // Consecutive results where the box was hidden.
+            uint64 lastFrame;   // Frame the model was last tested in.
+        };
+
+        bool occlusionCulling;
+        Buffer* boxVertexBuffer;
+        Pipeline* occlusionPipeline;
+        std::vector<OcclusionCandidate> occlusionCandidates;
+        std::unordered_map<CameraComponent*, std::unordered_map<ModelComponent*, OcclusionState>> occlusionStates;
+        uint64 frameIndex;
+
+        // Command list recording data.
+        struct ModelDraw
+        {
+            ModelComponent* model;
+            size_t camera;
+            size_t list;        // Command list the draw was recorded into.
+            size_t begin;       // Range of the draw in the list.
+            size_t end;
+        };
+
+        size_t recordThreads;
+        std::vector<ModelDraw> modelDraws;
+        std::vector<CommandList> commandLists;
+        std::vector<RenderStats> recordStats;
+
+        // Render thread data. Per frame calls go through commands, which passes them straight
+        // to the device or records them into the frame packet when pipelined.
+        CommandList immediateCommands;
+        CommandList framePackets[2];
+        CommandList* commands;
+        size_t recordedPacket;
+        CommandList* submittedPacket;                   // Handed to the render thread, null once swapped.
+        const std::function<void()>* renderJob;
+        bool renderThreadQuit;
+        bool pipelined;
+        std::thread renderThread;
+        std::mutex renderMutex;
+        std::condition_variable renderCondition;
+
+        // Texture streaming data, the streamer is created with the first streamed texture.
+        TextureStreamer* textureStreamer;
+        size_t textureUploadBudget;
+
+        // Created by the first texture budget.
+        TextureManager* textureManager;
+
+        // Drops the meshes of the models the ResourceManager deletes from the renderer and deletes their buffers.
+        size_t unloadCallback;
+
+        // Stats are counted on the CPU and the sample counts read back a frame late.
+        RenderStats stats;
+        RenderStats frameStats;
+        RenderStats pendingStats;
+        std::vector<Query*> frameQueries;
+        std::vector<Query*> pendingQueries;
+        std::vector<Query*> freeQueries;
+
         // Text rendering data.
         std::vector<sge::Texture*> charTextures; // TODO who deletes these?
         std::vector<Character> characters;
@@ -172,7 +528,18 @@ namespace sge
         std::vector<DirLightComponent*> dirLights;
         std::vector<PointLightComponent*> pointLights;
 
+        // Light data gathered in end().
+        std::vector<DirLight> dirLightData;
+        std::vector<PointLight> pointLightData;
+        LightGrid lightGrid;
+
+        // Culling data.
+        SpatialSystem* spatialSystem;
+        std::unordered_set<Entity*> visibleEntities;
+        bool visibilityValid;
+
         bool initialized;
         bool acceptingCommands;
+        std::string programCache;
 	};
 }
\ No newline at end of file
@@ -25,6 +25,12 @@ namespace sge
 		void pop();
 		void change(Scene* scene);
 		void handleScenes();
+
+		/** \brief True when handleScenes has a push, pop or change to carry out. */
+		bool hasPendingAction() const
+		{
+			return sceneAction != NONE;
+		}
 	private:
 		std::vector<Scene*> scenes;
 
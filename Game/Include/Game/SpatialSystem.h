@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+
+#include "Game/System.h"
+#include "Game/BoundsComponent.h"
+#include "Game/DynamicAABBTree.h"
+
+namespace sge
+{
+	class CameraComponent;
+
+	/** \brief Keeps a DynamicAABBTree of all BoundsComponents up to date.
+	*
+	*	The user data of every proxy is the Entity owning the BoundsComponent,
+	*	so query results can be handed straight to RenderSystem or gameplay code.
+	*/
+	class SpatialSystem : public System
+	{
+	public:
+		/** \brief The constructor.
+		*
+		* \param float margin : How much the proxies are enlarged, see DynamicAABBTree.
+		*/
+		SpatialSystem(float margin = 0.1f);
+		~SpatialSystem();
+
+		/** \brief Function for updating the System.
+		*
+		* Refits the proxies of the components whose transform or local bounds
+		* have changed since the previous update.
+		*/
+		void update();
+
+		/** \brief Function for adding Components.
+		*
+		* Inserts a proxy for the BoundsComponent into the tree.
+		* \param Component* comp : Pointer to a BoundsComponent.
+		*/
+		void addComponent(Component* comp);
+
+		/** \brief Removes the proxy of a BoundsComponent from the tree. */
+		void removeComponent(BoundsComponent* comp);
+
+		void queryFrustum(const Frustum& frustum, std::vector<Entity*>& results) const;
+		void queryCameras(size_t count, CameraComponent* cameras[], std::vector<Entity*> results[]) const;
+		void querySphere(const Sphere& sphere, std::vector<Entity*>& results) const;
+
+		/** \brief Finds the Entities hit by a ray, nearest first. */
+		void queryRay(const Ray& ray, std::vector<RayHit>& results) const;
+
+		const DynamicAABBTree& getTree() const
+		{
+			return tree;
+		}
+
+		/** \brief Number of proxies reinserted during the latest update. */
+		size_t getReinsertCount() const
+		{
+			return reinsertCount;
+		}
+
+	private:
+		DynamicAABBTree tree;
+		std::vector<BoundsComponent*> comps; /**< Vector containing BoundsComponent pointers. */
+		size_t reinsertCount;
+	};
+}
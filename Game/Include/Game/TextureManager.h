@@ -0,0 +1,74 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "Core/Types.h"
+
+namespace sge
+{
+	class CommandList;
+	class TextureResource;
+
+	struct Texture;
+
+	/** \brief Keeps the textures of the models within a budget of video memory by dropping and restoring mip levels.
+	*
+	*	Every frame the renderer reports the textures it draws and how large they are on screen. A texture
+	*	keeps the levels its screen size needs, textures that haven't been drawn for the longest time fall
+	*	back to their small levels first when the budget runs out. Dropped levels are restored from the
+	*	pixels of the resource, which stay in memory, at most the upload budget of bytes per frame.
+	*/
+	class TextureManager
+	{
+	public:
+		TextureManager();
+
+		/** \brief Bytes of video memory the managed textures may take, 0 keeps every level resident. */
+		void setBudget(size_t bytes) { budget = bytes; }
+		size_t getBudget() const { return budget; }
+
+		/** \brief Bytes of the levels currently in video memory. */
+		size_t getResidentSize() const { return residentSize; }
+
+		/** \brief Marks a texture drawn this frame, it is managed from its first use.
+		*
+		*	\param TextureResource* source : The pixels the texture was created from, they have to outlive the texture.
+		*	\param float screenSize : Size of the object using the texture in pixels.
+		*/
+		void use(Texture* texture, TextureResource* source, float screenSize);
+
+		/** \brief Stops managing a texture, call it before the texture is deleted. */
+		void remove(Texture* texture);
+
+		/** \brief Changes the resident levels for the next frame, restoring at most uploadBudget bytes but always one level. */
+		void update(CommandList* commands, size_t uploadBudget);
+
+	private:
+		struct Entry
+		{
+			Texture* texture;
+			TextureResource* source;
+			std::vector<size_t> sizes;				// Bytes of every level.
+			std::vector<unsigned char> mips;		// Levels after the first of an uncooked texture, made on the first restore.
+			std::vector<const unsigned char*> levels;	// Pixels of every level, set with mips.
+			size_t firstLevel;						// Levels before it are dropped.
+			size_t fallbackLevel;					// Largest level that is still small, kept when evicted.
+			size_t targetLevel;
+			uint64 lastUsed;
+			float screenSize;
+		};
+
+		size_t getSize(const Entry& entry, size_t firstLevel) const;
+		size_t getWantedLevel(const Entry& entry) const;
+		void createLevels(Entry& entry);
+		void setLevels(CommandList* commands, Entry& entry, size_t firstLevel);
+
+		std::unordered_map<Texture*, Entry> entries;
+		std::vector<Entry*> candidates;
+		std::vector<const unsigned char*> restoredLevels;
+		size_t budget;
+		size_t residentSize;
+		uint64 frame;
+	};
+}
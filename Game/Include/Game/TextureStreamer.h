@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Core/Types.h"
+
+namespace sge
+{
+	class GraphicsDevice;
+
+	struct Texture;
+
+	/** \brief Decodes streamed textures on a worker thread straight into the staging memory of the device.
+	*
+	*	The textures are created up front and hold a placeholder color. The worker decodes the
+	*	image file, waits for staging memory and copies the pixels there, the device thread later
+	*	moves them into the texture with GraphicsDevice::streamTextures. Files are decoded in the
+	*	order they were queued.
+	*/
+	class TextureStreamer
+	{
+	public:
+		TextureStreamer(GraphicsDevice* device);
+		~TextureStreamer();
+
+		/** \brief Reads the size of an image from its header without decoding it.
+		*
+		*	\return Returns false when the file isn't an image stb_image can read.
+		*/
+		static bool readSize(const std::string& path, size_t& width, size_t& height);
+
+		/** \brief Queues the decode of an RGBA image into a texture made by GraphicsDevice::createStreamedTexture. */
+		void stream(Texture* texture, const std::string& path);
+
+		/** \brief Drops the queued files of a texture, must be called before the texture is deleted.
+		*
+		*	A file of the texture being decoded isn't handed to the device anymore. When it already was,
+		*	GraphicsDevice::deleteTexture skips the copy.
+		*/
+		void cancel(Texture* texture);
+
+		/** \brief Number of queued files not yet handed to the device. */
+		size_t getPending();
+
+		/** \brief Drops the queued files and joins the worker, the texture being decoded is finished first. */
+		void stop();
+
+	private:
+		struct Request
+		{
+			Texture* texture;
+			std::string path;
+		};
+
+		void run();
+
+		GraphicsDevice* device;
+
+		std::thread thread;
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<Request> requests;
+		Texture* current;	// Texture of the file being decoded, cleared when cancelled.
+		size_t pending;
+		bool quit;
+	};
+}
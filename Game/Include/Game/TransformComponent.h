@@ -1,6 +1,7 @@
 #pragma once
 #include "Game/Component.h"
 #include "Core/Math.h"
+#include "Core/Types.h"
 
 namespace sge
 {
@@ -15,46 +16,55 @@ namespace sge
 		void setPosition(const math::vec3& p)
 		{
 			position = p;
+			version++;
 		}
 
         void addPosition(const math::vec3& p)
         {
             position += p;
+            version++;
         }
 
         void addAngle(float a)
         {
             angle += a;
+            version++;
         }
 
 		void setScale(const math::vec3& s)
 		{
 			scale = s;
+			version++;
 		}
 
 		void setRotationVector(const math::vec3& rv)
 		{
 			rotationVector = rv;
+			version++;
 		}
 
         void setFront(const math::vec3& f)
         {
             front = f;
+            version++;
         }
 
         void setUp(const math::vec3& u)
         {
             up = u;
+            version++;
         }
 
         void setLeft(const math::vec3& l)
         {
             left = l;
+            version++;
         }
 
 		void setAngle(float a)
 		{
 			angle = a;
+			version++;
 		}
 
 		const math::vec3& getPosition()
@@ -100,10 +110,22 @@ namespace sge
 				math::scale(math::mat4(1.0f), scale);
 		}
 
+        /** \brief Getter function for the change counter.
+        *
+        * The counter is increased by every setter, so systems can cache
+        * data derived from the transform and compare versions to detect changes.
+        * \return The current version.
+        */
+        uint32 getVersion()
+        {
+            return version;
+        }
+
         void lookAt(const math::vec3& target)
         {
             front = math::normalize(target - position);
             up = math::cross(front, left);
+            version++;
         }
 
 	private:
@@ -115,6 +137,7 @@ namespace sge
         math::vec3 left;
 
 		float angle;
+        uint32 version;
 	};
 
 }
\ No newline at end of file
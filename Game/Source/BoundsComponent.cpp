@@ -0,0 +1,42 @@
+#include "Game/BoundsComponent.h"
+#include "Game/SpatialSystem.h"
+#include "Game/TransformComponent.h"
+#include "Game/DynamicAABBTree.h"
+#include "Game/Entity.h"
+#include "Core/Assert.h"
+
+namespace sge
+{
+	BoundsComponent::BoundsComponent(Entity* ent) :
+		Component(ent),
+		localBounds(math::vec3(-0.5f), math::vec3(0.5f)),
+		system(nullptr),
+		proxy(DynamicAABBTree::NULL_NODE),
+		version(0),
+		boundsChanged(true)
+	{
+		transform = getParent()->getComponent<TransformComponent>();
+
+		SGE_ASSERT(transform);
+
+		worldBounds = localBounds.transform(transform->getMatrix());
+	}
+
+	BoundsComponent::~BoundsComponent()
+	{
+		if (system)
+		{
+			system->removeComponent(this);
+		}
+	}
+
+	void BoundsComponent::update()
+	{
+	}
+
+	void BoundsComponent::setLocalBounds(const AABB& bounds)
+	{
+		localBounds = bounds;
+		boundsChanged = true;
+	}
+}
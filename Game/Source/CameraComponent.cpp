@@ -12,7 +12,11 @@ namespace sge
 		Component(ent),
         viewport({ 0, 0, 0, 0 }),
         viewProj(0.0f),
+        view(1.0f),
         proj(0.0f),
+        nearPlane(0.0f),
+        farPlane(0.0f),
+        perspective(false),
         transform(nullptr)
 	{
 		transform = getParent()->getComponent<TransformComponent>();
@@ -23,11 +27,19 @@ namespace sge
     void CameraComponent::setPerspective(float fov, float aspectRatio, float near, float far)
     {
         proj = math::perspective(math::radians(fov), aspectRatio, near, far);
+
+        nearPlane = near;
+        farPlane = far;
+        perspective = true;
     }
 
     void CameraComponent::setOrtho(float left, float right, float bottom, float top, float near, float far)
     {
         proj = math::ortho(left, right, bottom, top, near, far);
+
+        nearPlane = near;
+        farPlane = far;
+        perspective = false;
     }
 
     void CameraComponent::setViewport(int x, int y, unsigned int width, unsigned int height)
@@ -50,9 +62,11 @@ namespace sge
 
     void CameraComponent::updateView()
     {
-        viewProj = proj * sge::math::lookAt(
+        view = sge::math::lookAt(
             transform->getPosition(), 
             transform->getPosition() + transform->getFront(), 
             transform->getUp());
+
+        viewProj = proj * view;
     }
 }
\ No newline at end of file
@@ -0,0 +1,741 @@
+#include <algorithm>
+
+#include "Game/DynamicAABBTree.h"
+#include "Core/Assert.h"
+
+namespace sge
+{
+	const int32 DynamicAABBTree::NULL_NODE;
+	const size_t DynamicAABBTree::MAX_BATCH;
+	const size_t DynamicAABBTree::STACK_SIZE;
+
+	// Predicted movement is multiplied by this when fattening a moving leaf.
+	static const float DISPLACEMENT_MULTIPLIER = 2.0f;
+
+	DynamicAABBTree::DynamicAABBTree(float margin) :
+		root(NULL_NODE),
+		freeList(NULL_NODE),
+		proxyCount(0),
+		margin(margin)
+	{
+		nodes.reserve(64);
+	}
+
+	DynamicAABBTree::~DynamicAABBTree()
+	{
+	}
+
+	int32 DynamicAABBTree::allocateNode()
+	{
+		int32 index;
+
+		if (freeList != NULL_NODE)
+		{
+			index = freeList;
+			freeList = nodes[index].next;
+		}
+		else
+		{
+			index = static_cast<int32>(nodes.size());
+			nodes.push_back(Node());
+		}
+
+		Node& node = nodes[index];
+		node.parent = NULL_NODE;
+		node.child1 = NULL_NODE;
+		node.child2 = NULL_NODE;
+		node.height = 0;
+		node.userData = nullptr;
+
+		return index;
+	}
+
+	void DynamicAABBTree::freeNode(int32 index)
+	{
+		SGE_ASSERT(index >= 0 && index < static_cast<int32>(nodes.size()));
+
+		nodes[index].next = freeList;
+		nodes[index].height = -1;
+		freeList = index;
+	}
+
+	int32 DynamicAABBTree::createProxy(const AABB& aabb, void* userData)
+	{
+		int32 proxy = allocateNode();
+
+		math::vec3 r(margin);
+
+		nodes[proxy].aabb = AABB(aabb.min - r, aabb.max + r);
+		nodes[proxy].userData = userData;
+		nodes[proxy].height = 0;
+
+		insertLeaf(proxy);
+
+		proxyCount++;
+
+		return proxy;
+	}
+
+	void DynamicAABBTree::destroyProxy(int32 proxy)
+	{
+		SGE_ASSERT(nodes[proxy].isLeaf());
+
+		removeLeaf(proxy);
+		freeNode(proxy);
+
+		proxyCount--;
+	}
+
+	bool DynamicAABBTree::moveProxy(int32 proxy, const AABB& aabb, const math::vec3& displacement)
+	{
+		SGE_ASSERT(nodes[proxy].isLeaf());
+
+		if (nodes[proxy].aabb.contains(aabb))
+		{
+			return false;
+		}
+
+		removeLeaf(proxy);
+
+		// Extend the box by the margin and towards the direction of movement.
+		math::vec3 r(margin);
+		AABB fat(aabb.min - r, aabb.max + r);
+		math::vec3 d = displacement * DISPLACEMENT_MULTIPLIER;
+
+		fat.min += math::min(d, math::vec3(0.0f));
+		fat.max += math::max(d, math::vec3(0.0f));
+
+		nodes[proxy].aabb = fat;
+
+		insertLeaf(proxy);
+
+		return true;
+	}
+
+	int32 DynamicAABBTree::getHeight() const
+	{
+		return root == NULL_NODE ? 0 : nodes[root].height;
+	}
+
+	void DynamicAABBTree::insertLeaf(int32 leaf)
+	{
+		if (root == NULL_NODE)
+		{
+			root = leaf;
+			nodes[root].parent = NULL_NODE;
+			return;
+		}
+
+		// Find the best sibling using the surface area heuristic.
+		AABB leafAABB = nodes[leaf].aabb;
+		int32 index = root;
+
+		while (!nodes[index].isLeaf())
+		{
+			int32 child1 = nodes[index].child1;
+			int32 child2 = nodes[index].child2;
+
+			float area = nodes[index].aabb.getSurfaceArea();
+			float combinedArea = AABB::merge(nodes[index].aabb, leafAABB).getSurfaceArea();
+
+			// Cost of creating a new parent for this node and the new leaf.
+			float cost = 2.0f * combinedArea;
+
+			// Minimum cost of pushing the leaf further down the tree.
+			float inheritanceCost = 2.0f * (combinedArea - area);
+
+			float cost1 = AABB::merge(leafAABB, nodes[child1].aabb).getSurfaceArea() + inheritanceCost;
+			float cost2 = AABB::merge(leafAABB, nodes[child2].aabb).getSurfaceArea() + inheritanceCost;
+
+			if (!nodes[child1].isLeaf())
+			{
+				cost1 -= nodes[child1].aabb.getSurfaceArea();
+			}
+
+			if (!nodes[child2].isLeaf())
+			{
+				cost2 -= nodes[child2].aabb.getSurfaceArea();
+			}
+
+			if (cost < cost1 && cost < cost2)
+			{
+				break;
+			}
+
+			index = cost1 < cost2 ? child1 : child2;
+		}
+
+		int32 sibling = index;
+
+		// Create a new parent. Note that allocating may reallocate the node array.
+		int32 oldParent = nodes[sibling].parent;
+		int32 newParent = allocateNode();
+
+		nodes[newParent].parent = oldParent;
+		nodes[newParent].aabb = AABB::merge(leafAABB, nodes[sibling].aabb);
+		nodes[newParent].height = nodes[sibling].height + 1;
+		nodes[newParent].child1 = sibling;
+		nodes[newParent].child2 = leaf;
+
+		nodes[sibling].parent = newParent;
+		nodes[leaf].parent = newParent;
+
+		if (oldParent != NULL_NODE)
+		{
+			if (nodes[oldParent].child1 == sibling)
+			{
+				nodes[oldParent].child1 = newParent;
+			}
+			else
+			{
+				nodes[oldParent].child2 = newParent;
+			}
+		}
+		else
+		{
+			root = newParent;
+		}
+
+		// Walk back up the tree fixing heights and boxes.
+		index = nodes[leaf].parent;
+
+		while (index != NULL_NODE)
+		{
+			index = balance(index);
+
+			Node& node = nodes[index];
+
+			node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+			node.aabb = AABB::merge(nodes[node.child1].aabb, nodes[node.child2].aabb);
+
+			index = node.parent;
+		}
+	}
+
+	void DynamicAABBTree::removeLeaf(int32 leaf)
+	{
+		if (leaf == root)
+		{
+			root = NULL_NODE;
+			return;
+		}
+
+		int32 parent = nodes[leaf].parent;
+		int32 grandParent = nodes[parent].parent;
+		int32 sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+		if (grandParent != NULL_NODE)
+		{
+			// Destroy the parent and connect the sibling to the grand parent.
+			if (nodes[grandParent].child1 == parent)
+			{
+				nodes[grandParent].child1 = sibling;
+			}
+			else
+			{
+				nodes[grandParent].child2 = sibling;
+			}
+
+			nodes[sibling].parent = grandParent;
+			freeNode(parent);
+
+			int32 index = grandParent;
+
+			while (index != NULL_NODE)
+			{
+				index = balance(index);
+
+				Node& node = nodes[index];
+
+				node.aabb = AABB::merge(nodes[node.child1].aabb, nodes[node.child2].aabb);
+				node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+
+				index = node.parent;
+			}
+		}
+		else
+		{
+			root = sibling;
+			nodes[sibling].parent = NULL_NODE;
+			freeNode(parent);
+		}
+	}
+
+	int32 DynamicAABBTree::balance(int32 iA)
+	{
+		SGE_ASSERT(iA != NULL_NODE);
+
+		Node& A = nodes[iA];
+
+		if (A.isLeaf() || A.height < 2)
+		{
+			return iA;
+		}
+
+		int32 iB = A.child1;
+		int32 iC = A.child2;
+
+		Node& B = nodes[iB];
+		Node& C = nodes[iC];
+
+		int32 difference = C.height - B.height;
+
+		// Rotate C up.
+		if (difference > 1)
+		{
+			int32 iF = C.child1;
+			int32 iG = C.child2;
+
+			Node& F = nodes[iF];
+			Node& G = nodes[iG];
+
+			C.child1 = iA;
+			C.parent = A.parent;
+			A.parent = iC;
+
+			if (C.parent != NULL_NODE)
+			{
+				if (nodes[C.parent].child1 == iA)
+				{
+					nodes[C.parent].child1 = iC;
+				}
+				else
+				{
+					nodes[C.parent].child2 = iC;
+				}
+			}
+			else
+			{
+				root = iC;
+			}
+
+			if (F.height > G.height)
+			{
+				C.child2 = iF;
+				A.child2 = iG;
+				G.parent = iA;
+
+				A.aabb = AABB::merge(B.aabb, G.aabb);
+				C.aabb = AABB::merge(A.aabb, F.aabb);
+
+				A.height = 1 + std::max(B.height, G.height);
+				C.height = 1 + std::max(A.height, F.height);
+			}
+			else
+			{
+				C.child2 = iG;
+				A.child2 = iF;
+				F.parent = iA;
+
+				A.aabb = AABB::merge(B.aabb, F.aabb);
+				C.aabb = AABB::merge(A.aabb, G.aabb);
+
+				A.height = 1 + std::max(B.height, F.height);
+				C.height = 1 + std::max(A.height, G.height);
+			}
+
+			return iC;
+		}
+
+		// Rotate B up.
+		if (difference < -1)
+		{
+			int32 iD = B.child1;
+			int32 iE = B.child2;
+
+			Node& D = nodes[iD];
+			Node& E = nodes[iE];
+
+			B.child1 = iA;
+			B.parent = A.parent;
+			A.parent = iB;
+
+			if (B.parent != NULL_NODE)
+			{
+				if (nodes[B.parent].child1 == iA)
+				{
+					nodes[B.parent].child1 = iB;
+				}
+				else
+				{
+					nodes[B.parent].child2 = iB;
+				}
+			}
+			else
+			{
+				root = iB;
+			}
+
+			if (D.height > E.height)
+			{
+				B.child2 = iD;
+				A.child1 = iE;
+				E.parent = iA;
+
+				A.aabb = AABB::merge(C.aabb, E.aabb);
+				B.aabb = AABB::merge(A.aabb, D.aabb);
+
+				A.height = 1 + std::max(C.height, E.height);
+				B.height = 1 + std::max(A.height, D.height);
+			}
+			else
+			{
+				B.child2 = iE;
+				A.child1 = iD;
+				D.parent = iA;
+
+				A.aabb = AABB::merge(C.aabb, D.aabb);
+				B.aabb = AABB::merge(A.aabb, E.aabb);
+
+				A.height = 1 + std::max(C.height, D.height);
+				B.height = 1 + std::max(A.height, E.height);
+			}
+
+			return iB;
+		}
+
+		return iA;
+	}
+
+	void DynamicAABBTree::collectLeaves(int32 node, uint32 mask, std::vector<void*> results[]) const
+	{
+		int32 stack[STACK_SIZE];
+		size_t count = 0;
+
+		stack[count++] = node;
+
+		while (count > 0)
+		{
+			const Node& current = nodes[stack[--count]];
+
+			if (current.isLeaf())
+			{
+				for (uint32 bits = mask, i = 0; bits; bits >>= 1, i++)
+				{
+					if (bits & 1)
+					{
+						results[i].push_back(current.userData);
+					}
+				}
+			}
+			else
+			{
+				SGE_ASSERT(count + 2 <= STACK_SIZE);
+
+				stack[count++] = current.child1;
+				stack[count++] = current.child2;
+			}
+		}
+	}
+
+	void DynamicAABBTree::queryAABB(const AABB& aabb, std::vector<void*>& results) const
+	{
+		if (root == NULL_NODE)
+		{
+			return;
+		}
+
+		int32 stack[STACK_SIZE];
+		size_t count = 0;
+
+		stack[count++] = root;
+
+		while (count > 0)
+		{
+			const Node& node = nodes[stack[--count]];
+
+			if (!node.aabb.overlaps(aabb))
+			{
+				continue;
+			}
+
+			if (node.isLeaf())
+			{
+				results.push_back(node.userData);
+			}
+			else
+			{
+				SGE_ASSERT(count + 2 <= STACK_SIZE);
+
+				stack[count++] = node.child1;
+				stack[count++] = node.child2;
+			}
+		}
+	}
+
+	void DynamicAABBTree::queryFrustum(const Frustum& frustum, std::vector<void*>& results) const
+	{
+		queryFrustums(1, &frustum, &results);
+	}
+
+	void DynamicAABBTree::queryFrustums(size_t count, const Frustum frustums[], std::vector<void*> results[]) const
+	{
+		SGE_ASSERT(count <= MAX_BATCH);
+
+		if (root == NULL_NODE || count == 0)
+		{
+			return;
+		}
+
+		StackEntry stack[STACK_SIZE];
+		size_t size = 0;
+
+		uint32 all = count == MAX_BATCH ? 0xFFFFFFFF : (1u << count) - 1;
+		stack[size++] = { root, all, 0 };
+
+		while (size > 0)
+		{
+			StackEntry entry = stack[--size];
+			const Node& node = nodes[entry.node];
+
+			math::vec3 center = node.aabb.getCenter();
+			math::vec3 extents = node.aabb.getExtents();
+
+			// Classify the node against every frustum that still partially overlaps the parent.
+			for (uint32 bits = entry.partial, i = 0; bits; bits >>= 1, i++)
+			{
+				if (!(bits & 1))
+				{
+					continue;
+				}
+
+				bool inside = true;
+
+				for (int p = 0; p < Frustum::COUNT; p++)
+				{
+					const Plane& plane = frustums[i].planes[p];
+
+					float radius = math::dot(extents, math::abs(plane.normal));
+					float distance = math::dot(plane.normal, center) + plane.distance;
+
+					if (distance < -radius)
+					{
+						entry.partial &= ~(1u << i);
+						inside = false;
+						break;
+					}
+
+					if (distance < radius)
+					{
+						inside = false;
+					}
+				}
+
+				if (inside)
+				{
+					entry.partial &= ~(1u << i);
+					entry.inside |= 1u << i;
+				}
+			}
+
+			// Whole subtrees are accepted without further tests.
+			if (entry.inside)
+			{
+				collectLeaves(entry.node, entry.inside, results);
+			}
+
+			if (!entry.partial)
+			{
+				continue;
+			}
+
+			if (node.isLeaf())
+			{
+				for (uint32 bits = entry.partial, i = 0; bits; bits >>= 1, i++)
+				{
+					if (bits & 1)
+					{
+						results[i].push_back(node.userData);
+					}
+				}
+			}
+			else
+			{
+				SGE_ASSERT(size + 2 <= STACK_SIZE);
+
+				stack[size++] = { node.child1, entry.partial, 0 };
+				stack[size++] = { node.child2, entry.partial, 0 };
+			}
+		}
+	}
+
+	void DynamicAABBTree::querySphere(const Sphere& sphere, std::vector<void*>& results) const
+	{
+		querySpheres(1, &sphere, &results);
+	}
+
+	void DynamicAABBTree::querySpheres(size_t count, const Sphere spheres[], std::vector<void*> results[]) const
+	{
+		SGE_ASSERT(count <= MAX_BATCH);
+
+		if (root == NULL_NODE || count == 0)
+		{
+			return;
+		}
+
+		StackEntry stack[STACK_SIZE];
+		size_t size = 0;
+
+		uint32 all = count == MAX_BATCH ? 0xFFFFFFFF : (1u << count) - 1;
+		stack[size++] = { root, all, 0 };
+
+		while (size > 0)
+		{
+			StackEntry entry = stack[--size];
+			const Node& node = nodes[entry.node];
+
+			for (uint32 bits = entry.partial, i = 0; bits; bits >>= 1, i++)
+			{
+				if ((bits & 1) && !intersects(node.aabb, spheres[i]))
+				{
+					entry.partial &= ~(1u << i);
+				}
+			}
+
+			if (!entry.partial)
+			{
+				continue;
+			}
+
+			if (node.isLeaf())
+			{
+				for (uint32 bits = entry.partial, i = 0; bits; bits >>= 1, i++)
+				{
+					if (bits & 1)
+					{
+						results[i].push_back(node.userData);
+					}
+				}
+			}
+			else
+			{
+				SGE_ASSERT(size + 2 <= STACK_SIZE);
+
+				stack[size++] = { node.child1, entry.partial, 0 };
+				stack[size++] = { node.child2, entry.partial, 0 };
+			}
+		}
+	}
+
+	void DynamicAABBTree::queryRay(const Ray& ray, std::vector<RayHit>& results) const
+	{
+		queryRays(1, &ray, &results);
+	}
+
+	void DynamicAABBTree::queryRays(size_t count, const Ray rays[], std::vector<RayHit> results[]) const
+	{
+		SGE_ASSERT(count <= MAX_BATCH);
+
+		if (root == NULL_NODE || count == 0)
+		{
+			return;
+		}
+
+		math::vec3 inverseDirections[MAX_BATCH];
+
+		for (size_t i = 0; i < count; i++)
+		{
+			inverseDirections[i] = 1.0f / rays[i].direction;
+		}
+
+		StackEntry stack[STACK_SIZE];
+		size_t size = 0;
+
+		uint32 all = count == MAX_BATCH ? 0xFFFFFFFF : (1u << count) - 1;
+		stack[size++] = { root, all, 0 };
+
+		while (size > 0)
+		{
+			StackEntry entry = stack[--size];
+			const Node& node = nodes[entry.node];
+
+			float distances[MAX_BATCH];
+
+			for (uint32 bits = entry.partial, i = 0; bits; bits >>= 1, i++)
+			{
+				if ((bits & 1) && !intersects(node.aabb, rays[i], inverseDirections[i], distances[i]))
+				{
+					entry.partial &= ~(1u << i);
+				}
+			}
+
+			if (!entry.partial)
+			{
+				continue;
+			}
+
+			if (node.isLeaf())
+			{
+				for (uint32 bits = entry.partial, i = 0; bits; bits >>= 1, i++)
+				{
+					if (bits & 1)
+					{
+						results[i].push_back({ node.userData, distances[i] });
+					}
+				}
+			}
+			else
+			{
+				SGE_ASSERT(size + 2 <= STACK_SIZE);
+
+				stack[size++] = { node.child1, entry.partial, 0 };
+				stack[size++] = { node.child2, entry.partial, 0 };
+			}
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			std::sort(results[i].begin(), results[i].end(), [](const RayHit& lhs, const RayHit& rhs)
+			{
+				return lhs.distance < rhs.distance;
+			});
+		}
+	}
+
+	void DynamicAABBTree::validate() const
+	{
+		if (root != NULL_NODE)
+		{
+			SGE_ASSERT(nodes[root].parent == NULL_NODE);
+
+			validateNode(root);
+		}
+
+		size_t freeCount = 0;
+
+		for (int32 index = freeList; index != NULL_NODE; index = nodes[index].next)
+		{
+			freeCount++;
+		}
+
+		// Every leaf except the first one has exactly one internal node above it.
+		size_t used = proxyCount > 0 ? 2 * proxyCount - 1 : 0;
+
+		SGE_ASSERT(used + freeCount == nodes.size());
+	}
+
+	int32 DynamicAABBTree::validateNode(int32 index) const
+	{
+		const Node& node = nodes[index];
+
+		if (node.isLeaf())
+		{
+			SGE_ASSERT(node.child2 == NULL_NODE);
+			SGE_ASSERT(node.height == 0);
+
+			return 0;
+		}
+
+		SGE_ASSERT(nodes[node.child1].parent == index);
+		SGE_ASSERT(nodes[node.child2].parent == index);
+		SGE_ASSERT(node.aabb.contains(nodes[node.child1].aabb));
+		SGE_ASSERT(node.aabb.contains(nodes[node.child2].aabb));
+
+		int32 height1 = validateNode(node.child1);
+		int32 height2 = validateNode(node.child2);
+
+		SGE_ASSERT(node.height == 1 + std::max(height1, height2));
+
+		return node.height;
+	}
+}
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Game/LightGrid.h"
+#include "Game/CameraComponent.h"
+#include "Core/Assert.h"
+
+namespace sge
+{
+	const uint32 LightGrid::CLUSTER_X;
+	const uint32 LightGrid::CLUSTER_Y;
+	const uint32 LightGrid::CLUSTER_Z;
+	const uint32 LightGrid::CLUSTERS_PER_CAMERA;
+
+	namespace
+	{
+		math::vec3 unproject(const math::mat4& inverseProj, float x, float y, float z)
+		{
+			math::vec4 p = inverseProj * math::vec4(x, y, z, 1.0f);
+			return math::vec3(p) / p.w;
+		}
+
+		// Point on the line from a to b at the given view space depth.
+		math::vec3 atDepth(const math::vec3& a, const math::vec3& b, float depth)
+		{
+			float t = (depth + a.z) / (a.z - b.z);
+			return a + (b - a) * t;
+		}
+	}
+
+	LightGrid::LightGrid()
+	{
+	}
+
+	LightGrid::~LightGrid()
+	{
+	}
+
+	void LightGrid::build(size_t cameraCount, CameraComponent* cameras[], size_t lightCount, const PointLight lights[])
+	{
+		Cluster empty = { 0, 0 };
+
+		clusters.assign(cameraCount * CLUSTERS_PER_CAMERA, empty);
+		cameraData.resize(cameraCount);
+		pairs.clear();
+
+		radii.resize(lightCount);
+
+		for (size_t i = 0; i < lightCount; i++)
+		{
+			radii[i] = getLightRadius(lights[i]);
+		}
+
+		for (size_t i = 0; i < cameraCount; i++)
+		{
+			buildCamera(i, cameras[i], lightCount, lights);
+		}
+
+		// Counting sort of the (cluster, light) pairs into one contiguous index list.
+		for (size_t i = 0; i < pairs.size(); i += 2)
+		{
+			clusters[pairs[i]].count++;
+		}
+
+		uint32 offset = 0;
+
+		for (auto& cluster : clusters)
+		{
+			cluster.offset = offset;
+			offset += cluster.count;
+			cluster.count = 0;
+		}
+
+		lightIndices.resize(offset);
+
+		for (size_t i = 0; i < pairs.size(); i += 2)
+		{
+			Cluster& cluster = clusters[pairs[i]];
+			lightIndices[cluster.offset + cluster.count++] = pairs[i + 1];
+		}
+	}
+
+	void LightGrid::buildCamera(size_t camera, CameraComponent* component, size_t lightCount, const PointLight lights[])
+	{
+		const math::mat4& view = component->getView();
+		const math::mat4& proj = component->getProjection();
+		const Viewport* viewport = component->getViewport();
+
+		float nearPlane = component->getNear();
+		float farPlane = component->getFar();
+		bool logarithmic = component->isPerspective() && nearPlane > 0.0f;
+
+		SGE_ASSERT(farPlane > nearPlane);
+
+		float width = static_cast<float>(std::max(viewport->width, 1u));
+		float height = static_cast<float>(std::max(viewport->height, 1u));
+		float tileWidth = std::ceil(width / CLUSTER_X);
+		float tileHeight = std::ceil(height / CLUSTER_Y);
+
+		CameraData& data = cameraData[camera];
+
+		data.viewDepth = -math::vec4(view[0][2], view[1][2], view[2][2], view[3][2]);
+		data.tile = math::vec4(static_cast<float>(viewport->x), static_cast<float>(viewport->y), tileWidth, tileHeight);
+
+		if (logarithmic)
+		{
+			float scale = CLUSTER_Z / std::log(farPlane / nearPlane);
+			data.depth = math::vec4(scale, -std::log(nearPlane) * scale, 1.0f, 0.0f);
+		}
+		else
+		{
+			float scale = CLUSTER_Z / (farPlane - nearPlane);
+			data.depth = math::vec4(scale, -nearPlane * scale, 0.0f, 0.0f);
+		}
+
+		data.grid[0] = CLUSTER_X;
+		data.grid[1] = CLUSTER_Y;
+		data.grid[2] = CLUSTER_Z;
+		data.grid[3] = static_cast<int32>(camera * CLUSTERS_PER_CAMERA);
+
+		// Slice boundaries in view space depth.
+		float sliceDepths[CLUSTER_Z + 1];
+
+		for (uint32 z = 0; z <= CLUSTER_Z; z++)
+		{
+			float t = static_cast<float>(z) / CLUSTER_Z;
+			sliceDepths[z] = logarithmic ?
+				nearPlane * std::pow(farPlane / nearPlane, t) :
+				nearPlane + (farPlane - nearPlane) * t;
+		}
+
+		// View space bounds of every cluster, built from the lines through the tile corners.
+		math::mat4 inverseProj = math::inverse(proj);
+		math::vec3 lines[CLUSTER_X + 1][CLUSTER_Y + 1][2];
+
+		for (uint32 x = 0; x <= CLUSTER_X; x++)
+		{
+			for (uint32 y = 0; y <= CLUSTER_Y; y++)
+			{
+				float ndcX = std::min(x * tileWidth / width, 1.0f) * 2.0f - 1.0f;
+				float ndcY = std::min(y * tileHeight / height, 1.0f) * 2.0f - 1.0f;
+
+				lines[x][y][0] = unproject(inverseProj, ndcX, ndcY, -1.0f);
+				lines[x][y][1] = unproject(inverseProj, ndcX, ndcY, 1.0f);
+			}
+		}
+
+		clusterBounds.resize(CLUSTERS_PER_CAMERA);
+
+		for (uint32 z = 0; z < CLUSTER_Z; z++)
+		{
+			for (uint32 y = 0; y < CLUSTER_Y; y++)
+			{
+				for (uint32 x = 0; x < CLUSTER_X; x++)
+				{
+					AABB& bounds = clusterBounds[(z * CLUSTER_Y + y) * CLUSTER_X + x];
+					bounds = AABB();
+
+					for (uint32 corner = 0; corner < 4; corner++)
+					{
+						const math::vec3* line = lines[x + (corner & 1)][y + (corner >> 1)];
+
+						bounds.expand(atDepth(line[0], line[1], sliceDepths[z]));
+						bounds.expand(atDepth(line[0], line[1], sliceDepths[z + 1]));
+					}
+				}
+			}
+		}
+
+		uint32 first = static_cast<uint32>(camera * CLUSTERS_PER_CAMERA);
+
+		for (size_t i = 0; i < lightCount; i++)
+		{
+			Sphere sphere = { math::vec3(view * math::vec4(math::vec3(lights[i].position), 1.0f)), radii[i] };
+			float depth = -sphere.center.z;
+
+			if (depth + sphere.radius < nearPlane || depth - sphere.radius > farPlane)
+			{
+				continue;
+			}
+
+			int32 minX = 0, maxX = CLUSTER_X - 1;
+			int32 minY = 0, maxY = CLUSTER_Y - 1;
+			int32 minZ = 0, maxZ = CLUSTER_Z - 1;
+
+			if (sphere.radius < FLT_MAX)
+			{
+				// Depth slices covered by the sphere.
+				float nearDepth = std::max(depth - sphere.radius, nearPlane);
+				float farDepth = std::min(depth + sphere.radius, farPlane);
+
+				minZ = static_cast<int32>(std::floor(logarithmic ? std::log(nearDepth) * data.depth.x + data.depth.y : nearDepth * data.depth.x + data.depth.y));
+				maxZ = static_cast<int32>(std::floor(logarithmic ? std::log(farDepth) * data.depth.x + data.depth.y : farDepth * data.depth.x + data.depth.y));
+
+				// Screen tiles covered by the projection of the sphere's bounding box.
+				math::vec2 ndcMin(FLT_MAX);
+				math::vec2 ndcMax(-FLT_MAX);
+				bool behind = false;
+
+				for (uint32 corner = 0; corner < 8 && !behind; corner++)
+				{
+					math::vec3 offset(
+						corner & 1 ? sphere.radius : -sphere.radius,
+						corner & 2 ? sphere.radius : -sphere.radius,
+						corner & 4 ? sphere.radius : -sphere.radius);
+
+					math::vec4 clip = proj * math::vec4(sphere.center + offset, 1.0f);
+
+					if (clip.w <= 0.0f)
+					{
+						behind = true;
+					}
+					else
+					{
+						math::vec2 ndc = math::vec2(clip) / clip.w;
+						ndcMin = math::min(ndcMin, ndc);
+						ndcMax = math::max(ndcMax, ndc);
+					}
+				}
+
+				if (!behind)
+				{
+					minX = static_cast<int32>(std::floor((ndcMin.x * 0.5f + 0.5f) * width / tileWidth));
+					maxX = static_cast<int32>(std::floor((ndcMax.x * 0.5f + 0.5f) * width / tileWidth));
+					minY = static_cast<int32>(std::floor((ndcMin.y * 0.5f + 0.5f) * height / tileHeight));
+					maxY = static_cast<int32>(std::floor((ndcMax.y * 0.5f + 0.5f) * height / tileHeight));
+				}
+
+				minX = std::max(minX, 0);
+				minY = std::max(minY, 0);
+				minZ = std::max(minZ, 0);
+				maxX = std::min(maxX, static_cast<int32>(CLUSTER_X) - 1);
+				maxY = std::min(maxY, static_cast<int32>(CLUSTER_Y) - 1);
+				maxZ = std::min(maxZ, static_cast<int32>(CLUSTER_Z) - 1);
+			}
+
+			for (int32 z = minZ; z <= maxZ; z++)
+			{
+				for (int32 y = minY; y <= maxY; y++)
+				{
+					for (int32 x = minX; x <= maxX; x++)
+					{
+						uint32 index = (z * CLUSTER_Y + y) * CLUSTER_X + x;
+
+						if (intersects(clusterBounds[index], sphere))
+						{
+							pairs.push_back(first + index);
+							pairs.push_back(static_cast<uint32>(i));
+						}
+					}
+				}
+			}
+		}
+	}
+
+	float LightGrid::getLightRadius(const PointLight& light)
+	{
+		math::vec3 brightest = math::max(math::max(math::vec3(light.ambient), math::vec3(light.diffuse)), math::vec3(light.specular));
+		float intensity = std::max(std::max(brightest.r, brightest.g), brightest.b);
+
+		// Solve quadratic * d^2 + linear * d + constant = 256 * intensity.
+		float c = light.constant - 256.0f * intensity;
+
+		if (c >= 0.0f)
+		{
+			return 0.0f;
+		}
+
+		if (light.quadratic > 0.0f)
+		{
+			return (-light.mylinear + std::sqrt(light.mylinear * light.mylinear - 4.0f * light.quadratic * c)) / (2.0f * light.quadratic);
+		}
+
+		if (light.mylinear > 0.0f)
+		{
+			return -c / light.mylinear;
+		}
+
+		// No falloff, the light reaches everything.
+		return FLT_MAX;
+	}
+}
@@ -0,0 +1,241 @@
+#include <algorithm>
+
+#include "Game/MaterialTable.h"
+#include "Renderer/GraphicsDevice.h"
+#include "Resources/BlockCompression.h"
+#include "Resources/ModelResource.h"
+#include "Resources/TextureResource.h"
+#include "Core/Assert.h"
+
+namespace sge
+{
+	namespace
+	{
+		// Arrays start small and double, a full array starts another one of the same kind.
+		const size_t FIRST_CAPACITY = 4;
+		const size_t MAX_LAYERS = 256;
+	}
+
+	MaterialTable::MaterialTable(GraphicsDevice* device) :
+		device(device)
+	{
+		buffer = device->createBuffer(BufferType::STORAGE, BufferUsage::DYNAMIC, 0);
+	}
+
+	MaterialTable::~MaterialTable()
+	{
+		for (auto& array : arrays)
+		{
+			device->deleteTexture(array.texture);
+		}
+
+		device->deleteBuffer(buffer);
+	}
+
+	bool MaterialTable::add(const Mesh* mesh)
+	{
+		if (contains(mesh))
+		{
+			return find(mesh) != nullptr;
+		}
+
+		Texture* textures[3] = { mesh->diffuseTexture, mesh->normalTexture, mesh->specularTexture };
+		TextureResource* sources[3] = { mesh->diffuseSource, mesh->normalSource, mesh->specularSource };
+
+		for (size_t i = 0; i < 3; i++)
+		{
+			if (textures[i] && (!sources[i] || !sources[i]->getData()))
+			{
+				rejected.insert(mesh);
+
+				return false;
+			}
+		}
+
+		Material material;
+
+		if (freeMaterials.empty())
+		{
+			material.index = static_cast<uint32>(materialData.size() / 4);
+			materialData.resize(materialData.size() + 4, 0);
+		}
+		else
+		{
+			material.index = freeMaterials.back();
+			freeMaterials.pop_back();
+		}
+
+		for (size_t i = 0; i < 3; i++)
+		{
+			Layer layer = textures[i] ? addTexture(sources[i]) : Layer{ nullptr, 0, 0 };
+
+			material.arrays[i] = layer.array;
+			material.pixels[i] = textures[i] ? sources[i]->getData() : nullptr;
+			materialData[material.index * 4 + i] = layer.layer;
+		}
+
+		materials[mesh] = material;
+
+		device->copyData(buffer, materialData.size() * sizeof(int32), materialData.data());
+
+		return true;
+	}
+
+	void MaterialTable::remove(const Mesh* mesh)
+	{
+		rejected.erase(mesh);
+
+		auto it = materials.find(mesh);
+
+		if (it == materials.end())
+		{
+			return;
+		}
+
+		for (size_t i = 0; i < 3; i++)
+		{
+			if (it->second.pixels[i])
+			{
+				removeTexture(it->second.pixels[i]);
+			}
+		}
+
+		// The entry in the buffer is left as it is, nothing draws with it until it is reused.
+		freeMaterials.push_back(it->second.index);
+		materials.erase(it);
+	}
+
+	bool MaterialTable::contains(const Mesh* mesh) const
+	{
+		return materials.find(mesh) != materials.end() || rejected.find(mesh) != rejected.end();
+	}
+
+	const MaterialTable::Material* MaterialTable::find(const Mesh* mesh) const
+	{
+		auto it = materials.find(mesh);
+
+		return it != materials.end() ? &it->second : nullptr;
+	}
+
+	MaterialTable::Layer MaterialTable::addTexture(TextureResource* source)
+	{
+		auto it = layers.find(source->getData());
+
+		if (it != layers.end())
+		{
+			it->second.references++;
+
+			return it->second;
+		}
+
+		size_t width = source->getSize().x;
+		size_t height = source->getSize().y;
+		Format format = source->getPixelFormat();
+
+		std::vector<const unsigned char*> levels;
+		std::vector<size_t> sizes;
+		std::vector<unsigned char> mips;
+
+		if (source->isCooked())
+		{
+			for (size_t level = 0; level < source->getLevels(); level++)
+			{
+				levels.push_back(source->getLevelData(level));
+				sizes.push_back(source->getLevelSize(level));
+			}
+		}
+		else
+		{
+			// The full chain, the same levels the device generates for 2D textures.
+			for (size_t level = 0; (width >> level) > 0 || (height >> level) > 0; level++)
+			{
+				sizes.push_back(getImageSize(Format::RGBA, width >> level ? width >> level : 1, height >> level ? height >> level : 1));
+			}
+
+			size_t mipSize = 0;
+
+			for (size_t level = 1; level < sizes.size(); level++)
+			{
+				mipSize += sizes[level];
+			}
+
+			mips.resize(mipSize);
+			createMipChain(source->getData(), width, height, sizes.size(), mips.data());
+
+			levels.push_back(source->getData());
+
+			size_t offset = 0;
+
+			for (size_t level = 1; level < sizes.size(); level++)
+			{
+				levels.push_back(mips.data() + offset);
+				offset += sizes[level];
+			}
+		}
+
+		TextureArray* array = nullptr;
+
+		for (auto& candidate : arrays)
+		{
+			if (candidate.width == width && candidate.height == height && candidate.levels == levels.size() &&
+				candidate.format == format && (candidate.layers < MAX_LAYERS || !candidate.freeLayers.empty()))
+			{
+				array = &candidate;
+				break;
+			}
+		}
+
+		if (!array)
+		{
+			TextureArray created = { device->createTextureArray(width, height, FIRST_CAPACITY, levels.size(), format), width, height, levels.size(), format, 0, FIRST_CAPACITY, {} };
+
+			arrays.push_back(created);
+			array = &arrays.back();
+		}
+		else if (array->freeLayers.empty() && array->layers == array->capacity)
+		{
+			array->capacity = std::min(array->capacity * 2, MAX_LAYERS);
+			device->setTextureLayers(array->texture, array->capacity);
+		}
+
+		Layer layer = { array->texture, 0, 1 };
+
+		if (array->freeLayers.empty())
+		{
+			layer.layer = static_cast<int32>(array->layers++);
+		}
+		else
+		{
+			layer.layer = array->freeLayers.back();
+			array->freeLayers.pop_back();
+		}
+
+		device->copyTextureLayer(layer.array, layer.layer, levels.data(), sizes.data());
+		layers[source->getData()] = layer;
+
+		return layer;
+	}
+
+	void MaterialTable::removeTexture(const unsigned char* pixels)
+	{
+		auto it = layers.find(pixels);
+
+		SGE_ASSERT(it != layers.end() && it->second.references > 0);
+
+		if (--it->second.references > 0)
+		{
+			return;
+		}
+
+		for (auto& array : arrays)
+		{
+			if (array.texture == it->second.array)
+			{
+				array.freeLayers.push_back(it->second.layer);
+				break;
+			}
+		}
+
+		layers.erase(it);
+	}
+}
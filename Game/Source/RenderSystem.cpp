@@ -1,5 +1,11 @@
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
 #include "Renderer/Buffer.h"
 #include "Renderer/GraphicsDevice.h"
+#include "Renderer/Pipeline.h"
+#include "Renderer/Query.h"
 #include "Renderer/RenderData.h"
 #include "Renderer/RenderTarget.h"
 #include "Renderer/VertexLayout.h"
@@ -13,10 +19,15 @@
 
 #include "Game/CameraComponent.h"
 
+#include "Game/BoundsComponent.h"
 #include "Game/ModelComponent.h"
 #include "Game/RenderComponent.h"
+#include "Game/SpatialSystem.h"
 #include "Game/SpriteComponent.h"
 #include "Game/TextComponent.h"
+#include "Game/MaterialTable.h"
+#include "Game/TextureManager.h"
+#include "Game/TextureStreamer.h"
 #include "Game/TransformComponent.h"
 
 #include "Renderer/CubeMap.h"
@@ -24,13 +35,91 @@
 
 namespace sge
 {
+    // Uniform block bindings shared by the vertex and pixel shaders.
+    const size_t VERTEX_UNIFORM_SLOT = 0;
+    const size_t PIXEL_UNIFORM_SLOT = 1;
+
+    // Material features of the lit model shaders, every feature compiles its texture in with a #define.
+    const uint32 DIFFUSE_TEXTURE_FEATURE = 1 << 0;
+    const uint32 NORMAL_TEXTURE_FEATURE = 1 << 1;
+    const uint32 SPECULAR_TEXTURE_FEATURE = 1 << 2;
+    const uint32 CUBE_MAP_FEATURE = 1 << 3;
+    const uint32 TEXTURE_ARRAY_FEATURE = 1 << 4;
+
+    const char* const MATERIAL_FEATURE_DEFINES[] = { "HAS_DIFFUSE_TEX", "HAS_NORMAL_TEX", "HAS_SPECULAR_TEX", "HAS_CUBE_TEX", "HAS_TEXTURE_ARRAYS" };
+    const size_t MATERIAL_FEATURE_COUNT = sizeof(MATERIAL_FEATURE_DEFINES) / sizeof(MATERIAL_FEATURE_DEFINES[0]);
+
+    // Storage buffer bindings of PixelShaderLights.glsl.
+    const size_t DIR_LIGHT_SLOT = 0;
+    const size_t POINT_LIGHT_SLOT = 1;
+    const size_t CLUSTER_SLOT = 2;
+    const size_t LIGHT_INDEX_SLOT = 3;
+
+    // Storage buffer bindings of VertexShaderDepthIndirect.glsl and ComputeShaderCulling.glsl.
+    const size_t DRAW_DATA_SLOT = 4;
+    const size_t CULL_INSTANCE_SLOT = 5;
+    const size_t FRUSTUM_SLOT = 6;
+    const size_t COMMAND_SLOT = 7;
+
+    // The lit shaders don't read the draw data, so the material table of the texture arrays takes its binding.
+    const size_t MATERIAL_SLOT = 4;
+
+    // local_size_x of ComputeShaderCulling.glsl.
+    const size_t CULL_GROUP_SIZE = 64;
+
+    // Vertices of a static geometry block, meshes larger than this get a block of their own.
+    const uint32 STATIC_BLOCK_VERTICES = 1 << 18;
+
+    // A model is culled after its box has been hidden this many times in a row.
+    const uint32 OCCLUSION_HYSTERESIS = 3;
+
+    // Occlusion state of models that haven't been tested for this many frames is dropped.
+    const uint64 OCCLUSION_EXPIRE_FRAMES = 60;
+
     RenderSystem::RenderSystem(Window& window) :
 		queue(1000),
+        window(window),
+        device(new GraphicsDevice(window)),
+        clearColor(0.5f, 0.6f, 0.2f, 1.0f),
+        renderPath(RenderPath::FORWARD),
+        deferredPass(DeferredPass::GEOMETRY),
+        renderTarget(nullptr),
+        gBuffer(nullptr),
+        lightBuffer(nullptr),
+        depthPrePass(false),
+        depthPass(false),
+        depthPipeline(nullptr),
+        depthPackedPipeline(nullptr),
+        indirectDraws(false),
+        indirectDepthPipeline(nullptr),
+        indirectDepthPackedPipeline(nullptr),
+        textureArrays(false),
+        materialTable(nullptr),
+        gpuCulling(false),
+        cullPipeline(nullptr),
+        occlusionCulling(false),
+        boxVertexBuffer(nullptr),
+        frameIndex(0),
+        recordThreads(0),
+        immediateCommands(device),
+        commands(&immediateCommands),
+        recordedPacket(0),
+        submittedPacket(nullptr),
+        renderJob(nullptr),
+        renderThreadQuit(false),
+        pipelined(false),
+        textureStreamer(nullptr),
+        textureUploadBudget(8 * 1024 * 1024),
+        textureManager(nullptr),
+        unloadCallback(0),
+        stats(),
+        frameStats(),
+        pendingStats(),
+        spatialSystem(nullptr),
+        visibilityValid(false),
         initialized(false),
-        acceptingCommands(false),
-        clearColor(0.5f, 0.6f, 0.2f, 1.0f)
+        acceptingCommands(false)
 	{
-		device = new GraphicsDevice(window);
 	}
 
     RenderSystem::~RenderSystem()
@@ -41,6 +130,7 @@ namespace sge
     void RenderSystem::init()
 	{
 		device->init();
+        device->setProgramCache(programCache.empty() ? nullptr : programCache.c_str());
         
         initShaders();
 
@@ -50,11 +140,27 @@ namespace sge
 
         device->clear(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
 
+        unloadCallback = ResourceManager::getMgr().addUnloadCallback([this](Resource* resource)
+        {
+            releaseModel(dynamic_cast<ModelResource*>(resource));
+        });
+
         initialized = true;
 	}
 
     void RenderSystem::deinit()
 	{
+        setPipelined(false);
+
+        ResourceManager::getMgr().removeUnloadCallback(unloadCallback);
+
+        // The worker writes into staging memory of the device, so it stops first.
+        delete textureStreamer;
+        textureStreamer = nullptr;
+
+        delete textureManager;
+        textureManager = nullptr;
+
         device->deleteShader(sprVertexShader);
         device->deleteShader(sprPixelShader);
         device->deleteBuffer(sprVertexBuffer);
@@ -63,6 +169,98 @@ namespace sge
         device->deletePipeline(sprPipeline);
         device->deleteBuffer(modelVertexUniformBuffer);
         device->deleteBuffer(modelPixelUniformBuffer);
+        device->deleteBuffer(dirLightBuffer);
+        device->deleteBuffer(pointLightBuffer);
+        device->deleteBuffer(clusterBuffer);
+        device->deleteBuffer(lightIndexBuffer);
+
+        if (gBuffer)
+        {
+            device->deleteRenderTarget(gBuffer);
+            device->deleteRenderTarget(lightBuffer);
+            device->deletePipeline(gBufferPipeline);
+            device->deletePipeline(gBufferPackedPipeline);
+            device->deletePipeline(deferredLightPipeline);
+            device->deletePipeline(compositePipeline);
+            device->deleteShader(gBufferVertexShader);
+            device->deleteShader(gBufferPixelShader);
+            device->deleteShader(fullscreenVertexShader);
+            device->deleteShader(deferredLightPixelShader);
+            device->deleteShader(compositePixelShader);
+            device->deleteBuffer(deferredPixelUniformBuffer);
+
+            gBuffer = nullptr;
+        }
+
+        if (depthPipeline)
+        {
+            device->deletePipeline(depthPipeline);
+            device->deletePipeline(depthPackedPipeline);
+            device->deleteShader(depthVertexShader);
+            device->deleteShader(depthPixelShader);
+
+            depthPipeline = nullptr;
+            depthPackedPipeline = nullptr;
+        }
+
+        if (indirectDepthPipeline)
+        {
+            device->deletePipeline(indirectDepthPipeline);
+            device->deletePipeline(indirectDepthPackedPipeline);
+            device->deleteShader(indirectDepthVertexShader);
+            device->deleteBuffer(indirectBuffer);
+            device->deleteBuffer(drawDataBuffer);
+
+            indirectDepthPipeline = nullptr;
+            indirectDepthPackedPipeline = nullptr;
+        }
+
+        if (cullPipeline)
+        {
+            device->deletePipeline(cullPipeline);
+            device->deleteShader(cullShader);
+            device->deleteBuffer(cullInstanceBuffer);
+            device->deleteBuffer(frustumBuffer);
+
+            cullPipeline = nullptr;
+        }
+
+        delete materialTable;
+        materialTable = nullptr;
+
+        for (auto& block : staticBlocks)
+        {
+            device->deleteBuffer(block.buffer);
+        }
+
+        staticBlocks.clear();
+
+        if (boxVertexBuffer)
+        {
+            device->deleteBuffer(boxVertexBuffer);
+            device->deletePipeline(occlusionPipeline);
+
+            boxVertexBuffer = nullptr;
+        }
+
+        for (auto& variant : pipelineVariants)
+        {
+            device->deletePipeline(variant.second);
+        }
+
+        pipelineVariants.clear();
+
+        releaseOcclusionQueries(true);
+
+        for (auto queries : { &frameQueries, &pendingQueries, &freeQueries })
+        {
+            for (auto query : *queries)
+            {
+                device->deleteQuery(query);
+            }
+
+            queries->clear();
+        }
 
 		device->deinit();
 
@@ -135,8 +333,66 @@ namespace sge
 
             SGE_ASSERT(model);
 
+            // The render functions cycle through the cameras, so a model is either
+            // pushed for every camera or culled from all of them.
+            if (spatialSystem && models[i]->getComponent<BoundsComponent>())
+            {
+                calculateVisibility();
+
+                if (visibleEntities.find(models[i]) == visibleEntities.end())
+                {
+                    continue;
+                }
+            }
+
             model->setRenderer(this);
 
+            if (model->isLit())
+            {
+                // The variants depend on whether the meshes got a material.
+                if (textureArrays)
+                {
+                    addMaterials(model);
+                }
+
+                createPipelineVariants(model);
+            }
+
+            if (textureManager)
+            {
+                useTextures(model);
+            }
+
+            // The indirect depth pre-pass draws every camera at once, so a model is listed once.
+            if (indirectDraws && model->isLit())
+            {
+                indirectModels.push_back(model);
+            }
+
+            if (occlusionCulling)
+            {
+                BoundsComponent* bounds = models[i]->getComponent<BoundsComponent>();
+
+                if (bounds)
+                {
+                    occlusionCandidates.push_back({ model, bounds });
+                }
+            }
+
+            if (recordThreads > 0)
+            {
+                // The draws know their camera, so they are recorded without cycling through the cameras.
+                for (size_t camera = 0; camera < cameras.size(); camera++)
+                {
+                    size_t index = modelDraws.size();
+
+                    modelDraws.push_back({ model, camera, 0, 0, 0 });
+                    queue.push(model->key, [this, index](GraphicsDevice*) { submitModelDraw(index); });
+                }
+
+                continue;
+            }
+
             for (auto camera : cameras)
             {
                 //uint32 distance = static_cast<uint32>(math::dot(model->transform->getPosition(),
@@ -183,337 +439,1639 @@ namespace sge
     {
         SGE_ASSERT(!acceptingCommands);
 
-        device->bindRenderTarget(renderTarget);
+        this->renderTarget = renderTarget;
+
+        commands->bindRenderTarget(renderTarget);
     }
 
-    void RenderSystem::addCameras(size_t count, Entity** cameras)
+    void RenderSystem::setRenderPath(RenderPath path)
     {
-        SGE_ASSERT(!acceptingCommands);
-        
-        for (size_t i = 0; i < count; i++)
-        {
-            CameraComponent* camera = cameras[i]->getComponent<CameraComponent>();
+        SGE_ASSERT(initialized && !acceptingCommands);
 
-            SGE_ASSERT(camera);
+#ifdef DIRECTX11
+        SGE_ASSERT(path == RenderPath::FORWARD);
+#endif
 
-            this->cameras.push_back(camera);
+        if (path == RenderPath::DEFERRED && !gBuffer)
+        {
+            runOnDevice([this]() { initDeferredRendering(); });
         }
+
+        renderPath = path;
     }
 
-    void RenderSystem::begin()
+    void RenderSystem::setDepthPrePass(bool enabled)
     {
         SGE_ASSERT(initialized && !acceptingCommands);
 
-        queue.begin();
-
-        acceptingCommands = true;
-    }
-
-    void RenderSystem::end()
-	{
-        SGE_ASSERT(acceptingCommands);
-
-        calculateLightData();
+#ifdef DIRECTX11
+        SGE_ASSERT(!enabled);
+#endif
 
-		queue.end();
+        if (enabled && !depthPipeline)
+        {
+            runOnDevice([this]() { initDepthRendering(); });
+        }
 
-        acceptingCommands = false;
-	}
+        depthPrePass = enabled;
+    }
 
-    void RenderSystem::render()
+    void RenderSystem::setIndirectDraws(bool enabled)
     {
         SGE_ASSERT(initialized && !acceptingCommands);
 
-        for (auto& command : queue.getQueue())
+#ifdef DIRECTX11
+        SGE_ASSERT(!enabled);
+#endif
+
+        if (enabled && !indirectDepthPipeline)
         {
-            command.second(device);
+            runOnDevice([this]() { initIndirectRendering(); });
         }
-    }
-
-    void RenderSystem::present()
-    {
-        SGE_ASSERT(initialized && !acceptingCommands);
 
-        device->swap();
+        indirectDraws = enabled;
     }
 
-    void RenderSystem::clear(int flags)
+    void RenderSystem::setGpuCulling(bool enabled)
     {
         SGE_ASSERT(initialized && !acceptingCommands);
 
-        if (flags & RENDERTARGET)
-        {
-            device->debindRenderTarget();
-        }
+#ifdef DIRECTX11
+        SGE_ASSERT(!enabled);
+#endif
 
-        if (flags & QUEUE)
+        if (enabled && !cullPipeline)
         {
-            queue.clear();
+            runOnDevice([this]() { initGpuCulling(); });
         }
 
-        if (flags & COLOR || flags & DEPTH || flags & STENCIL)
-        {
-            device->clear(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
-        }
+        gpuCulling = enabled;
+    }
 
-        if (flags & LIGHTS)
-        {
-            pointLights.clear();
-            spotLights.clear();
-            dirLights.clear();
-        }
+    void RenderSystem::setTextureArrays(bool enabled)
+    {
+        SGE_ASSERT(initialized && !acceptingCommands);
 
-        if (flags & CAMERAS)
+#ifdef DIRECTX11
+        SGE_ASSERT(!enabled);
+#endif
+
+        if (enabled && !materialTable)
         {
-            cameras.clear();
+            runOnDevice([this]() { materialTable = new MaterialTable(device); });
         }
+
+        textureArrays = enabled;
     }
 
-    void RenderSystem::renderSprite(SpriteComponent* sprite)
+    Texture* RenderSystem::streamTexture(const std::string& path)
     {
-        static size_t pass = 0;
+        SGE_ASSERT(initialized);
 
-        SGE_ASSERT(cameras.size() > pass);
+#ifdef DIRECTX11
+        SGE_ASSERT(false);
+#endif
 
-        Pipeline* pipeline = sprite->getPipeline();
-        Texture* texture = sprite->getTexture();
+        size_t width, height;
 
-        if (texture)
+        if (!TextureStreamer::readSize(path, width, height))
         {
-            device->bindTexture(texture, 0);
-        }
+            std::cout << "Error streaming texture " << path << " : not an image" << std::endl;
 
-        if (pipeline)
-        {
-            device->bindPipeline(pipeline);
+            return nullptr;
         }
-        else
+
+        Texture* texture = nullptr;
+
+        runOnDevice([&]() { texture = device->createStreamedTexture(width, height); });
+
+        if (!textureStreamer)
         {
-            device->bindPipeline(sprPipeline);
+            textureStreamer = new TextureStreamer(device);
         }
 
-        device->bindViewport(cameras[pass]->getViewport());
-
-        sprVertexUniformData.MVP = cameras[pass]->getViewProj() * sprite->getComponent<TransformComponent>()->getMatrix();
-        sprPixelUniformData.color = sprite->getColor();
+        textureStreamer->stream(texture, path);
 
-        device->bindVertexUniformBuffer(sprVertexUniformBuffer, 0);
-        device->copyData(sprVertexUniformBuffer, sizeof(sprVertexUniformData), &sprVertexUniformData);
+        return texture;
+    }
 
-        device->bindPixelUniformBuffer(sprPixelUniformBuffer, 1);
-        device->copyData(sprPixelUniformBuffer, sizeof(sprPixelUniformData), &sprPixelUniformData);
+    void RenderSystem::deleteStreamedTexture(Texture* texture)
+    {
+        SGE_ASSERT(initialized);
 
-        device->draw(6);
+        if (!texture)
+        {
+            return;
+        }
 
-        if (texture)
+        if (textureStreamer)
         {
-            device->debindTexture(texture, 0);
+            textureStreamer->cancel(texture);
         }
 
-        if (pipeline)
+        if (textureManager)
         {
-            device->debindPipeline(pipeline);
+            textureManager->remove(texture);
         }
-        else
+
+        runOnDevice([this, texture]() { device->deleteTexture(texture); });
+    }
+
+    void RenderSystem::setTextureBudget(size_t bytes)
+    {
+        if (!textureManager)
         {
-            device->debindPipeline(sprPipeline);
+            textureManager = new TextureManager();
         }
 
-        if (++pass >= cameras.size())
-            pass = 0;
+        textureManager->setBudget(bytes);
     }
 
-    void RenderSystem::renderText(TextComponent* text)
+    size_t RenderSystem::getTextureBudget() const
     {
-        device->bindPipeline(textPipeline);
+        return textureManager ? textureManager->getBudget() : 0;
+    }
 
-        sge::Font* font = text->getFont();
-        FT_GlyphSlot slot = font->face->glyph;
+    size_t RenderSystem::getTextureMemory() const
+    {
+        return textureManager ? textureManager->getResidentSize() : 0;
+    }
 
-        // Updates textures if text has changed since previous rendering
-        if (text->getText() != previousText)
+    void RenderSystem::useTextures(ModelComponent* model)
+    {
+        const math::mat4& matrix = model->getComponent<TransformComponent>()->getMatrix();
+
+        for (auto mesh : model->getModelResource()->getMeshes())
         {
-            while (charTextures.size() != 0)
+            // The arrays hold copies, the textures of the mesh aren't drawn.
+            if (textureArrays && model->isLit() && materialTable->find(mesh))
             {
-                charTextures.erase(charTextures.begin());
-                characters.erase(characters.begin());
+                continue;
             }
 
-			// Goes through all characters, loads them and stores the glyph info and textures needed to render text for later use
-			// in order to make the actual drawing faster and more efficient.
-            for (size_t i = 0; i < text->getText().size(); i++)
-            {
-                FT_Load_Char(font->face, text->getText()[i], FT_LOAD_RENDER);
+            AABB bounds = mesh->bounds.transform(matrix);
+            math::vec3 center = bounds.getCenter();
+            float radius = math::length(bounds.getExtents());
+            float screenSize = 0.0f;
 
-                sge::Texture* texture = device->createTextTexture(slot->bitmap.width, slot->bitmap.rows, slot->bitmap.buffer);
+            // Diameter of the bounding sphere in pixels, in the camera that sees it largest.
+            for (auto camera : cameras)
+            {
+                float scale = camera->getProjection()[1][1] * camera->getViewport()->height;
 
-                Character character;
-                character.size = sge::math::vec2(slot->bitmap.width, slot->bitmap.rows);
-                character.horiBearing = sge::math::vec2(slot->metrics.horiBearingX, slot->metrics.horiBearingY);
-                character.vertBearing = sge::math::vec2(slot->metrics.vertBearingX, slot->metrics.vertBearingY);
-                character.metrics = sge::math::vec2(slot->metrics.width, slot->metrics.height);
-				character.advance = sge::math::vec2(slot->advance.x / 32, slot->advance.y / 32);
-                characters.push_back(character);
+                if (camera->isPerspective())
+                {
+                    math::vec3 position = math::vec3(camera->getView() * math::vec4(center, 1.0f));
+                    scale /= std::max(math::length(position), camera->getNear());
+                }
 
-                charTextures.push_back(texture);
+                screenSize = std::max(screenSize, radius * scale);
             }
-            previousText = text->getText();
-        }
 
-        // TODO added support for multiple cameras.
-        static size_t pass = 0;
-
-        SGE_ASSERT(cameras.size() > pass);
+            textureManager->use(mesh->diffuseTexture, mesh->diffuseSource, screenSize);
+            textureManager->use(mesh->normalTexture, mesh->normalSource, screenSize);
+            textureManager->use(mesh->specularTexture, mesh->specularSource, screenSize);
+        }
+    }
 
-        // Render text
-        sge::math::vec2 pen = { 0, 0 }; // The position where the character is drawn.
-        sge::math::vec3 originalPosition = text->getParent()->getComponent<TransformComponent>()->getPosition();
-        sge::math::vec3 originalScale = text->getParent()->getComponent<TransformComponent>()->getScale();
-        for (size_t i = 0; i < text->getText().size(); i++)
+    void RenderSystem::releaseModel(ModelResource* model)
+    {
+        // The ResourceManager calls it for every resource, on the thread owning the device.
+        if (!model)
         {
-            sge::Texture* texture = charTextures[i];
+            return;
+        }
 
-            if (texture)
+        for (auto mesh : model->getMeshes())
+        {
+            if (textureManager)
             {
-                device->bindTexture(texture, 0);
+                textureManager->remove(mesh->diffuseTexture);
+                textureManager->remove(mesh->normalTexture);
+                textureManager->remove(mesh->specularTexture);
             }
 
-			// Calculates the y position of current character.
-            pen.y = characters[i].vertBearing.y / 32 - font->characterSize;
-            if (characters[i].metrics.y / 64 - characters[i].horiBearing.y / 64 > 0)
+            if (materialTable)
             {
-                pen.y += characters[i].metrics.y / 64 - characters[i].horiBearing.y / 64;
+                materialTable->remove(mesh);
             }
+        }
 
-			// Places the character in its desired position.
-            text->getComponent<TransformComponent>()->setPosition(originalPosition + glm::vec3(pen.x, pen.y, 0));
-            text->getComponent<TransformComponent>()->setScale(originalScale * sge::math::vec3(characters[i].size.x, characters[i].size.y, 1));
-
-            device->bindViewport(cameras[pass]->getViewport());
-
-            sprVertexUniformData.MVP = cameras[pass]->getViewProj() * text->getComponent<TransformComponent>()->getMatrix();
-			sge::math::mat4 testi = text->getComponent<TransformComponent>()->getMatrix();
-            sprPixelUniformData.color = text->getColor();
+        model->deleteBuffers();
+    }
 
-			// Calculates the x position of the next character.
-			pen.x += originalScale.x * characters[i].advance.x;
+    void RenderSystem::setOcclusionCulling(bool enabled)
+    {
+        SGE_ASSERT(initialized && !acceptingCommands);
 
-            device->bindVertexUniformBuffer(sprVertexUniformBuffer, 0);
-            device->copyData(sprVertexUniformBuffer, sizeof(sprVertexUniformData), &sprVertexUniformData);
-            device->bindPixelUniformBuffer(sprPixelUniformBuffer, 1);
-            device->copyData(sprPixelUniformBuffer, sizeof(sprPixelUniformData), &sprPixelUniformData);
+#ifdef DIRECTX11
+        SGE_ASSERT(!enabled);
+#endif
 
-            device->draw(6);
+        // The query results are read back while recording, which a render thread can't do.
+        SGE_ASSERT(!enabled || !pipelined);
 
-            if (texture)
-            {
-                device->debindTexture(texture, 0);
-            }
+        if (enabled && !boxVertexBuffer)
+        {
+            initOcclusionCulling();
         }
 
-        text->getComponent<TransformComponent>()->setPosition(originalPosition);
-        text->getComponent<TransformComponent>()->setScale(originalScale);
-        device->debindPipeline(textPipeline);
+        if (!enabled)
+        {
+            releaseOcclusionQueries(true);
+        }
 
-        if (++pass >= cameras.size())
-            pass = 0;
+        occlusionCulling = enabled;
     }
 
-    void RenderSystem::renderModel(ModelComponent* model)
+    void RenderSystem::setRecordThreads(size_t count)
     {
-        static size_t pass = 0;
+        SGE_ASSERT(!acceptingCommands);
 
-        SGE_ASSERT(cameras.size() > pass);
+        recordThreads = count;
+    }
 
-        device->bindViewport(cameras[pass]->getViewport());
+    void RenderSystem::setPipelined(bool enabled)
+    {
+        SGE_ASSERT(initialized && !acceptingCommands);
 
-        modelVertexUniformData.M = model->getComponent<TransformComponent>()->getMatrix();
-        modelVertexUniformData.PV = cameras[pass]->getViewProj();
-		modelVertexUniformData.shininess = model->getComponent<ModelComponent>()->getShininess();
-        modelPixelUniformData.CamPos = math::vec4(cameras[pass]->getComponent<TransformComponent>()->getPosition(), 1.0f);
+#ifdef DIRECTX11
+        SGE_ASSERT(!enabled);
+#endif
 
-        device->bindPipeline(model->getPipeline());
+        if (enabled == pipelined)
+        {
+            return;
+        }
 
-		for (size_t i = 0; i < model->getModelResource()->getMeshes().size(); i++)
-		{
-			device->bindIndexBuffer(model->getModelResource()->getMeshes()[i]->getIndexBuffer());
-			device->bindVertexBuffer(model->getModelResource()->getMeshes()[i]->getVertexBuffer());
-
-			device->bindVertexUniformBuffer(modelVertexUniformBuffer, 0);
-			device->copyData(modelVertexUniformBuffer, sizeof(modelVertexUniformData), &modelVertexUniformData);
-
-			
-			modelPixelUniformData.hasDiffuseTex = 0;		
-			modelPixelUniformData.hasNormalTex = 0;	
-			modelPixelUniformData.hasSpecularTex = 0;	
-			modelPixelUniformData.hasCubeTex = 0;
-
-			Texture* diff = model->getModelResource()->getMeshes()[i]->diffuseTexture;
-			Texture* norm = model->getModelResource()->getMeshes()[i]->normalTexture;
-			Texture* spec = model->getModelResource()->getMeshes()[i]->specularTexture;
-			CubeMap* cube = model->getCubeMap();
-			if (diff)
+        if (enabled)
+        {
+            SGE_ASSERT(!occlusionCulling);
+
+            // Sample counts still in flight are dropped, they can't be read without the context.
+            for (auto queries : { &frameQueries, &pendingQueries })
+            {
+                freeQueries.insert(freeQueries.end(), queries->begin(), queries->end());
+                queries->clear();
+            }
+
+            // The context belongs to the render thread until pipelining is turned off.
+            device->unbindContext();
+
+            recordedPacket = 0;
+            framePackets[recordedPacket].reset();
+            commands = &framePackets[recordedPacket];
+
+            renderThreadQuit = false;
+            renderThread = std::thread(&RenderSystem::runRenderThread, this);
+        }
+        else
+        {
+            {
+                std::lock_guard<std::mutex> lock(renderMutex);
+                renderThreadQuit = true;
+            }
+
+            renderCondition.notify_all();
+            renderThread.join();
+
+            device->bindContext();
+
+            // Whatever was recorded after the last present is submitted now.
+            commands = &immediateCommands;
+            framePackets[recordedPacket].submit(device);
+        }
+
+        pipelined = enabled;
+    }
+
+    void RenderSystem::runOnDevice(const std::function<void()>& function)
+    {
+        if (!pipelined)
+        {
+            function();
+
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(renderMutex);
+
+        renderJob = &function;
+        renderCondition.notify_all();
+        renderCondition.wait(lock, [this]() { return renderJob == nullptr; });
+    }
+
+    void RenderSystem::runRenderThread()
+    {
+        device->bindContext();
+
+        std::unique_lock<std::mutex> lock(renderMutex);
+
+        while (true)
+        {
+            renderCondition.wait(lock, [this]() { return submittedPacket || renderJob || renderThreadQuit; });
+
+            // A packet handed over before a job is submitted first, the packets stay in order.
+            if (submittedPacket)
+            {
+                CommandList* packet = submittedPacket;
+
+                lock.unlock();
+                packet->submit(device);
+                device->swap();
+                lock.lock();
+
+                submittedPacket = nullptr;
+                renderCondition.notify_all();
+            }
+            else if (renderJob)
+            {
+                const std::function<void()>* job = renderJob;
+
+                lock.unlock();
+                (*job)();
+                lock.lock();
+
+                renderJob = nullptr;
+                renderCondition.notify_all();
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        lock.unlock();
+
+        device->unbindContext();
+    }
+
+    void RenderSystem::setSpatialSystem(SpatialSystem* spatialSystem)
+    {
+        SGE_ASSERT(!acceptingCommands);
+
+        this->spatialSystem = spatialSystem;
+    }
+
+    void RenderSystem::addCameras(size_t count, Entity** cameras)
+    {
+        SGE_ASSERT(!acceptingCommands);
+        
+        for (size_t i = 0; i < count; i++)
+        {
+            CameraComponent* camera = cameras[i]->getComponent<CameraComponent>();
+
+            SGE_ASSERT(camera);
+
+            this->cameras.push_back(camera);
+        }
+    }
+
+    void RenderSystem::begin()
+    {
+        SGE_ASSERT(initialized && !acceptingCommands);
+
+        queue.begin();
+
+        visibilityValid = false;
+        acceptingCommands = true;
+    }
+
+    void RenderSystem::end()
+	{
+        SGE_ASSERT(acceptingCommands);
+
+        calculateLightData();
+
+		queue.end();
+
+        acceptingCommands = false;
+	}
+
+    void RenderSystem::render()
+    {
+        SGE_ASSERT(initialized && !acceptingCommands);
+
+        // The queue may be rendered again with different cameras, so the clusters are built here.
+        calculateLightGrid();
+
+        for (auto camera : cameras)
+        {
+            frameStats.pixels += static_cast<uint64>(camera->getViewport()->width) * camera->getViewport()->height;
+        }
+
+        if (renderPath == RenderPath::DEFERRED)
+        {
+            renderDeferred();
+        }
+        else
+        {
+            if (depthPrePass)
+            {
+                renderDepthPrePass();
+            }
+
+            renderMainQueue();
+            renderOcclusionQueries();
+        }
+    }
+
+    void RenderSystem::renderQueue()
+    {
+        // The recorded draws depend on the pass, so they are recorded again for every pass.
+        if (!modelDraws.empty())
+        {
+            recordModelDraws();
+        }
+
+        for (auto& command : queue.getQueue())
+        {
+            command.second(device);
+        }
+    }
+
+    void RenderSystem::renderMainQueue()
+    {
+        // The samples can't be read back a frame late on the render thread without stalling it.
+        if (pipelined)
+        {
+            renderQueue();
+
+            return;
+        }
+
+        Query* query;
+
+        if (freeQueries.empty())
+        {
+            query = device->createQuery(QueryType::SAMPLES_PASSED);
+        }
+        else
+        {
+            query = freeQueries.back();
+            freeQueries.pop_back();
+        }
+
+        device->beginQuery(query);
+        renderQueue();
+        device->endQuery(query);
+
+        frameQueries.push_back(query);
+    }
+
+    void RenderSystem::renderDepthPrePass()
+    {
+        commands->setColorWrite(false);
+
+        if (indirectDraws)
+        {
+            renderIndirectDepth();
+        }
+        else
+        {
+            depthPass = true;
+            renderQueue();
+            depthPass = false;
+        }
+
+        commands->setColorWrite(true);
+    }
+
+    void RenderSystem::renderIndirectDepth()
+    {
+        drawCommands.clear();
+        drawData.clear();
+        indirectBatches.clear();
+
+        for (auto model : indirectModels)
+        {
+            for (auto mesh : model->getModelResource()->getMeshes())
+            {
+                if (mesh->staticBlock < 0)
+                {
+                    addStaticMesh(mesh);
+                }
+            }
+        }
+
+        if (gpuCulling)
+        {
+            buildCulledDraws();
+        }
+        else
+        {
+            buildIndirectDraws();
+        }
+
+        if (indirectBatches.empty())
+        {
+            return;
+        }
+
+        copyStorageData(drawDataBuffer, DRAW_DATA_SLOT, drawData.size() * sizeof(IndirectDrawData), drawData.data());
+
+        if (gpuCulling)
+        {
+            size_t count = cullInstances.size() * cameras.size();
+
+            copyStorageData(cullInstanceBuffer, CULL_INSTANCE_SLOT, cullInstances.size() * sizeof(CullInstance), cullInstances.data());
+            copyStorageData(frustumBuffer, FRUSTUM_SLOT, frustums.size() * sizeof(Frustum), frustums.data());
+
+            // Every argument is written by the dispatch, the buffer only needs its size.
+            commands->copyData(indirectBuffer, count * sizeof(DrawIndirectCommand), nullptr);
+            commands->bindStorageBuffer(indirectBuffer, COMMAND_SLOT);
+
+            commands->bindPipeline(cullPipeline);
+            commands->dispatch((count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+            commands->debindPipeline(cullPipeline);
+        }
+        else
+        {
+            commands->copyData(indirectBuffer, drawCommands.size() * sizeof(DrawIndirectCommand), drawCommands.data());
+        }
+
+        commands->bindIndirectBuffer(indirectBuffer);
+
+        ModelVertexUniformData vertexUniformData = modelVertexUniformData;
+
+        for (auto& batch : indirectBatches)
+        {
+            const StaticBlock& block = staticBlocks[batch.block];
+            Pipeline* pipeline = block.packed ? indirectDepthPackedPipeline : indirectDepthPipeline;
+
+            vertexUniformData.PV = cameras[batch.camera]->getViewProj();
+
+            commands->bindViewport(cameras[batch.camera]->getViewport());
+            commands->bindPipeline(pipeline);
+            commands->bindVertexBuffer(block.buffer);
+            commands->bindVertexUniformBuffer(modelVertexUniformBuffer, 0);
+            commands->copyData(modelVertexUniformBuffer, sizeof(vertexUniformData), &vertexUniformData);
+            commands->drawIndirect(batch.count, batch.first * sizeof(DrawIndirectCommand));
+            commands->debindPipeline(pipeline);
+
+            frameStats.depthDrawCalls += batch.count;
+            frameStats.indirectCalls++;
+        }
+    }
+
+    void RenderSystem::buildIndirectDraws()
+    {
+        for (size_t pass = 0; pass < cameras.size(); pass++)
+        {
+            passDraws.clear();
+
+            for (auto model : indirectModels)
+            {
+                if (occlusionCulling && isOccluded(model, cameras[pass]))
+                {
+                    continue;
+                }
+
+                const math::mat4& matrix = model->getComponent<TransformComponent>()->getMatrix();
+
+                for (auto mesh : model->getModelResource()->getMeshes())
+                {
+                    // The base instance tells the shader which draw data to read.
+                    DrawIndirectCommand command = { static_cast<uint32>(mesh->vertices.size()), 1, mesh->staticFirst, static_cast<uint32>(drawData.size()) };
+                    IndirectDrawData data = { matrix, mesh->positionScale, mesh->positionOffset };
+
+                    passDraws.push_back({ mesh->staticBlock, command });
+                    drawData.push_back(data);
+                }
+            }
+
+            // Draws from the same block are made contiguous, every range is a single call.
+            std::stable_sort(passDraws.begin(), passDraws.end(), [](const IndirectDraw& a, const IndirectDraw& b) { return a.block < b.block; });
+
+            for (auto& draw : passDraws)
+            {
+                if (indirectBatches.empty() || indirectBatches.back().camera != pass || indirectBatches.back().block != draw.block)
+                {
+                    indirectBatches.push_back({ pass, draw.block, drawCommands.size(), 0 });
+                }
+
+                drawCommands.push_back(draw.command);
+                indirectBatches.back().count++;
+            }
+        }
+    }
+
+    void RenderSystem::buildCulledDraws()
+    {
+        passDraws.clear();
+        drawBounds.clear();
+        cullInstances.clear();
+        frustums.clear();
+
+        // Every camera tests the same draws, so the draw data is shared between them.
+        for (auto model : indirectModels)
+        {
+            const math::mat4& matrix = model->getComponent<TransformComponent>()->getMatrix();
+
+            for (auto mesh : model->getModelResource()->getMeshes())
+            {
+                DrawIndirectCommand command = { static_cast<uint32>(mesh->vertices.size()), 1, mesh->staticFirst, static_cast<uint32>(drawData.size()) };
+                IndirectDrawData data = { matrix, mesh->positionScale, mesh->positionOffset };
+
+                passDraws.push_back({ mesh->staticBlock, command });
+                drawData.push_back(data);
+                drawBounds.push_back(mesh->bounds);
+            }
+        }
+
+        std::stable_sort(passDraws.begin(), passDraws.end(), [](const IndirectDraw& a, const IndirectDraw& b) { return a.block < b.block; });
+
+        for (auto& draw : passDraws)
+        {
+            const AABB& bounds = drawBounds[draw.command.baseInstance];
+
+            cullInstances.push_back({ math::vec4(bounds.getCenter(), 0.0f), math::vec4(bounds.getExtents(), 0.0f), draw.command });
+        }
+
+        // The dispatch writes the arguments of camera i at i * cullInstances.size(), in the same order.
+        for (size_t pass = 0; pass < cameras.size(); pass++)
+        {
+            size_t first = pass * cullInstances.size();
+
+            frustums.push_back(Frustum(cameras[pass]->getViewProj()));
+
+            for (size_t i = 0; i < passDraws.size(); i++)
+            {
+                if (i == 0 || passDraws[i].block != passDraws[i - 1].block)
+                {
+                    indirectBatches.push_back({ pass, passDraws[i].block, first + i, 0 });
+                }
+
+                indirectBatches.back().count++;
+            }
+        }
+    }
+
+    void RenderSystem::addStaticMesh(Mesh* mesh)
+    {
+        bool packed = mesh->isPacked();
+        uint32 count = static_cast<uint32>(mesh->vertices.size());
+        size_t stride = packed ? getVertexElementBytes(Mesh::getPackedPositionLayout().elements[0]) : sizeof(math::vec3);
+        size_t index = 0;
+
+        while (index < staticBlocks.size() && (staticBlocks[index].packed != packed || staticBlocks[index].capacity - staticBlocks[index].count < count))
+        {
+            index++;
+        }
+
+        if (index == staticBlocks.size())
+        {
+            StaticBlock block = { nullptr, packed, std::max(STATIC_BLOCK_VERTICES, count), 0 };
+            size_t size = block.capacity * stride;
+
+            // Blocks are allocated once and only written by copies on the GPU.
+            runOnDevice([this, &block, size]()
+            {
+                block.buffer = device->createBuffer(BufferType::VERTEX, BufferUsage::STATIC, size);
+                device->copyData(block.buffer, size, nullptr);
+            });
+
+            staticBlocks.push_back(block);
+        }
+
+        StaticBlock& block = staticBlocks[index];
+
+        commands->copyBufferData(mesh->getPositionBuffer(), 0, block.buffer, block.count * stride, count * stride);
+
+        mesh->staticBlock = static_cast<int32>(index);
+        mesh->staticFirst = block.count;
+        block.count += count;
+    }
+
+    void RenderSystem::renderDeferred()
+    {
+        // Geometry pass, only lit models write to the G-buffer.
+        commands->bindRenderTarget(gBuffer);
+        commands->clear(0.0f, 0.0f, 0.0f, 0.0f);
+
+        if (depthPrePass)
+        {
+            renderDepthPrePass();
+        }
+
+        deferredPass = DeferredPass::GEOMETRY;
+        renderMainQueue();
+        renderOcclusionQueries();
+
+        // Light accumulation, a full screen triangle per camera using the clustered light lists.
+        commands->bindRenderTarget(lightBuffer);
+        commands->clear(0.0f, 0.0f, 0.0f, 0.0f);
+
+        commands->bindPipeline(deferredLightPipeline);
+
+        for (size_t i = 0; i < gBuffer->count; i++)
+        {
+            commands->bindTexture(gBuffer->textures[i], i);
+        }
+
+        commands->bindStorageBuffer(dirLightBuffer, DIR_LIGHT_SLOT);
+        commands->bindStorageBuffer(pointLightBuffer, POINT_LIGHT_SLOT);
+        commands->bindStorageBuffer(clusterBuffer, CLUSTER_SLOT);
+        commands->bindStorageBuffer(lightIndexBuffer, LIGHT_INDEX_SLOT);
+
+        deferredPixelUniformData.numofdl = (float)dirLightData.size();
+
+        for (size_t i = 0; i < cameras.size(); i++)
+        {
+            Viewport* viewport = cameras[i]->getViewport();
+
+            commands->bindViewport(viewport);
+
+            deferredPixelUniformData.inverseViewProj = math::inverse(cameras[i]->getViewProj());
+            deferredPixelUniformData.viewport = math::vec4(viewport->x, viewport->y, viewport->width, viewport->height);
+            deferredPixelUniformData.CamPos = math::vec4(cameras[i]->getComponent<TransformComponent>()->getPosition(), 1.0f);
+            deferredPixelUniformData.cluster = lightGrid.getCameraData(i);
+
+            commands->bindPixelUniformBuffer(deferredPixelUniformBuffer, 1);
+            commands->copyData(deferredPixelUniformBuffer, sizeof(deferredPixelUniformData), &deferredPixelUniformData);
+
+            commands->draw(3);
+        }
+
+        for (size_t i = 0; i < gBuffer->count; i++)
+        {
+            commands->debindTexture(gBuffer->textures[i], i);
+        }
+
+        commands->debindPipeline(deferredLightPipeline);
+
+        // Composite over the render target set by the user, this also restores the depth.
+        if (renderTarget)
+        {
+            commands->bindRenderTarget(renderTarget);
+        }
+        else
+        {
+            commands->debindRenderTarget();
+        }
+
+        commands->bindPipeline(compositePipeline);
+        commands->bindTexture(lightBuffer->textures[0], 0);
+        commands->bindTexture(gBuffer->textures[3], 1);
+
+        for (auto camera : cameras)
+        {
+            commands->bindViewport(camera->getViewport());
+            commands->draw(3);
+        }
+
+        commands->debindTexture(lightBuffer->textures[0], 0);
+        commands->debindTexture(gBuffer->textures[3], 1);
+        commands->debindPipeline(compositePipeline);
+
+        // Unlit models, sprites and texts are drawn forward on top.
+        deferredPass = DeferredPass::FORWARD;
+        renderQueue();
+    }
+
+    bool RenderSystem::isInCurrentPass(bool lit) const
+    {
+        if (depthPass)
+        {
+            return lit;
+        }
+
+        return renderPath == RenderPath::FORWARD || lit == (deferredPass == DeferredPass::GEOMETRY);
+    }
+
+    Pipeline* RenderSystem::getModelPipeline(ModelComponent* model) const
+    {
+        // In the deferred path lit models are drawn into the G-buffer. Forward pipelines have to match
+        // the vertex format of the model themselves.
+        if (renderPath == RenderPath::DEFERRED && model->isLit())
+        {
+            return model->getModelResource()->hasPackedVertices() ? gBufferPackedPipeline : gBufferPipeline;
+        }
+
+        return model->getPipeline();
+    }
+
+    void RenderSystem::addMaterials(ModelComponent* model)
+    {
+        const std::vector<Mesh*>& meshes = model->getModelResource()->getMeshes();
+
+        for (auto mesh : meshes)
+        {
+            if (!materialTable->contains(mesh))
+            {
+                // The textures are uploaded into the arrays, which happens once per mesh.
+                runOnDevice([&]()
+                {
+                    for (auto added : meshes)
+                    {
+                        materialTable->add(added);
+                    }
+                });
+
+                return;
+            }
+        }
+    }
+
+    uint32 RenderSystem::getMaterialFeatures(ModelComponent* model, const Mesh* mesh) const
+    {
+        uint32 features = 0;
+
+        if (mesh->diffuseTexture)
+        {
+            features |= DIFFUSE_TEXTURE_FEATURE;
+        }
+
+        if (mesh->normalTexture)
+        {
+            features |= NORMAL_TEXTURE_FEATURE;
+        }
+
+        if (mesh->specularTexture)
+        {
+            features |= SPECULAR_TEXTURE_FEATURE;
+        }
+
+        // The G-buffer has no reflections, so the cube map would only add an identical variant.
+        if (model->getCubeMap() && renderPath == RenderPath::FORWARD)
+        {
+            features |= CUBE_MAP_FEATURE;
+        }
+
+        if (textureArrays && (features & (DIFFUSE_TEXTURE_FEATURE | NORMAL_TEXTURE_FEATURE | SPECULAR_TEXTURE_FEATURE)) && materialTable->find(mesh))
+        {
+            features |= TEXTURE_ARRAY_FEATURE;
+        }
+
+        return features;
+    }
+
+    Pipeline* RenderSystem::getPipelineVariant(Pipeline* pipeline, uint32 features) const
+    {
+        auto variant = pipelineVariants.find(std::make_pair(pipeline, features));
+
+        // Backends without permutations draw every material with the pipeline itself.
+        return variant != pipelineVariants.end() ? variant->second : pipeline;
+    }
+
+    void RenderSystem::createPipelineVariants(ModelComponent* model)
+    {
+#ifndef DIRECTX11
+        Pipeline* pipeline = getModelPipeline(model);
+
+        for (auto mesh : model->getModelResource()->getMeshes())
+        {
+            uint32 features = getMaterialFeatures(model, mesh);
+            auto key = std::make_pair(pipeline, features);
+
+            if (pipelineVariants.find(key) != pipelineVariants.end())
+            {
+                continue;
+            }
+
+            const char* defines[MATERIAL_FEATURE_COUNT];
+            size_t count = 0;
+
+            for (size_t i = 0; i < MATERIAL_FEATURE_COUNT; i++)
+            {
+                if (features & (1 << i))
+                {
+                    defines[count++] = MATERIAL_FEATURE_DEFINES[i];
+                }
+            }
+
+            runOnDevice([&]() { pipelineVariants[key] = device->createPipelineVariant(pipeline, count, defines); });
+        }
+#endif
+    }
+
+    void RenderSystem::present()
+    {
+        SGE_ASSERT(initialized && !acceptingCommands);
+
+        if (textureManager)
+        {
+            textureManager->update(commands, textureUploadBudget);
+        }
+
+        if (textureStreamer)
+        {
+            commands->streamTextures(textureUploadBudget);
+        }
+
+        if (pipelined)
+        {
+            std::unique_lock<std::mutex> lock(renderMutex);
+
+            // At most one frame is in flight, this waits for the render thread to swap the previous one.
+            renderCondition.wait(lock, [this]() { return submittedPacket == nullptr; });
+
+            submittedPacket = &framePackets[recordedPacket];
+            renderCondition.notify_all();
+
+            lock.unlock();
+
+            // The other packet was submitted by now, so the next frame is recorded into it.
+            recordedPacket ^= 1;
+            framePackets[recordedPacket].reset();
+            commands = &framePackets[recordedPacket];
+        }
+        else
+        {
+            device->swap();
+        }
+
+        collectStats();
+        releaseOcclusionQueries(false);
+
+        frameIndex++;
+    }
+
+    void RenderSystem::collectStats()
+    {
+        // The previous frame's queries have had a whole frame to finish, so waiting rarely stalls.
+        for (auto query : pendingQueries)
+        {
+            uint64 samples = 0;
+
+            device->getQueryResult(query, samples, true);
+
+            pendingStats.samples += samples;
+            freeQueries.push_back(query);
+        }
+
+        stats = pendingStats;
+        pendingStats = frameStats;
+        frameStats = RenderStats();
+
+        pendingQueries.swap(frameQueries);
+        frameQueries.clear();
+    }
+
+    void RenderSystem::clear(int flags)
+    {
+        SGE_ASSERT(initialized && !acceptingCommands);
+
+        if (flags & RENDERTARGET)
+        {
+            commands->debindRenderTarget();
+            renderTarget = nullptr;
+        }
+
+        if (flags & QUEUE)
+        {
+            queue.clear();
+            occlusionCandidates.clear();
+            modelDraws.clear();
+            indirectModels.clear();
+        }
+
+        if (flags & COLOR || flags & DEPTH || flags & STENCIL)
+        {
+            commands->clear(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+        }
+
+        if (flags & LIGHTS)
+        {
+            pointLights.clear();
+            spotLights.clear();
+            dirLights.clear();
+        }
+
+        if (flags & CAMERAS)
+        {
+            cameras.clear();
+        }
+    }
+
+    void RenderSystem::renderSprite(SpriteComponent* sprite)
+    {
+        static size_t pass = 0;
+
+        SGE_ASSERT(cameras.size() > pass);
+
+        if (!isInCurrentPass(false))
+        {
+            if (++pass >= cameras.size())
+                pass = 0;
+
+            return;
+        }
+
+        Pipeline* pipeline = sprite->getPipeline();
+        Texture* texture = sprite->getTexture();
+
+        if (texture)
+        {
+            commands->bindTexture(texture, 0);
+        }
+
+        if (pipeline)
+        {
+            commands->bindPipeline(pipeline);
+        }
+        else
+        {
+            commands->bindPipeline(sprPipeline);
+        }
+
+        commands->bindViewport(cameras[pass]->getViewport());
+
+        sprVertexUniformData.MVP = cameras[pass]->getViewProj() * sprite->getComponent<TransformComponent>()->getMatrix();
+        sprPixelUniformData.color = sprite->getColor();
+
+        commands->bindVertexUniformBuffer(sprVertexUniformBuffer, 0);
+        commands->copyData(sprVertexUniformBuffer, sizeof(sprVertexUniformData), &sprVertexUniformData);
+
+        commands->bindPixelUniformBuffer(sprPixelUniformBuffer, 1);
+        commands->copyData(sprPixelUniformBuffer, sizeof(sprPixelUniformData), &sprPixelUniformData);
+
+        commands->draw(6);
+
+        if (texture)
+        {
+            commands->debindTexture(texture, 0);
+        }
+
+        if (pipeline)
+        {
+            commands->debindPipeline(pipeline);
+        }
+        else
+        {
+            commands->debindPipeline(sprPipeline);
+        }
+
+        if (++pass >= cameras.size())
+            pass = 0;
+    }
+
+    void RenderSystem::renderText(TextComponent* text)
+    {
+        // TODO added support for multiple cameras.
+        static size_t pass = 0;
+
+        SGE_ASSERT(cameras.size() > pass);
+
+        if (!isInCurrentPass(false))
+        {
+            if (++pass >= cameras.size())
+                pass = 0;
+
+            return;
+        }
+
+        commands->bindPipeline(textPipeline);
+
+        sge::Font* font = text->getFont();
+        FT_GlyphSlot slot = font->face->glyph;
+
+        // Updates textures if text has changed since previous rendering
+        if (text->getText() != previousText)
+        {
+            while (charTextures.size() != 0)
+            {
+                charTextures.erase(charTextures.begin());
+                characters.erase(characters.begin());
+            }
+
+			// Goes through all characters, loads them and stores the glyph info and textures needed to render text for later use
+			// in order to make the actual drawing faster and more efficient.
+            runOnDevice([&]()
+            {
+                for (size_t i = 0; i < text->getText().size(); i++)
+                {
+                    FT_Load_Char(font->face, text->getText()[i], FT_LOAD_RENDER);
+
+                    sge::Texture* texture = device->createTextTexture(slot->bitmap.width, slot->bitmap.rows, slot->bitmap.buffer);
+
+                    Character character;
+                    character.size = sge::math::vec2(slot->bitmap.width, slot->bitmap.rows);
+                    character.horiBearing = sge::math::vec2(slot->metrics.horiBearingX, slot->metrics.horiBearingY);
+                    character.vertBearing = sge::math::vec2(slot->metrics.vertBearingX, slot->metrics.vertBearingY);
+                    character.metrics = sge::math::vec2(slot->metrics.width, slot->metrics.height);
+				    character.advance = sge::math::vec2(slot->advance.x / 32, slot->advance.y / 32);
+                    characters.push_back(character);
+
+                    charTextures.push_back(texture);
+                }
+            });
+
+            previousText = text->getText();
+        }
+
+        // Render text
+        sge::math::vec2 pen = { 0, 0 }; // The position where the character is drawn.
+        sge::math::vec3 originalPosition = text->getParent()->getComponent<TransformComponent>()->getPosition();
+        sge::math::vec3 originalScale = text->getParent()->getComponent<TransformComponent>()->getScale();
+        for (size_t i = 0; i < text->getText().size(); i++)
+        {
+            sge::Texture* texture = charTextures[i];
+
+            if (texture)
+            {
+                commands->bindTexture(texture, 0);
+            }
+
+			// Calculates the y position of current character.
+            pen.y = characters[i].vertBearing.y / 32 - font->characterSize;
+            if (characters[i].metrics.y / 64 - characters[i].horiBearing.y / 64 > 0)
+            {
+                pen.y += characters[i].metrics.y / 64 - characters[i].horiBearing.y / 64;
+            }
+
+			// Places the character in its desired position.
+            text->getComponent<TransformComponent>()->setPosition(originalPosition + glm::vec3(pen.x, pen.y, 0));
+            text->getComponent<TransformComponent>()->setScale(originalScale * sge::math::vec3(characters[i].size.x, characters[i].size.y, 1));
+
+            commands->bindViewport(cameras[pass]->getViewport());
+
+            sprVertexUniformData.MVP = cameras[pass]->getViewProj() * text->getComponent<TransformComponent>()->getMatrix();
+			sge::math::mat4 testi = text->getComponent<TransformComponent>()->getMatrix();
+            sprPixelUniformData.color = text->getColor();
+
+			// Calculates the x position of the next character.
+			pen.x += originalScale.x * characters[i].advance.x;
+
+            commands->bindVertexUniformBuffer(sprVertexUniformBuffer, 0);
+            commands->copyData(sprVertexUniformBuffer, sizeof(sprVertexUniformData), &sprVertexUniformData);
+            commands->bindPixelUniformBuffer(sprPixelUniformBuffer, 1);
+            commands->copyData(sprPixelUniformBuffer, sizeof(sprPixelUniformData), &sprPixelUniformData);
+
+            commands->draw(6);
+
+            if (texture)
+            {
+                commands->debindTexture(texture, 0);
+            }
+        }
+
+        text->getComponent<TransformComponent>()->setPosition(originalPosition);
+        text->getComponent<TransformComponent>()->setScale(originalScale);
+        commands->debindPipeline(textPipeline);
+
+        if (++pass >= cameras.size())
+            pass = 0;
+    }
+
+    void RenderSystem::renderModel(ModelComponent* model)
+    {
+        static size_t pass = 0;
+
+        SGE_ASSERT(cameras.size() > pass);
+
+        recordModel(commands, model, pass, frameStats);
+
+        if (++pass >= cameras.size())
+            pass = 0;
+    }
+
+    template <typename Target>
+    void RenderSystem::recordModel(Target* target, ModelComponent* model, size_t pass, RenderStats& stats) const
+    {
+        if (!isInCurrentPass(model->isLit()))
+        {
+            return;
+        }
+
+        if (occlusionCulling && isOccluded(model, cameras[pass]))
+        {
+            if (!depthPass)
+            {
+                stats.occludedModels++;
+            }
+
+            return;
+        }
+
+        if (depthPass)
+        {
+            recordModelDepth(target, model, pass, stats);
+
+            return;
+        }
+
+        // Lit models are already in the depth buffer, so only their visible surface is shaded.
+        bool equalDepth = depthPrePass && model->isLit();
+
+        Pipeline* pipeline = getModelPipeline(model);
+
+        // Local copies, several threads may be recording models at once.
+        ModelVertexUniformData vertexUniformData = modelVertexUniformData;
+        ModelPixelUniformData pixelUniformData = modelPixelUniformData;
+
+        target->bindViewport(cameras[pass]->getViewport());
+
+        vertexUniformData.M = model->getComponent<TransformComponent>()->getMatrix();
+        vertexUniformData.PV = cameras[pass]->getViewProj();
+		vertexUniformData.shininess = model->getShininess();
+        pixelUniformData.CamPos = math::vec4(cameras[pass]->getComponent<TransformComponent>()->getPosition(), 1.0f);
+        pixelUniformData.cluster = lightGrid.getCameraData(pass);
+        pixelUniformData.glossyness = model->getGlossyness();
+
+        // Only what the shaders read is bound and uploaded, unlit shaders skip the lights. The variants
+        // of a pipeline differ in their textures only, so its blocks are those of every variant.
+        const PipelineReflection& reflection = pipeline->reflection;
+        size_t vertexUniformSize = reflection.getUniformSize(VERTEX_UNIFORM_SLOT, sizeof(vertexUniformData));
+        size_t pixelUniformSize = reflection.getUniformSize(PIXEL_UNIFORM_SLOT, sizeof(pixelUniformData));
+
+        if (reflection.readsStorageBlock(DIR_LIGHT_SLOT))
+        {
+            target->bindStorageBuffer(dirLightBuffer, DIR_LIGHT_SLOT);
+        }
+
+        if (reflection.readsStorageBlock(POINT_LIGHT_SLOT))
+        {
+            target->bindStorageBuffer(pointLightBuffer, POINT_LIGHT_SLOT);
+        }
+
+        if (reflection.readsStorageBlock(CLUSTER_SLOT))
+        {
+            target->bindStorageBuffer(clusterBuffer, CLUSTER_SLOT);
+        }
+
+        if (reflection.readsStorageBlock(LIGHT_INDEX_SLOT))
+        {
+            target->bindStorageBuffer(lightIndexBuffer, LIGHT_INDEX_SLOT);
+        }
+
+        // The material is in the variant, the pixel data is the same for every mesh.
+        if (pixelUniformSize)
+        {
+            target->bindPixelUniformBuffer(modelPixelUniformBuffer, PIXEL_UNIFORM_SLOT);
+            target->copyData(modelPixelUniformBuffer, pixelUniformSize, &pixelUniformData);
+        }
+
+        if (vertexUniformSize)
+        {
+            target->bindVertexUniformBuffer(modelVertexUniformBuffer, VERTEX_UNIFORM_SLOT);
+        }
+
+        Pipeline* boundPipeline = nullptr;
+        Texture* boundArrays[3] = { nullptr, nullptr, nullptr };
+        bool materialsBound = false;
+
+		for (auto mesh : model->getModelResource()->getMeshes())
+		{
+			uint32 features = model->isLit() ? getMaterialFeatures(model, mesh) : 0;
+			Pipeline* variant = model->isLit() ? getPipelineVariant(pipeline, features) : pipeline;
+			const MaterialTable::Material* material = (features & TEXTURE_ARRAY_FEATURE) ? materialTable->find(mesh) : nullptr;
+
+			if (variant != boundPipeline)
+			{
+				target->bindPipeline(variant);
+				boundPipeline = variant;
+
+				// Overrides the depth state of the pipeline, the next bind restores it.
+				if (equalDepth)
+				{
+					target->setDepthState(DepthFunction::EQUAL, false);
+				}
+			}
+
+			target->bindIndexBuffer(mesh->getIndexBuffer());
+			target->bindVertexBuffer(mesh->getVertexBuffer());
+
+			vertexUniformData.positionScale = mesh->positionScale;
+			vertexUniformData.positionOffset = mesh->positionOffset;
+			vertexUniformData.packedVertices = mesh->isPacked() ? 1 : 0;
+			vertexUniformData.material = material ? static_cast<int32>(material->index) : 0;
+
+			if (vertexUniformSize)
+			{
+				target->copyData(modelVertexUniformBuffer, vertexUniformSize, &vertexUniformData);
+			}
+
+			const PipelineReflection& variantReflection = variant->reflection;
+
+			Texture* diff = !material && variantReflection.readsSampler(0) ? mesh->diffuseTexture : nullptr;
+			Texture* norm = !material && variantReflection.readsSampler(1) ? mesh->normalTexture : nullptr;
+			Texture* spec = !material && variantReflection.readsSampler(2) ? mesh->specularTexture : nullptr;
+			CubeMap* cube = variantReflection.readsSampler(3) ? model->getCubeMap() : nullptr;
+
+			// The arrays stay bound for the following meshes, which usually share them.
+			if (material)
+			{
+				if (!materialsBound && variantReflection.readsStorageBlock(MATERIAL_SLOT))
+				{
+					target->bindStorageBuffer(materialTable->getBuffer(), MATERIAL_SLOT);
+					materialsBound = true;
+				}
+
+				for (size_t slot = 0; slot < 3; slot++)
+				{
+					Texture* array = variantReflection.readsSampler(slot) ? material->arrays[slot] : nullptr;
+
+					if (array && array != boundArrays[slot])
+					{
+						target->bindTexture(array, slot);
+						boundArrays[slot] = array;
+						stats.textureBinds++;
+					}
+				}
+			}
+
+			if (diff)
 			{
-				device->bindTexture(diff, 0);
-				modelPixelUniformData.hasDiffuseTex = 1;
+				target->bindTexture(diff, 0);
+				stats.textureBinds++;
 			}
 
 			if (norm)
 			{
-				device->bindTexture(norm, 1);
-				modelPixelUniformData.hasNormalTex = 1;
+				target->bindTexture(norm, 1);
+				stats.textureBinds++;
 			}
 
 			if (spec)
 			{
-				device->bindTexture(spec, 2);
-				modelPixelUniformData.hasSpecularTex = 1;
-			}			
-			
-			modelPixelUniformData.glossyness = model->getGlossyness();
+				target->bindTexture(spec, 2);
+				stats.textureBinds++;
+			}
 
 			if (cube)
 			{
-				device->bindCubeMap(cube, 3);
-				modelPixelUniformData.hasCubeTex = 1;
-			}			
-
-			device->bindPixelUniformBuffer(modelPixelUniformBuffer, 1);
-			device->copyData(modelPixelUniformBuffer, sizeof(modelPixelUniformData), &modelPixelUniformData);
-
-			device->draw(model->getModelResource()->getMeshes()[i]->vertices.size());
+				target->bindCubeMap(cube, 3);
+				stats.textureBinds++;
+			}
 
-			device->debindCubeMap(cube, 3);
+			target->draw(mesh->vertices.size());
+			stats.drawCalls++;
 
 			if (diff)
 			{
-				device->debindTexture(diff, 0);
-				modelPixelUniformData.hasDiffuseTex = 0;
+				target->debindTexture(diff, 0);
 			}
 
 			if (norm)
 			{
-				device->debindTexture(norm, 1);
-				modelPixelUniformData.hasNormalTex = 0;
+				target->debindTexture(norm, 1);
 			}
 
 			if (spec)
 			{
-				device->debindTexture(spec, 2);
-				modelPixelUniformData.hasSpecularTex = 0;
+				target->debindTexture(spec, 2);
 			}
 
 			if (cube)
 			{
-				device->debindCubeMap(cube, 3);
-				modelPixelUniformData.hasCubeTex = 0;
+				target->debindCubeMap(cube, 3);
 			}
-		}        
+		}
 
-        device->debindPipeline(model->getPipeline());
+        for (size_t slot = 0; slot < 3; slot++)
+        {
+            if (boundArrays[slot])
+            {
+                target->debindTexture(boundArrays[slot], slot);
+            }
+        }
 
-        if (++pass >= cameras.size())
-            pass = 0;
+        if (boundPipeline)
+        {
+            target->debindPipeline(boundPipeline);
+        }
+    }
+
+    template <typename Target>
+    void RenderSystem::recordModelDepth(Target* target, ModelComponent* model, size_t pass, RenderStats& stats) const
+    {
+        ModelVertexUniformData vertexUniformData = modelVertexUniformData;
+
+        target->bindViewport(cameras[pass]->getViewport());
+
+        vertexUniformData.M = model->getComponent<TransformComponent>()->getMatrix();
+        vertexUniformData.PV = cameras[pass]->getViewProj();
+        vertexUniformData.shininess = model->getShininess();
+
+        Pipeline* pipeline = model->getModelResource()->hasPackedVertices() ? depthPackedPipeline : depthPipeline;
+
+        target->bindPipeline(pipeline);
+
+        target->bindVertexUniformBuffer(modelVertexUniformBuffer, VERTEX_UNIFORM_SLOT);
+
+        size_t vertexUniformSize = pipeline->reflection.getUniformSize(VERTEX_UNIFORM_SLOT, sizeof(vertexUniformData));
+
+        for (auto mesh : model->getModelResource()->getMeshes())
+        {
+            // Packed positions are quantized against the bounds of every mesh.
+            vertexUniformData.positionScale = mesh->positionScale;
+            vertexUniformData.positionOffset = mesh->positionOffset;
+            vertexUniformData.packedVertices = mesh->isPacked() ? 1 : 0;
+
+            target->copyData(modelVertexUniformBuffer, vertexUniformSize, &vertexUniformData);
+            target->bindVertexBuffer(mesh->getPositionBuffer());
+            target->draw(mesh->vertices.size());
+            stats.depthDrawCalls++;
+        }
+
+        target->debindPipeline(pipeline);
+    }
+
+    void RenderSystem::recordModelDraws()
+    {
+        // Small batches aren't worth starting a thread for.
+        const size_t MIN_DRAWS_PER_THREAD = 64;
+
+        size_t threadCount = std::min(recordThreads, (modelDraws.size() + MIN_DRAWS_PER_THREAD - 1) / MIN_DRAWS_PER_THREAD);
+        threadCount = std::max(threadCount, size_t(1));
+
+        if (commandLists.size() < threadCount)
+        {
+            commandLists.resize(threadCount);
+            recordStats.resize(threadCount);
+        }
+
+        // Every thread records a contiguous part of the draws into a list of its own.
+        auto record = [this](size_t list, size_t first, size_t last)
+        {
+            CommandList& commands = commandLists[list];
+
+            commands.reset();
+            recordStats[list] = RenderStats();
+
+            for (size_t i = first; i < last; i++)
+            {
+                ModelDraw& draw = modelDraws[i];
+
+                draw.list = list;
+                draw.begin = commands.getPosition();
+                recordModel(&commands, draw.model, draw.camera, recordStats[list]);
+                draw.end = commands.getPosition();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        size_t chunk = (modelDraws.size() + threadCount - 1) / threadCount;
+
+        for (size_t i = 1; i < threadCount; i++)
+        {
+            workers.emplace_back(record, i, std::min(i * chunk, modelDraws.size()), std::min((i + 1) * chunk, modelDraws.size()));
+        }
+
+        record(0, 0, std::min(chunk, modelDraws.size()));
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+
+        for (size_t i = 0; i < threadCount; i++)
+        {
+            frameStats.drawCalls += recordStats[i].drawCalls;
+            frameStats.depthDrawCalls += recordStats[i].depthDrawCalls;
+            frameStats.occludedModels += recordStats[i].occludedModels;
+            frameStats.textureBinds += recordStats[i].textureBinds;
+        }
+    }
+
+    void RenderSystem::submitModelDraw(size_t index)
+    {
+        const ModelDraw& draw = modelDraws[index];
+
+        commands->append(commandLists[draw.list], draw.begin, draw.end);
+    }
+
+    void RenderSystem::renderOcclusionQueries()
+    {
+        if (!occlusionCulling || occlusionCandidates.empty())
+        {
+            return;
+        }
+
+        // The boxes are tested against the depth of this frame without touching the render target.
+        device->setColorWrite(false);
+
+        device->bindPipeline(occlusionPipeline);
+        device->bindVertexBuffer(boxVertexBuffer);
+
+        for (auto camera : cameras)
+        {
+            std::unordered_map<ModelComponent*, OcclusionState>& states = occlusionStates[camera];
+            math::vec3 eye = camera->getComponent<TransformComponent>()->getPosition();
+            math::vec3 margin(camera->getNear() * 2.0f);
+
+            device->bindViewport(camera->getViewport());
+
+            modelVertexUniformData.PV = camera->getViewProj();
+
+            for (auto& candidate : occlusionCandidates)
+            {
+                auto result = states.insert(std::make_pair(candidate.model, OcclusionState()));
+                OcclusionState& state = result.first->second;
+
+                if (result.second)
+                {
+                    state.query = device->createQuery(QueryType::ANY_SAMPLES_PASSED);
+                    state.pending = false;
+                    state.visible = true;
+                    state.hiddenCount = 0;
+                }
+
+                // A model coming back after some frames starts out visible.
+                if (state.lastFrame + 1 < frameIndex)
+                {
+                    state.visible = true;
+                    state.hiddenCount = 0;
+                }
+
+                state.lastFrame = frameIndex;
+
+                uint64 samples = 0;
+
+                if (state.pending)
+                {
+                    if (!device->getQueryResult(state.query, samples))
+                    {
+                        continue;
+                    }
+
+                    state.pending = false;
+
+                    // Models are shown as soon as they are seen, but hidden only after a few
+                    // frames so a box flickering at the edge of a wall doesn't make them pop.
+                    if (samples > 0)
+                    {
+                        state.visible = true;
+                        state.hiddenCount = 0;
+                    }
+                    else if (++state.hiddenCount >= OCCLUSION_HYSTERESIS)
+                    {
+                        state.visible = false;
+                    }
+                }
+
+                AABB box = candidate.bounds->getLocalBounds().transform(candidate.model->getComponent<TransformComponent>()->getMatrix());
+
+                // The box can't hide anything when the camera is inside of it or it crosses the near plane.
+                if (AABB(box.min - margin, box.max + margin).contains(AABB(eye, eye)))
+                {
+                    state.visible = true;
+                    state.hiddenCount = 0;
+
+                    continue;
+                }
+
+                modelVertexUniformData.M = math::scale(math::translate(math::mat4(1.0f), box.getCenter()), box.getExtents());
+
+                device->bindVertexUniformBuffer(modelVertexUniformBuffer, 0);
+                device->copyData(modelVertexUniformBuffer, sizeof(modelVertexUniformData), &modelVertexUniformData);
+
+                device->beginQuery(state.query);
+                device->draw(36);
+                device->endQuery(state.query);
+
+                state.pending = true;
+                frameStats.occlusionQueries++;
+            }
+        }
+
+        device->debindPipeline(occlusionPipeline);
+
+        device->setColorWrite(true);
+    }
+
+    bool RenderSystem::isOccluded(ModelComponent* model, CameraComponent* camera) const
+    {
+        auto states = occlusionStates.find(camera);
+
+        if (states == occlusionStates.end())
+        {
+            return false;
+        }
+
+        auto state = states->second.find(model);
+
+        // Results older than the previous frame say nothing about the current view.
+        return state != states->second.end() && !state->second.visible && state->second.lastFrame + 1 >= frameIndex;
+    }
+
+    void RenderSystem::releaseOcclusionQueries(bool all)
+    {
+        for (auto states = occlusionStates.begin(); states != occlusionStates.end();)
+        {
+            for (auto state = states->second.begin(); state != states->second.end();)
+            {
+                if (all || state->second.lastFrame + OCCLUSION_EXPIRE_FRAMES < frameIndex)
+                {
+                    device->deleteQuery(state->second.query);
+                    state = states->second.erase(state);
+                }
+                else
+                {
+                    ++state;
+                }
+            }
+
+            if (states->second.empty())
+            {
+                states = occlusionStates.erase(states);
+            }
+            else
+            {
+                ++states;
+            }
+        }
     }
 
     void RenderSystem::setClearColor(float r, float g, float b, float a)
@@ -531,20 +2089,78 @@ namespace sge
 
     void RenderSystem::calculateLightData()
     {
-        modelPixelUniformData.numofpl = (float)pointLights.size();
-        modelPixelUniformData.numofdl = (float)dirLights.size();
-		modelPixelUniformData.numofsl = 0.0f;
-		modelPixelUniformData.pad = 0.0f;
+        dirLightData.clear();
+        pointLightData.clear();
+
+        for (auto dirLight : dirLights)
+        {
+            dirLightData.push_back(dirLight->getLightData());
+        }
+
+        for (auto pointLight : pointLights)
+        {
+            pointLightData.push_back(pointLight->getLightData());
+        }
+
+        modelPixelUniformData.numofdl = (float)dirLightData.size();
+        modelPixelUniformData.pad[0] = 0.0f;
+        modelPixelUniformData.pad[1] = 0.0f;
+
+        copyStorageData(dirLightBuffer, DIR_LIGHT_SLOT, dirLightData.size() * sizeof(DirLight), dirLightData.data());
+        copyStorageData(pointLightBuffer, POINT_LIGHT_SLOT, pointLightData.size() * sizeof(PointLight), pointLightData.data());
+    }
+
+    void RenderSystem::calculateLightGrid()
+    {
+        // Point lights are binned per camera, directional lights reach every fragment.
+        lightGrid.build(cameras.size(), cameras.data(), pointLightData.size(), pointLightData.data());
+
+        const std::vector<LightGrid::Cluster>& clusters = lightGrid.getClusters();
+        const std::vector<uint32>& lightIndices = lightGrid.getLightIndices();
+
+        copyStorageData(clusterBuffer, CLUSTER_SLOT, clusters.size() * sizeof(LightGrid::Cluster), clusters.data());
+        copyStorageData(lightIndexBuffer, LIGHT_INDEX_SLOT, lightIndices.size() * sizeof(uint32), lightIndices.data());
+    }
+
+    void RenderSystem::copyStorageData(Buffer* buffer, size_t slot, size_t size, const void* data)
+    {
+        commands->bindStorageBuffer(buffer, slot);
+
+        // Empty storage buffers can't be bound, so keep at least a few bytes around.
+        if (size == 0)
+        {
+            commands->copyData(buffer, 16, nullptr);
+        }
+        else
+        {
+            commands->copyData(buffer, size, data);
+        }
+    }
 
-        for (size_t i = 0; i < dirLights.size(); i++)
+    void RenderSystem::calculateVisibility()
+    {
+        if (visibilityValid)
         {
-            modelPixelUniformData.dirLights[i] = dirLights[i]->getLightData();
+            return;
         }
 
-        for (size_t i = 0; i < pointLights.size(); i++)
+        visibleEntities.clear();
+
+        // Every camera is tested in a single traversal of the tree.
+        for (size_t first = 0; first < cameras.size(); first += DynamicAABBTree::MAX_BATCH)
         {
-            modelPixelUniformData.pointLights[i] = pointLights[i]->getLightData();
+            size_t count = std::min(cameras.size() - first, DynamicAABBTree::MAX_BATCH);
+            std::vector<Entity*> results[DynamicAABBTree::MAX_BATCH];
+
+            spatialSystem->queryCameras(count, &cameras[first], results);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                visibleEntities.insert(results[i].begin(), results[i].end());
+            }
         }
+
+        visibilityValid = true;
     }
 
     void RenderSystem::initShaders()
@@ -558,7 +2174,7 @@ namespace sge
         sprVertexShaderHandle = ResourceManager::getMgr().load<ShaderResource>("../Assets/Shaders/SimpleVertexShader.cso");
         sprPixelShaderHandle = ResourceManager::getMgr().load<ShaderResource>("../Assets/Shaders/SimplePixelShader.cso");
         textPixelShaderHandle = ResourceManager::getMgr().load<ShaderResource>("../Assets/Shaders/SimpleTextPixelShader.cso");
-#elif OPENGL4
+#elif defined(OPENGL4) || defined(HEADLESS)
         sprVertexShaderHandle = ResourceManager::getMgr().load<ShaderResource>("../Assets/Shaders/SimpleVertexShader.glsl");
         sprPixelShaderHandle = ResourceManager::getMgr().load<ShaderResource>("../Assets/Shaders/SimplePixelShader.glsl");
         textPixelShaderHandle = ResourceManager::getMgr().load<ShaderResource>("../Assets/Shaders/SimpleTextPixelShader.glsl");
@@ -577,8 +2193,8 @@ namespace sge
     {
         sge::VertexLayoutDescription vertexLayoutDescription = { 2,
         {
-            { 0, 3, sge::VertexSemantic::POSITION },
-            { 0, 2, sge::VertexSemantic::TEXCOORD }
+            { 0, 3, sge::VertexSemantic::POSITION, sge::VertexFormat::FLOAT },
+            { 0, 2, sge::VertexSemantic::TEXCOORD, sge::VertexFormat::FLOAT }
         } };
 
         float vertexData[] = {
@@ -591,7 +2207,12 @@ namespace sge
             1.0f, -1.0f, 0.0f, 1.0f, 1.0f,
         };
 
-        sprPipeline = device->createPipeline(&vertexLayoutDescription, sprVertexShader, sprPixelShader);
+        // Sprites are blended in queue order and leave the depth buffer alone.
+        PipelineState translucentState;
+        translucentState.blendMode = BlendMode::ALPHA;
+        translucentState.depthWrite = false;
+
+        sprPipeline = device->createPipeline(&vertexLayoutDescription, sprVertexShader, sprPixelShader, translucentState);
         sprVertexBuffer = device->createBuffer(sge::BufferType::VERTEX, sge::BufferUsage::DYNAMIC, sizeof(vertexData));
         sprVertexUniformBuffer = device->createBuffer(sge::BufferType::UNIFORM, sge::BufferUsage::DYNAMIC, sizeof(sprVertexUniformData));
         sprPixelUniformBuffer = device->createBuffer(sge::BufferType::UNIFORM, sge::BufferUsage::DYNAMIC, sizeof(sprPixelUniformData));
@@ -606,8 +2227,8 @@ namespace sge
     {
         sge::VertexLayoutDescription vertexLayoutDescription = { 2,
         {
-            { 0, 3, sge::VertexSemantic::POSITION },
-            { 0, 2, sge::VertexSemantic::TEXCOORD }
+            { 0, 3, sge::VertexSemantic::POSITION, sge::VertexFormat::FLOAT },
+            { 0, 2, sge::VertexSemantic::TEXCOORD, sge::VertexFormat::FLOAT }
         } };
 
         float vertexData[] = {
@@ -620,7 +2241,11 @@ namespace sge
             1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
         };
 
-        textPipeline = device->createPipeline(&vertexLayoutDescription, sprVertexShader, textPixelShader);
+        PipelineState translucentState;
+        translucentState.blendMode = BlendMode::ALPHA;
+        translucentState.depthWrite = false;
+
+        textPipeline = device->createPipeline(&vertexLayoutDescription, sprVertexShader, textPixelShader, translucentState);
         textVertexBuffer = device->createBuffer(sge::BufferType::VERTEX, sge::BufferUsage::DYNAMIC, sizeof(vertexData));
 
         device->bindPipeline(textPipeline);
@@ -631,7 +2256,191 @@ namespace sge
 
     void RenderSystem::initModelRendering()
     {
+        modelVertexUniformData.positionScale = math::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+        modelVertexUniformData.positionOffset = math::vec4(0.0f);
+        modelVertexUniformData.packedVertices = 0;
+
         modelVertexUniformBuffer = device->createBuffer(BufferType::UNIFORM, BufferUsage::DYNAMIC, sizeof(modelVertexUniformData));
         modelPixelUniformBuffer = device->createBuffer(BufferType::UNIFORM, BufferUsage::DYNAMIC, sizeof(modelPixelUniformData));
+
+        dirLightBuffer = device->createBuffer(BufferType::STORAGE, BufferUsage::DYNAMIC, 0);
+        pointLightBuffer = device->createBuffer(BufferType::STORAGE, BufferUsage::DYNAMIC, 0);
+        clusterBuffer = device->createBuffer(BufferType::STORAGE, BufferUsage::DYNAMIC, 0);
+        lightIndexBuffer = device->createBuffer(BufferType::STORAGE, BufferUsage::DYNAMIC, 0);
+    }
+
+    void RenderSystem::initDeferredRendering()
+    {
+        Handle<ShaderResource> gBufferVertexShaderHandle;
+        Handle<ShaderResource> gBufferPixelShaderHandle;
+        Handle<ShaderResource> fullscreenVertexShaderHandle;
+        Handle<ShaderResource> deferredLightPixelShaderHandle;
+        Handle<ShaderResource> compositePixelShaderHandle;
+
+        gBufferVertexShaderHandle = ResourceManager::getMgr().load<ShaderResource>("../Assets/Shaders/VertexShaderLights.glsl");
+        gBufferPixelShaderHandle = ResourceManager::getMgr().load<ShaderResource>("../Assets/Shaders/PixelShaderGBuffer.glsl");
+        fullscreenVertexShaderHandle = ResourceManager::getMgr().load<ShaderResource>("../Assets/Shaders/VertexShaderFullscreen.glsl");
+        deferredLightPixelShaderHandle = ResourceManager::getMgr().load<ShaderResource>("../Assets/Shaders/PixelShaderDeferredLights.glsl");
+        compositePixelShaderHandle = ResourceManager::getMgr().load<ShaderResource>("../Assets/Shaders/PixelShaderComposite.glsl");
+
+        const std::vector<char>& gBufferVertexShaderData = gBufferVertexShaderHandle.getResource<ShaderResource>()->loadShader();
+        const std::vector<char>& gBufferPixelShaderData = gBufferPixelShaderHandle.getResource<ShaderResource>()->loadShader();
+        const std::vector<char>& fullscreenVertexShaderData = fullscreenVertexShaderHandle.getResource<ShaderResource>()->loadShader();
+        const std::vector<char>& deferredLightPixelShaderData = deferredLightPixelShaderHandle.getResource<ShaderResource>()->loadShader();
+        const std::vector<char>& compositePixelShaderData = compositePixelShaderHandle.getResource<ShaderResource>()->loadShader();
+
+        gBufferVertexShader = device->createShader(ShaderType::VERTEX, gBufferVertexShaderData.data(), gBufferVertexShaderData.size());
+        gBufferPixelShader = device->createShader(ShaderType::PIXEL, gBufferPixelShaderData.data(), gBufferPixelShaderData.size());
+        fullscreenVertexShader = device->createShader(ShaderType::VERTEX, fullscreenVertexShaderData.data(), fullscreenVertexShaderData.size());
+        deferredLightPixelShader = device->createShader(ShaderType::PIXEL, deferredLightPixelShaderData.data(), deferredLightPixelShaderData.size());
+        compositePixelShader = device->createShader(ShaderType::PIXEL, compositePixelShaderData.data(), compositePixelShaderData.size());
+
+        // Same layout as the models drawn with VertexShaderLights.glsl.
+        VertexLayoutDescription modelLayoutDescription = { 5,
+        {
+            { 0, 3, VertexSemantic::POSITION, VertexFormat::FLOAT },
+            { 0, 3, VertexSemantic::NORMAL, VertexFormat::FLOAT },
+            { 0, 3, VertexSemantic::TANGENT, VertexFormat::FLOAT },
+            { 0, 3, VertexSemantic::BINORMAL, VertexFormat::FLOAT },
+            { 0, 2, VertexSemantic::TEXCOORD, VertexFormat::FLOAT }
+        } };
+
+        // The full screen triangle is generated from gl_VertexID.
+        VertexLayoutDescription emptyLayoutDescription = {};
+
+        VertexLayoutDescription packedLayoutDescription = Mesh::getPackedLayout();
+
+        gBufferPipeline = device->createPipeline(&modelLayoutDescription, gBufferVertexShader, gBufferPixelShader);
+        gBufferPackedPipeline = device->createPipeline(&packedLayoutDescription, gBufferVertexShader, gBufferPixelShader);
+        // The light buffer has no depth, so the light pass neither tests nor writes it.
+        PipelineState lightState;
+        lightState.depthFunction = DepthFunction::ALWAYS;
+        lightState.depthWrite = false;
+
+        deferredLightPipeline = device->createPipeline(&emptyLayoutDescription, fullscreenVertexShader, deferredLightPixelShader, lightState);
+        compositePipeline = device->createPipeline(&emptyLayoutDescription, fullscreenVertexShader, compositePixelShader);
+
+        // Albedo, normal and shininess, specular color, depth.
+        Format gBufferFormats[] = { Format::RGBA, Format::RGBA16F, Format::RGBA, Format::R32F };
+        Format lightBufferFormats[] = { Format::RGBA16F };
+
+        gBuffer = device->createRenderTarget(4, gBufferFormats, window.getWidth(), window.getHeight(), true);
+        lightBuffer = device->createRenderTarget(1, lightBufferFormats, window.getWidth(), window.getHeight());
+
+        deferredPixelUniformBuffer = device->createBuffer(BufferType::UNIFORM, BufferUsage::DYNAMIC, sizeof(deferredPixelUniformData));
+    }
+
+    void RenderSystem::initDepthRendering()
+    {
+        Handle<ShaderResource> depthVertexShaderHandle;
+        Handle<ShaderResource> depthPixelShaderHandle;
+
+        depthVertexShaderHandle = ResourceManager::getMgr().load<ShaderResource>("../Assets/Shaders/VertexShaderDepth.glsl");
+        depthPixelShaderHandle = ResourceManager::getMgr().load<ShaderResource>("../Assets/Shaders/PixelShaderDepth.glsl");
+
+        const std::vector<char>& depthVertexShaderData = depthVertexShaderHandle.getResource<ShaderResource>()->loadShader();
+        const std::vector<char>& depthPixelShaderData = depthPixelShaderHandle.getResource<ShaderResource>()->loadShader();
+
+        depthVertexShader = device->createShader(ShaderType::VERTEX, depthVertexShaderData.data(), depthVertexShaderData.size());
+        depthPixelShader = device->createShader(ShaderType::PIXEL, depthPixelShaderData.data(), depthPixelShaderData.size());
+
+        // Reads Mesh::positionBuffer instead of the interleaved vertices.
+        VertexLayoutDescription positionLayoutDescription = { 1,
+        {
+            { 0, 3, VertexSemantic::POSITION, VertexFormat::FLOAT }
+        } };
+
+        VertexLayoutDescription packedPositionLayoutDescription = Mesh::getPackedPositionLayout();
+
+        depthPipeline = device->createPipeline(&positionLayoutDescription, depthVertexShader, depthPixelShader);
+        depthPackedPipeline = device->createPipeline(&packedPositionLayoutDescription, depthVertexShader, depthPixelShader);
+    }
+
+    void RenderSystem::initIndirectRendering()
+    {
+        if (!depthPipeline)
+        {
+            initDepthRendering();
+        }
+
+        Handle<ShaderResource> indirectDepthVertexShaderHandle;
+
+        indirectDepthVertexShaderHandle = ResourceManager::getMgr().load<ShaderResource>("../Assets/Shaders/VertexShaderDepthIndirect.glsl");
+
+        const std::vector<char>& indirectDepthVertexShaderData = indirectDepthVertexShaderHandle.getResource<ShaderResource>()->loadShader();
+
+        indirectDepthVertexShader = device->createShader(ShaderType::VERTEX, indirectDepthVertexShaderData.data(), indirectDepthVertexShaderData.size());
+
+        // The static blocks hold the same positions as Mesh::positionBuffer.
+        VertexLayoutDescription positionLayoutDescription = { 1,
+        {
+            { 0, 3, VertexSemantic::POSITION, VertexFormat::FLOAT }
+        } };
+
+        VertexLayoutDescription packedPositionLayoutDescription = Mesh::getPackedPositionLayout();
+
+        indirectDepthPipeline = device->createPipeline(&positionLayoutDescription, indirectDepthVertexShader, depthPixelShader);
+        indirectDepthPackedPipeline = device->createPipeline(&packedPositionLayoutDescription, indirectDepthVertexShader, depthPixelShader);
+
+        indirectBuffer = device->createBuffer(BufferType::INDIRECT, BufferUsage::DYNAMIC, 0);
+        drawDataBuffer = device->createBuffer(BufferType::STORAGE, BufferUsage::DYNAMIC, 0);
+    }
+
+    void RenderSystem::initGpuCulling()
+    {
+        Handle<ShaderResource> cullShaderHandle;
+
+        cullShaderHandle = ResourceManager::getMgr().load<ShaderResource>("../Assets/Shaders/ComputeShaderCulling.glsl");
+
+        const std::vector<char>& cullShaderData = cullShaderHandle.getResource<ShaderResource>()->loadShader();
+
+        cullShader = device->createShader(ShaderType::COMPUTE, cullShaderData.data(), cullShaderData.size());
+        cullPipeline = device->createComputePipeline(cullShader);
+
+        cullInstanceBuffer = device->createBuffer(BufferType::STORAGE, BufferUsage::DYNAMIC, 0);
+        frustumBuffer = device->createBuffer(BufferType::STORAGE, BufferUsage::DYNAMIC, 0);
+    }
+
+    void RenderSystem::initOcclusionCulling()
+    {
+        if (!depthPipeline)
+        {
+            initDepthRendering();
+        }
+
+        // Unit cube, counter-clockwise seen from the outside.
+        float vertexData[] = {
+            -1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f, -1.0f,
+            -1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, -1.0f, -1.0f, -1.0f,
+            1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 1.0f,
+            1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, -1.0f, 1.0f,
+            1.0f, -1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f,
+            1.0f, -1.0f, -1.0f, -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, -1.0f,
+            -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+            -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, -1.0f,
+            -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f, -1.0f, -1.0f,
+            -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f,
+            -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+            -1.0f, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, -1.0f, 1.0f, 1.0f,
+        };
+
+        // The boxes are tested against the depth buffer without writing to it.
+        VertexLayoutDescription positionLayoutDescription = { 1,
+        {
+            { 0, 3, VertexSemantic::POSITION, VertexFormat::FLOAT }
+        } };
+
+        PipelineState occlusionState;
+        occlusionState.depthFunction = DepthFunction::LESS_EQUAL;
+        occlusionState.depthWrite = false;
+
+        occlusionPipeline = device->createPipeline(&positionLayoutDescription, depthVertexShader, depthPixelShader, occlusionState);
+
+        boxVertexBuffer = device->createBuffer(BufferType::VERTEX, BufferUsage::STATIC, sizeof(vertexData));
+
+        device->bindPipeline(depthPipeline);
+        device->bindVertexBuffer(boxVertexBuffer);
+        device->copyData(boxVertexBuffer, sizeof(vertexData), vertexData);
+        device->debindPipeline(depthPipeline);
     }
 }
\ No newline at end of file
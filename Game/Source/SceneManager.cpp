@@ -1,4 +1,5 @@
 #include "Game/SceneManager.h"
+#include "Resources/ResourceManager.h"
 
 namespace sge
 {
@@ -91,6 +92,13 @@ namespace sge
 		}
 		}
 
+		// The new scene was made before the old one released its resources, so the ones both
+		// use stayed resident. Only what the old scene alone used is left without references.
+		if (sceneAction == POP || sceneAction == CHANGE)
+		{
+			ResourceManager::getMgr().unloadUnused();
+		}
+
 		newScene = nullptr;
 		sceneAction = NONE;
 	}
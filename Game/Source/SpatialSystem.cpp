@@ -0,0 +1,132 @@
+#include <algorithm>
+
+#include "Game/SpatialSystem.h"
+#include "Game/CameraComponent.h"
+#include "Game/TransformComponent.h"
+#include "Core/Assert.h"
+
+namespace sge
+{
+	SpatialSystem::SpatialSystem(float margin) : System(),
+		tree(margin),
+		reinsertCount(0)
+	{
+	}
+
+	SpatialSystem::~SpatialSystem()
+	{
+		// Components outliving the system have no proxy to remove anymore.
+		for (BoundsComponent* comp : comps)
+		{
+			comp->system = nullptr;
+			comp->proxy = DynamicAABBTree::NULL_NODE;
+		}
+	}
+
+	void SpatialSystem::update()
+	{
+		reinsertCount = 0;
+
+		for (size_t i = 0; i < comps.size(); i++)
+		{
+			BoundsComponent* comp = comps[i];
+			uint32 version = comp->transform->getVersion();
+
+			if (version == comp->version && !comp->boundsChanged)
+			{
+				continue;
+			}
+
+			AABB bounds = comp->localBounds.transform(comp->transform->getMatrix());
+			math::vec3 displacement = bounds.getCenter() - comp->worldBounds.getCenter();
+
+			if (tree.moveProxy(comp->proxy, bounds, displacement))
+			{
+				reinsertCount++;
+			}
+
+			comp->worldBounds = bounds;
+			comp->version = version;
+			comp->boundsChanged = false;
+		}
+	}
+
+	void SpatialSystem::addComponent(Component* comp)
+	{
+		BoundsComponent* bounds = dynamic_cast<BoundsComponent*>(comp);
+
+		SGE_ASSERT(bounds && bounds->proxy == DynamicAABBTree::NULL_NODE);
+
+		bounds->worldBounds = bounds->localBounds.transform(bounds->transform->getMatrix());
+		bounds->version = bounds->transform->getVersion();
+		bounds->boundsChanged = false;
+		bounds->proxy = tree.createProxy(bounds->worldBounds, bounds->getParent());
+		bounds->system = this;
+
+		comps.push_back(bounds);
+	}
+
+	void SpatialSystem::removeComponent(BoundsComponent* comp)
+	{
+		SGE_ASSERT(comp->proxy != DynamicAABBTree::NULL_NODE);
+
+		tree.destroyProxy(comp->proxy);
+		comp->proxy = DynamicAABBTree::NULL_NODE;
+		comp->system = nullptr;
+
+		comps.erase(std::remove(comps.begin(), comps.end(), comp), comps.end());
+	}
+
+	void SpatialSystem::queryFrustum(const Frustum& frustum, std::vector<Entity*>& results) const
+	{
+		std::vector<void*> hits;
+
+		tree.queryFrustum(frustum, hits);
+
+		// Entity pointers are stored as the proxies' user data.
+		for (void* hit : hits)
+		{
+			results.push_back(static_cast<Entity*>(hit));
+		}
+	}
+
+	void SpatialSystem::queryCameras(size_t count, CameraComponent* cameras[], std::vector<Entity*> results[]) const
+	{
+		Frustum frustums[DynamicAABBTree::MAX_BATCH];
+		std::vector<void*> hits[DynamicAABBTree::MAX_BATCH];
+
+		SGE_ASSERT(count <= DynamicAABBTree::MAX_BATCH);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			frustums[i] = Frustum(cameras[i]->getViewProj());
+		}
+
+		tree.queryFrustums(count, frustums, hits);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			for (void* hit : hits[i])
+			{
+				results[i].push_back(static_cast<Entity*>(hit));
+			}
+		}
+	}
+
+	void SpatialSystem::querySphere(const Sphere& sphere, std::vector<Entity*>& results) const
+	{
+		std::vector<void*> hits;
+
+		tree.querySphere(sphere, hits);
+
+		for (void* hit : hits)
+		{
+			results.push_back(static_cast<Entity*>(hit));
+		}
+	}
+
+	void SpatialSystem::queryRay(const Ray& ray, std::vector<RayHit>& results) const
+	{
+		tree.queryRay(ray, results);
+	}
+}
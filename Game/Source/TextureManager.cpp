@@ -0,0 +1,286 @@
+#include <algorithm>
+
+#include "Game/TextureManager.h"
+#include "Renderer/CommandList.h"
+#include "Resources/BlockCompression.h"
+#include "Resources/TextureResource.h"
+#include "Core/Assert.h"
+
+namespace sge
+{
+	namespace
+	{
+		// Evicted textures keep the levels up to this size, enough for objects far away.
+		const size_t FALLBACK_SIZE = 64;
+	}
+
+	TextureManager::TextureManager() :
+		budget(0), residentSize(0), frame(1)
+	{
+	}
+
+	void TextureManager::use(Texture* texture, TextureResource* source, float screenSize)
+	{
+		if (!texture || !source || !source->getData())
+		{
+			return;
+		}
+
+		auto it = entries.find(texture);
+
+		if (it == entries.end())
+		{
+			Entry entry;
+			entry.texture = texture;
+			entry.source = source;
+			entry.firstLevel = 0;
+			entry.targetLevel = 0;
+			entry.lastUsed = 0;
+			entry.screenSize = 0.0f;
+
+			size_t width = source->getSize().x;
+			size_t height = source->getSize().y;
+			size_t count = source->isCooked() ? source->getLevels() : 0;
+
+			// Uncooked textures have the full chain the device generates for them.
+			for (size_t level = 0; source->isCooked() ? level < count : (width >> level) > 0 || (height >> level) > 0; level++)
+			{
+				size_t levelWidth = width >> level ? width >> level : 1;
+				size_t levelHeight = height >> level ? height >> level : 1;
+
+				entry.sizes.push_back(source->isCooked() ? source->getLevelSize(level) : getImageSize(Format::RGBA, levelWidth, levelHeight));
+			}
+
+			entry.fallbackLevel = entry.sizes.size() - 1;
+
+			for (size_t level = 0; level < entry.sizes.size(); level++)
+			{
+				if ((width >> level) <= FALLBACK_SIZE && (height >> level) <= FALLBACK_SIZE)
+				{
+					entry.fallbackLevel = level;
+					break;
+				}
+			}
+
+			SGE_ASSERT(entry.sizes.size() <= 16);
+
+			residentSize += getSize(entry, 0);
+			it = entries.emplace(texture, std::move(entry)).first;
+		}
+
+		Entry& entry = it->second;
+
+		// A texture drawn several times needs the detail of its largest use.
+		if (entry.lastUsed != frame)
+		{
+			entry.lastUsed = frame;
+			entry.screenSize = screenSize;
+		}
+		else
+		{
+			entry.screenSize = std::max(entry.screenSize, screenSize);
+		}
+	}
+
+	void TextureManager::remove(Texture* texture)
+	{
+		auto it = entries.find(texture);
+
+		if (it != entries.end())
+		{
+			residentSize -= getSize(it->second, it->second.firstLevel);
+			entries.erase(it);
+		}
+	}
+
+	void TextureManager::update(CommandList* commands, size_t uploadBudget)
+	{
+		candidates.clear();
+
+		size_t total = 0;
+
+		for (auto& pair : entries)
+		{
+			Entry& entry = pair.second;
+
+			if (budget == 0)
+			{
+				entry.targetLevel = 0;
+			}
+			else if (entry.lastUsed == frame)
+			{
+				// A level of slack, so objects moving around the size of a level don't change it every frame.
+				size_t wanted = getWantedLevel(entry);
+				entry.targetLevel = wanted < entry.firstLevel || wanted > entry.firstLevel + 1 ? wanted : entry.firstLevel;
+			}
+			else
+			{
+				entry.targetLevel = entry.firstLevel;
+			}
+
+			total += getSize(entry, entry.targetLevel);
+			candidates.push_back(&entry);
+		}
+
+		if (budget > 0 && total > budget)
+		{
+			// The textures unused for the longest time are evicted first.
+			std::sort(candidates.begin(), candidates.end(), [](const Entry* a, const Entry* b) { return a->lastUsed < b->lastUsed; });
+
+			for (auto entry : candidates)
+			{
+				if (total <= budget || entry->lastUsed == frame)
+				{
+					break;
+				}
+
+				if (entry->targetLevel < entry->fallbackLevel)
+				{
+					total -= getSize(*entry, entry->targetLevel) - getSize(*entry, entry->fallbackLevel);
+					entry->targetLevel = entry->fallbackLevel;
+				}
+			}
+
+			// Then the textures in use lose their largest levels, the largest one first.
+			while (total > budget)
+			{
+				Entry* largest = nullptr;
+
+				for (auto entry : candidates)
+				{
+					if (entry->targetLevel < entry->fallbackLevel &&
+						(!largest || entry->sizes[entry->targetLevel] > largest->sizes[largest->targetLevel]))
+					{
+						largest = entry;
+					}
+				}
+
+				if (!largest)
+				{
+					break;
+				}
+
+				total -= largest->sizes[largest->targetLevel];
+				largest->targetLevel++;
+			}
+		}
+
+		// Dropping levels uploads nothing, so it is never deferred.
+		for (auto entry : candidates)
+		{
+			if (entry->targetLevel > entry->firstLevel)
+			{
+				setLevels(commands, *entry, entry->targetLevel);
+			}
+		}
+
+		// The textures largest on screen are restored first.
+		candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [](const Entry* entry) { return entry->targetLevel >= entry->firstLevel; }), candidates.end());
+		std::sort(candidates.begin(), candidates.end(), [](const Entry* a, const Entry* b) { return a->screenSize > b->screenSize; });
+
+		size_t uploaded = 0;
+
+		for (auto entry : candidates)
+		{
+			size_t level = entry->firstLevel;
+
+			while (level > entry->targetLevel && (uploaded == 0 || uploaded + entry->sizes[level - 1] <= uploadBudget))
+			{
+				uploaded += entry->sizes[level - 1];
+				level--;
+			}
+
+			if (level == entry->firstLevel)
+			{
+				break;
+			}
+
+			setLevels(commands, *entry, level);
+		}
+
+		frame++;
+	}
+
+	size_t TextureManager::getSize(const Entry& entry, size_t firstLevel) const
+	{
+		size_t size = 0;
+
+		for (size_t level = firstLevel; level < entry.sizes.size(); level++)
+		{
+			size += entry.sizes[level];
+		}
+
+		return size;
+	}
+
+	size_t TextureManager::getWantedLevel(const Entry& entry) const
+	{
+		// Each level halves the texels, the smallest level with a texel per pixel is enough.
+		float size = static_cast<float>(std::max(entry.source->getSize().x, entry.source->getSize().y));
+		size_t level = 0;
+
+		while (level < entry.fallbackLevel && size * 0.5f >= entry.screenSize)
+		{
+			size *= 0.5f;
+			level++;
+		}
+
+		return level;
+	}
+
+	void TextureManager::createLevels(Entry& entry)
+	{
+		if (!entry.levels.empty())
+		{
+			return;
+		}
+
+		TextureResource* source = entry.source;
+
+		if (source->isCooked())
+		{
+			for (size_t level = 0; level < entry.sizes.size(); level++)
+			{
+				entry.levels.push_back(source->getLevelData(level));
+			}
+
+			return;
+		}
+
+		// The device generated the levels of an uncooked texture, so the dropped ones are filtered again here.
+		entry.mips.resize(getSize(entry, 1));
+		createMipChain(source->getData(), source->getSize().x, source->getSize().y, entry.sizes.size(), entry.mips.data());
+
+		entry.levels.push_back(source->getData());
+
+		size_t offset = 0;
+
+		for (size_t level = 1; level < entry.sizes.size(); level++)
+		{
+			entry.levels.push_back(entry.mips.data() + offset);
+			offset += entry.sizes[level];
+		}
+	}
+
+	void TextureManager::setLevels(CommandList* commands, Entry& entry, size_t firstLevel)
+	{
+		restoredLevels.assign(entry.sizes.size(), nullptr);
+
+		// Only the restored levels are uploaded, the device copies the others. The pixels stay in the
+		// entry, so a recorded list can be submitted later.
+		if (firstLevel < entry.firstLevel)
+		{
+			createLevels(entry);
+
+			for (size_t level = firstLevel; level < entry.firstLevel; level++)
+			{
+				restoredLevels[level] = entry.levels[level];
+			}
+		}
+
+		commands->setTextureLevels(entry.texture, entry.sizes.size(), firstLevel, restoredLevels.data(), entry.sizes.data());
+
+		residentSize = residentSize - getSize(entry, entry.firstLevel) + getSize(entry, firstLevel);
+		entry.firstLevel = firstLevel;
+	}
+}
@@ -0,0 +1,172 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "stb_image.h"
+
+#include "Game/TextureStreamer.h"
+#include "Renderer/GraphicsDevice.h"
+#include "Core/Assert.h"
+
+namespace sge
+{
+	TextureStreamer::TextureStreamer(GraphicsDevice* device) :
+		device(device), current(nullptr), pending(0), quit(false)
+	{
+#ifdef OPENGL4
+		// Same orientation as TextureResource.
+		stbi_set_flip_vertically_on_load(true);
+#endif
+
+		thread = std::thread(&TextureStreamer::run, this);
+	}
+
+	TextureStreamer::~TextureStreamer()
+	{
+		stop();
+	}
+
+	bool TextureStreamer::readSize(const std::string& path, size_t& width, size_t& height)
+	{
+		int x, y, components;
+
+		if (!stbi_info(path.c_str(), &x, &y, &components))
+		{
+			return false;
+		}
+
+		width = x;
+		height = y;
+
+		return true;
+	}
+
+	void TextureStreamer::stream(Texture* texture, const std::string& path)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			SGE_ASSERT(!quit);
+
+			requests.push_back({ texture, path });
+			pending++;
+		}
+
+		condition.notify_all();
+	}
+
+	void TextureStreamer::cancel(Texture* texture)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (auto it = requests.begin(); it != requests.end();)
+		{
+			if (it->texture == texture)
+			{
+				it = requests.erase(it);
+				pending--;
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		// The worker reserves staging memory while holding the lock, so it either did that already or won't.
+		if (current == texture)
+		{
+			current = nullptr;
+		}
+	}
+
+	size_t TextureStreamer::getPending()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		return pending;
+	}
+
+	void TextureStreamer::stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			quit = true;
+			pending -= requests.size();
+			requests.clear();
+		}
+
+		condition.notify_all();
+
+		if (thread.joinable())
+		{
+			thread.join();
+		}
+	}
+
+	void TextureStreamer::run()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while (true)
+		{
+			condition.wait(lock, [this]() { return !requests.empty() || quit; });
+
+			if (quit)
+			{
+				break;
+			}
+
+			Request request = requests.front();
+			requests.pop_front();
+			current = request.texture;
+
+			lock.unlock();
+
+			int width, height, components;
+			unsigned char* pixels = stbi_load(request.path.c_str(), &width, &height, &components, STBI_rgb_alpha);
+
+			if (pixels)
+			{
+				size_t size = static_cast<size_t>(width) * height * 4;
+				void* staging = nullptr;
+				uint32 ticket = 0;
+
+				lock.lock();
+
+				// The staging memory frees up as the device copies earlier textures, a frame at a time.
+				while (current && !quit)
+				{
+					staging = device->beginTextureUpload(current, size, ticket);
+
+					if (staging)
+					{
+						break;
+					}
+
+					lock.unlock();
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					lock.lock();
+				}
+
+				lock.unlock();
+
+				if (staging)
+				{
+					std::memcpy(staging, pixels, size);
+					device->endTextureUpload(ticket);
+				}
+
+				stbi_image_free(pixels);
+			}
+			else
+			{
+				std::cout << "Error streaming texture " << request.path << " : " << stbi_failure_reason() << std::endl;
+			}
+
+			lock.lock();
+			current = nullptr;
+			pending--;
+		}
+	}
+}
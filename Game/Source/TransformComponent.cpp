@@ -10,7 +10,8 @@ namespace sge
         front(0.0f, 0.0f, 1.0f),
         up(0.0f, 1.0f, 0.0f),
         left(1.0f, 0.0f, 0.0f),
-        angle(0.0f)
+        angle(0.0f),
+        version(0)
 	{
 	}
 }
\ No newline at end of file
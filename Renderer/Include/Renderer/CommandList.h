@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "Core/Types.h"
+
+#include "Renderer/Enumerations.h"
+
+namespace sge
+{
+	class GraphicsDevice;
+
+	struct Buffer;
+	struct CubeMap;
+	struct Pipeline;
+	struct Query;
+	struct RenderTarget;
+	struct Texture;
+	struct Viewport;
+
+	/** \brief Deferred GraphicsDevice calls, recorded on any thread and submitted on the render thread.
+	*
+	*	Every call is written into a byte stream as an opcode followed by its arguments. Uploads
+	*	and viewports are copied into the stream, so the source data may change once the call
+	*	returns. Recording touches no graphics state, so worker threads can fill lists of their own
+	*	while the device is only used by the thread owning the context.
+	*
+	*	getPosition marks where a group of commands starts, submit replays the whole list or a
+	*	range of it, so the render thread can interleave the groups of several lists in key order.
+	*
+	*	A list created for a device passes every call straight through instead, so code written
+	*	against a list runs unchanged whether its calls are deferred or not.
+	*/
+	class CommandList
+	{
+	public:
+		CommandList(size_t size = 0);
+		CommandList(GraphicsDevice* device);
+
+		/** \brief Drops the recorded commands and keeps the storage. */
+		void reset();
+
+		bool isEmpty() const
+		{
+			return position == 0;
+		}
+
+		bool isPassThrough() const
+		{
+			return immediateDevice != nullptr;
+		}
+
+		/** \brief Offset of the next command, a group of commands is the range between two positions. */
+		size_t getPosition() const
+		{
+			return position;
+		}
+
+		void clear(float r, float g, float b, float a);
+
+		void bindRenderTarget(RenderTarget* renderTarget);
+		void debindRenderTarget();
+
+		void bindPipeline(Pipeline* pipeline);
+		void debindPipeline(Pipeline* pipeline);
+
+		void bindVertexBuffer(Buffer* buffer);
+		void bindIndexBuffer(Buffer* buffer);
+		void bindVertexUniformBuffer(Buffer* buffer, size_t slot);
+		void bindPixelUniformBuffer(Buffer* buffer, size_t slot);
+		void bindStorageBuffer(Buffer* buffer, size_t slot);
+		void bindIndirectBuffer(Buffer* buffer);
+
+		void bindViewport(const Viewport* viewport);
+
+		void setDepthState(DepthFunction function, bool write);
+		void setColorWrite(bool enabled);
+
+		void bindTexture(Texture* texture, size_t slot);
+		void debindTexture(Texture* texture, size_t slot);
+
+		void bindCubeMap(CubeMap* cubeMap, size_t slot);
+		void debindCubeMap(CubeMap* cubeMap, size_t slot);
+
+		void copyData(Buffer* buffer, size_t size, const void* data);
+		void copySubData(Buffer* buffer, size_t offset, size_t size, const void* data);
+		void copyBufferData(Buffer* source, size_t sourceOffset, Buffer* destination, size_t destinationOffset, size_t size);
+		void streamTextures(size_t budget);
+
+		/** \brief Records a change of the resident levels of a texture with at most 16 levels.
+		*
+		*	Unlike copyData the pixels aren't copied into the list, they have to stay alive until it is submitted.
+		*/
+		void setTextureLevels(Texture* texture, size_t count, size_t firstLevel, const unsigned char* const levels[], const size_t sizes[]);
+
+		void beginQuery(Query* query);
+		void endQuery(Query* query);
+
+		void draw(size_t count);
+		void drawIndexed(size_t count);
+		void drawInstanced(size_t count, size_t instanceCount);
+		void drawInstancedIndexed(size_t count, size_t instanceCount);
+		void drawIndirect(size_t drawCount, size_t offset);
+		void drawIndexedIndirect(size_t drawCount, size_t offset);
+
+		void dispatch(size_t x, size_t y, size_t z);
+
+		/** \brief Appends the commands between two positions of another list, or submits them when passing through. */
+		void append(const CommandList& other, size_t begin, size_t end);
+
+		/** \brief Replays every command, must be called on the thread owning the device. */
+		void submit(GraphicsDevice* device) const;
+
+		/** \brief Replays the commands between two positions returned by getPosition. */
+		void submit(GraphicsDevice* device, size_t begin, size_t end) const;
+
+	private:
+		enum class Opcode : uint8
+		{
+			CLEAR,
+			BIND_RENDER_TARGET,
+			DEBIND_RENDER_TARGET,
+			BIND_PIPELINE,
+			DEBIND_PIPELINE,
+			BIND_VERTEX_BUFFER,
+			BIND_INDEX_BUFFER,
+			BIND_VERTEX_UNIFORM_BUFFER,
+			BIND_PIXEL_UNIFORM_BUFFER,
+			BIND_STORAGE_BUFFER,
+			BIND_INDIRECT_BUFFER,
+			BIND_VIEWPORT,
+			SET_DEPTH_STATE,
+			SET_COLOR_WRITE,
+			BIND_TEXTURE,
+			DEBIND_TEXTURE,
+			BIND_CUBE_MAP,
+			DEBIND_CUBE_MAP,
+			COPY_DATA,
+			COPY_SUB_DATA,
+			COPY_BUFFER_DATA,
+			STREAM_TEXTURES,
+			SET_TEXTURE_LEVELS,
+			BEGIN_QUERY,
+			END_QUERY,
+			DRAW,
+			DRAW_INDEXED,
+			DRAW_INSTANCED,
+			DRAW_INSTANCED_INDEXED,
+			DRAW_INDIRECT,
+			DRAW_INDEXED_INDIRECT,
+			DISPATCH
+		};
+
+		void writeOpcode(Opcode opcode);
+		void writeBytes(const void* source, size_t size);
+		void grow(size_t size);
+
+		// Called for every argument, so the fixed size copies are kept inline.
+		template <typename T>
+		void write(const T& value)
+		{
+			if (position + sizeof(T) > data.size())
+			{
+				grow(sizeof(T));
+			}
+
+			std::memcpy(&data[position], &value, sizeof(T));
+			position += sizeof(T);
+		}
+
+		// The stream has no alignment, so values are copied out of it.
+		template <typename T>
+		static T read(const uint8*& cursor)
+		{
+			T value;
+			std::memcpy(&value, cursor, sizeof(T));
+			cursor += sizeof(T);
+
+			return value;
+		}
+
+		GraphicsDevice* immediateDevice;
+		std::vector<uint8> data;
+		size_t position;
+	};
+}
@@ -12,17 +12,31 @@ namespace sge
 		TEXCOORD
 	};
 
+	// Component type of a vertex element, the normalized integer types read as floats in the shader.
+	enum class VertexFormat
+	{
+		FLOAT,
+		HALF,
+		UNORM8,
+		SNORM8,
+		UNORM16,
+		SNORM16
+	};
+
 	enum class ShaderType
 	{
 		VERTEX,
-		PIXEL
+		PIXEL,
+		COMPUTE
 	};
 
 	enum class BufferType
 	{
 		VERTEX,
 		INDEX,
-		UNIFORM
+		UNIFORM,
+		STORAGE,
+		INDIRECT
 	};
 
 	enum class BufferUsage
@@ -33,12 +47,48 @@ namespace sge
 
 	enum class PrimitiveTopology
 	{
-		TRIANGLE
+		TRIANGLE,
+		TRIANGLE_STRIP,
+		LINE,
+		POINT
+	};
+
+	enum class BlendMode
+	{
+		NONE,
+		ALPHA,		// Source alpha over the destination.
+		ADDITIVE
+	};
+
+	enum class CullMode
+	{
+		NONE,
+		BACK,
+		FRONT
 	};
 
     enum class Format
     {
         RGB = 3,
-        RGBA = 4
+        RGBA = 4,
+        R32F,
+        RGBA16F,
+        BC1,
+        BC3,
+        BC5
+    };
+
+    enum class DepthFunction
+    {
+        LESS,
+        LESS_EQUAL,
+        EQUAL,
+        ALWAYS
+    };
+
+    enum class QueryType
+    {
+        SAMPLES_PASSED,
+        ANY_SAMPLES_PASSED
     };
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "glad/glad.h"
 
 #include "Renderer/Pipeline.h"
@@ -17,6 +19,11 @@ namespace sge
 
 		GLuint program;
 		GLuint vao;
+		GLenum mode;	// Primitive mode of the draws, from the topology.
+
+		// Sources the program was linked from, variants compile them again with defines. Empty for compute.
+		std::string vertexSource;
+		std::string pixelSource;
 	};
 }
 
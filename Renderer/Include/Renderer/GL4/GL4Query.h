@@ -0,0 +1,20 @@
+#ifdef OPENGL4
+
+#pragma once
+
+#include "glad/glad.h"
+
+#include "Renderer/Query.h"
+
+namespace sge
+{
+    struct GL4Query
+    {
+        Query header;
+
+        GLuint id;
+        GLenum target;
+    };
+}
+
+#endif
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "glad/glad.h"
 
 #include "Renderer/Shader.h"
@@ -12,8 +14,9 @@ namespace sge
 	{
 		Shader header;
 
-		GLuint id;
+		GLuint id;		// Zero until the shader is compiled, which a cached program binary skips.
 		GLenum type;
+		std::string source;
 	};
 }
 
@@ -13,6 +13,14 @@ namespace sge
 		Texture header;
 
 		GLuint id;
+		GLenum target;		// GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY.
+		GLsizei layers;		// Layers of an array, 0 otherwise.
+		GLsizei width;		// Size of the first level of the whole chain.
+		GLsizei height;
+		GLenum format;		// Sized internal format.
+		GLint levels;		// Levels of the whole chain.
+		GLint firstLevel;	// Levels before it are dropped from video memory.
+		bool resident;		// False while a streamed texture still holds its placeholder.
 	};
 }
 
@@ -2,16 +2,20 @@
 
 #include <cstddef>
 
+#include "Core/Types.h"
+
 #include "Renderer/Enumerations.h"
+#include "Renderer/Pipeline.h"
 
 namespace sge
 {
     class TextureResource;
 	class Window;
+	class CommandLog;
 
 	struct CubeMap;
 	struct Buffer;
-	struct Pipeline;
+	struct Query;
     struct RenderTarget;
 	struct Shader;
 	struct Texture;
@@ -31,13 +35,36 @@ namespace sge
 
 		void swap();
 
+		/** \brief Makes the device's context current on the calling thread, for handing the device to another thread. */
+		void bindContext();
+		void unbindContext();
+
+		/** \brief Directory the linked programs are stored in, pipelines created afterwards load them from there when the driver accepts the binary. */
+		void setProgramCache(const char* directory);
+
+#ifdef HEADLESS
+		/** \brief Calls recorded by the headless backend, which does no GPU work. */
+		const CommandLog& getCommandLog() const;
+#endif
+
 		Buffer* createBuffer(BufferType type, BufferUsage usage, size_t size);
 		void deleteBuffer(Buffer* buffer);
 
-		Pipeline* createPipeline(VertexLayoutDescription* vertexLayoutDescription, Shader* vertexShader, Shader* pixelShader);
+		/** \brief Creates a pipeline, binding it also sets its blend, depth and cull state and its topology. */
+		Pipeline* createPipeline(VertexLayoutDescription* vertexLayoutDescription, Shader* vertexShader, Shader* pixelShader, const PipelineState& state = PipelineState());
+
+		/** \brief Creates a permutation of a pipeline, its shaders compiled again with a #define for every name.
+		*
+		*	The variant has the vertex layout and state of the pipeline and is deleted with deletePipeline.
+		*/
+		Pipeline* createPipelineVariant(Pipeline* pipeline, size_t count, const char* const defines[]);
+
+		/** \brief Creates a pipeline running a single compute shader, bound like any other pipeline before dispatch. */
+		Pipeline* createComputePipeline(Shader* computeShader);
 		void deletePipeline(Pipeline* pipeline);
 
         RenderTarget* createRenderTarget(size_t count, size_t width, size_t height, bool depth = false, bool stencil = false);
+        RenderTarget* createRenderTarget(size_t count, const Format formats[], size_t width, size_t height, bool depth = false, bool stencil = false);
         void deleteRenderTarget(RenderTarget* renderTarget);
 
 		Shader* createShader(ShaderType type, const char* source, size_t size);
@@ -49,8 +76,59 @@ namespace sge
         Texture* createTexture(size_t width, size_t height, unsigned char* source = 0, Format format = Format::RGBA);
         Texture* createTextTexture(size_t width, size_t height, unsigned char* source);
 
+		/** \brief Creates a texture from a precomputed mip chain, compressed formats are uploaded as they are.
+		*
+		*	\param const unsigned char* const levels[] : The pixels of each level, largest first.
+		*	\param const size_t sizes[] : The size of each level in bytes.
+		*/
+		Texture* createTexture(size_t width, size_t height, size_t count, const unsigned char* const levels[], const size_t sizes[], Format format);
+
 		void deleteTexture(Texture* texture);
 
+		/** \brief Keeps only the levels [firstLevel, count) of a texture in video memory, dropping or restoring the larger ones.
+		*
+		*	Levels that are already resident are copied on the device, the others are uploaded from levels.
+		*	Only RGBA and block compressed textures can change their levels.
+		*
+		*	\param const unsigned char* const levels[] : The pixels of every level, only read for the levels that are restored.
+		*	\param const size_t sizes[] : The size of each level in bytes.
+		*/
+		void setTextureLevels(Texture* texture, size_t count, size_t firstLevel, const unsigned char* const levels[], const size_t sizes[]);
+
+		/** \brief Creates an RGBA texture whose pixels are streamed in, it holds the placeholder color (0xAABBGGRR) until then. */
+		Texture* createStreamedTexture(size_t width, size_t height, uint32 placeholder = 0xff808080);
+
+		/** \brief Bytes of staging memory, the pixels of a streamed texture have to fit. */
+		size_t getStagingSize() const;
+
+		/** \brief Reserves staging memory for the pixels of a streamed texture, nullptr while the memory is in use.
+		*
+		*	Safe on any thread. The memory is written there and handed over with endTextureUpload,
+		*	streamTextures then copies it into the texture on the device thread. The ticket names the
+		*	upload, an upload has to be ended even when its texture was deleted in the meantime.
+		*/
+		void* beginTextureUpload(Texture* texture, size_t size, uint32& ticket);
+		void endTextureUpload(uint32 ticket);
+
+		/** \brief Copies staged textures in the order they were reserved, at least one and at most budget bytes of them. */
+		void streamTextures(size_t budget);
+
+		/** \brief Creates an array of textures with the same size, format and levels, bound like any other texture.
+		*
+		*	Shaders sample it as a sampler2DArray with the layer as the third coordinate. The layers are undefined until copied.
+		*/
+		Texture* createTextureArray(size_t width, size_t height, size_t layers, size_t levels, Format format);
+
+		/** \brief Grows a texture array to the given number of layers, the existing layers are kept. */
+		void setTextureLayers(Texture* texture, size_t layers);
+
+		/** \brief Uploads every level of one layer of a texture array.
+		*
+		*	\param const unsigned char* const levels[] : The pixels of each level, largest first.
+		*	\param const size_t sizes[] : The size of each level in bytes.
+		*/
+		void copyTextureLayer(Texture* texture, size_t layer, const unsigned char* const levels[], const size_t sizes[]);
+
         CubeMap* createCubeMap(TextureResource* source[]);
 		void deleteCubeMap(CubeMap* cubeMap);
 
@@ -64,9 +142,19 @@ namespace sge
 		void bindIndexBuffer(Buffer* buffer);
 		void bindVertexUniformBuffer(Buffer* buffer, size_t slot);
 		void bindPixelUniformBuffer(Buffer* buffer, size_t slot);
+		void bindStorageBuffer(Buffer* buffer, size_t slot);
+
+		/** \brief Binds a buffer of DrawIndirectCommand or DrawIndexedIndirectCommand records for the indirect draws. */
+		void bindIndirectBuffer(Buffer* buffer);
 
 		void bindViewport(Viewport* viewport);
 
+		/** \brief Overrides the depth state of the bound pipeline until the next pipeline is bound. */
+		void setDepthState(DepthFunction function, bool write);
+
+		/** \brief Enables or disables writing to the color buffers, used by depth only passes. Kept across pipeline binds. */
+		void setColorWrite(bool enabled);
+
 		void bindTexture(Texture* texture, size_t slot);
 		void debindTexture(Texture* texture, size_t slot);
 
@@ -76,10 +164,38 @@ namespace sge
 		void copyData(Buffer* buffer, size_t size, const void* data);
 		void copySubData(Buffer* buffer, size_t offset, size_t size, const void* data);
 
+		/** \brief Copies between two buffers on the GPU, the destination must already be large enough. */
+		void copyBufferData(Buffer* source, size_t sourceOffset, Buffer* destination, size_t destinationOffset, size_t size);
+
+		Query* createQuery(QueryType type);
+		void deleteQuery(Query* query);
+
+		void beginQuery(Query* query);
+		void endQuery(Query* query);
+
+		/** \brief Reads the result of an ended query.
+		*
+		*	\param uint64& result : Receives the result when true is returned.
+		*	\param bool wait : Blocks until the GPU has finished the query.
+		*	\return Returns false if the result isn't available yet.
+		*/
+		bool getQueryResult(Query* query, uint64& result, bool wait = false);
+
 		void draw(size_t count);
 		void drawIndexed(size_t count);
 		void drawInstanced(size_t count, size_t instanceCount);
 		void drawInstancedIndexed(size_t count, size_t instanceCount);
+
+		/** \brief Draws drawCount tightly packed records of the bound indirect buffer, starting at offset bytes. */
+		void drawIndirect(size_t drawCount, size_t offset);
+		void drawIndexedIndirect(size_t drawCount, size_t offset);
+
+		/** \brief Runs the bound compute pipeline over a grid of work groups.
+		*
+		*	Storage buffer writes of the dispatch are visible to every later draw, dispatch and indirect
+		*	draw, including writes to vertex and indirect buffers bound as storage buffers.
+		*/
+		void dispatch(size_t x, size_t y, size_t z);
 		
 	private:
 		struct Impl;
@@ -0,0 +1,147 @@
+#ifdef HEADLESS
+
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include "Core/Types.h"
+
+namespace sge
+{
+	/** \brief GraphicsDevice calls recorded by the headless backend. */
+	enum class Command
+	{
+		CLEAR,
+		SWAP,
+		CREATE_BUFFER,
+		DELETE_BUFFER,
+		CREATE_PIPELINE,
+		DELETE_PIPELINE,
+		CREATE_RENDER_TARGET,
+		DELETE_RENDER_TARGET,
+		CREATE_SHADER,
+		DELETE_SHADER,
+		CREATE_TEXTURE,
+		DELETE_TEXTURE,
+		CREATE_CUBE_MAP,
+		DELETE_CUBE_MAP,
+		CREATE_QUERY,
+		DELETE_QUERY,
+		BIND_PIPELINE,
+		DEBIND_PIPELINE,
+		BIND_RENDER_TARGET,
+		DEBIND_RENDER_TARGET,
+		BIND_VERTEX_BUFFER,
+		BIND_INDEX_BUFFER,
+		BIND_VERTEX_UNIFORM_BUFFER,
+		BIND_PIXEL_UNIFORM_BUFFER,
+		BIND_STORAGE_BUFFER,
+		BIND_INDIRECT_BUFFER,
+		BIND_VIEWPORT,
+		SET_DEPTH_STATE,
+		SET_COLOR_WRITE,
+		BIND_TEXTURE,
+		DEBIND_TEXTURE,
+		BIND_CUBE_MAP,
+		DEBIND_CUBE_MAP,
+		COPY_DATA,
+		COPY_SUB_DATA,
+		COPY_BUFFER_DATA,
+		COPY_TEXTURE,
+		BEGIN_QUERY,
+		END_QUERY,
+		GET_QUERY_RESULT,
+		DRAW,
+		DRAW_INDEXED,
+		DRAW_INSTANCED,
+		DRAW_INSTANCED_INDEXED,
+		DRAW_INDIRECT,
+		DRAW_INDEXED_INDIRECT,
+		DISPATCH,
+		COUNT
+	};
+
+	/** \brief A recorded call and its most interesting argument.
+	*
+	*	The argument is the byte count for uploads and copies, the vertex count for draws, the
+	*	work group count for dispatches and the slot for texture and buffer bindings, zero otherwise.
+	*/
+	struct CommandEntry
+	{
+		Command command;
+		uint64 argument;
+	};
+
+	/** \brief Totals over some number of frames. */
+	struct CommandStats
+	{
+		size_t counts[static_cast<size_t>(Command::COUNT)];	/**< Calls of each command. */
+		size_t drawCalls;		/**< Calls of any of the draw commands. */
+		size_t stateChanges;	/**< Bindings and state changes that differed from the current state. */
+		uint64 bytesUploaded;	/**< Bytes given to copyData and copySubData. */
+		uint64 vertices;		/**< Vertices submitted, instances included. */
+
+		CommandStats();
+
+		void add(const CommandStats& other);
+	};
+
+	/** \brief Log of the calls made to the headless GraphicsDevice.
+	*
+	*	Calls are recorded into the current frame, GraphicsDevice::swap ends the frame and
+	*	adds it to the totals. The entries of the last complete frame are kept, so two runs
+	*	can be compared call by call.
+	*/
+	class CommandLog
+	{
+	public:
+		CommandLog();
+
+		void record(Command command, uint64 argument = 0);
+		void recordUpload(Command command, uint64 bytes);
+		void recordDraw(Command command, uint64 vertices);
+		void recordStateChange();
+
+		void endFrame();
+
+		/** \brief Entries of the last complete frame. */
+		const std::vector<CommandEntry>& getFrameEntries() const
+		{
+			return frameEntries;
+		}
+
+		/** \brief Stats of the last complete frame. */
+		const CommandStats& getFrameStats() const
+		{
+			return frameStats;
+		}
+
+		/** \brief Stats of every complete frame. */
+		const CommandStats& getTotalStats() const
+		{
+			return totalStats;
+		}
+
+		size_t getFrameCount() const
+		{
+			return frameCount;
+		}
+
+		/** \brief Writes the per frame averages of the totals and the command counts. */
+		void print(std::ostream& stream) const;
+
+		static const char* getName(Command command);
+
+	private:
+		std::vector<CommandEntry> entries;
+		std::vector<CommandEntry> frameEntries;
+		CommandStats stats;
+		CommandStats frameStats;
+		CommandStats totalStats;
+		size_t frameCount;
+	};
+}
+
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Core/Types.h"
+
+namespace sge
+{
+	/** \brief Arguments of one draw of GraphicsDevice::drawIndirect, in the layout the GPU reads. */
+	struct DrawIndirectCommand
+	{
+		uint32 count;
+		uint32 instanceCount;
+		uint32 first;			/**< First vertex. */
+		uint32 baseInstance;	/**< Added to the instance index, usable to find per draw data. */
+	};
+
+	/** \brief Arguments of one draw of GraphicsDevice::drawIndexedIndirect. */
+	struct DrawIndexedIndirectCommand
+	{
+		uint32 count;
+		uint32 instanceCount;
+		uint32 firstIndex;
+		int32 baseVertex;
+		uint32 baseInstance;
+	};
+}
@@ -1,8 +1,136 @@
 #pragma once
 
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Renderer/Enumerations.h"
+
 namespace sge
 {
+	/** \brief Fixed function state baked into a pipeline, the device sets what differs when the pipeline is bound.
+	*
+	*	The default is opaque triangles with back faces culled and a writing LESS depth test.
+	*/
+	struct PipelineState
+	{
+		BlendMode blendMode;
+		DepthFunction depthFunction;
+		bool depthWrite;
+		CullMode cullMode;
+		PrimitiveTopology topology;
+
+		PipelineState() :
+			blendMode(BlendMode::NONE), depthFunction(DepthFunction::LESS), depthWrite(true),
+			cullMode(CullMode::BACK), topology(PrimitiveTopology::TRIANGLE)
+		{
+		}
+	};
+
+	/** \brief A member of a uniform block, offset is in bytes from the start of the block. */
+	struct UniformMember
+	{
+		std::string name;
+		size_t offset;
+		size_t arraySize;
+	};
+
+	/** \brief A uniform or storage block, size is in bytes and excludes a runtime sized array. */
+	struct ShaderBlock
+	{
+		std::string name;
+		size_t binding;
+		size_t size;
+		std::vector<UniformMember> members;
+	};
+
+	struct ShaderSampler
+	{
+		std::string name;
+		size_t unit;
+	};
+
+	/** \brief The blocks and samplers the shaders of a pipeline read, reflected from the linked program.
+	*
+	*	A backend that can't reflect leaves reflected false, every binding then counts as read.
+	*/
+	struct PipelineReflection
+	{
+		bool reflected;
+
+		std::vector<ShaderBlock> uniformBlocks;
+		std::vector<ShaderBlock> storageBlocks;
+		std::vector<ShaderSampler> samplers;
+
+		PipelineReflection() :
+			reflected(false)
+		{
+		}
+
+		const ShaderBlock* findUniformBlock(size_t binding) const
+		{
+			return findBlock(uniformBlocks, binding);
+		}
+
+		const ShaderBlock* findStorageBlock(size_t binding) const
+		{
+			return findBlock(storageBlocks, binding);
+		}
+
+		/** \brief Bytes of data laid out for the block at binding that the shaders read, zero when they don't read the block. */
+		size_t getUniformSize(size_t binding, size_t size) const
+		{
+			if (!reflected)
+			{
+				return size;
+			}
+
+			const ShaderBlock* block = findUniformBlock(binding);
+
+			return block ? (block->size < size ? block->size : size) : 0;
+		}
+
+		bool readsStorageBlock(size_t binding) const
+		{
+			return !reflected || findStorageBlock(binding) != nullptr;
+		}
+
+		bool readsSampler(size_t unit) const
+		{
+			if (!reflected)
+			{
+				return true;
+			}
+
+			for (const ShaderSampler& sampler : samplers)
+			{
+				if (sampler.unit == unit)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+	private:
+		static const ShaderBlock* findBlock(const std::vector<ShaderBlock>& blocks, size_t binding)
+		{
+			for (const ShaderBlock& block : blocks)
+			{
+				if (block.binding == binding)
+				{
+					return &block;
+				}
+			}
+
+			return nullptr;
+		}
+	};
+
 	struct Pipeline
 	{
+		PipelineState state;
+		PipelineReflection reflection;
 	};
-}
\ No newline at end of file
+}
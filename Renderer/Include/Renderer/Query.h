@@ -0,0 +1,11 @@
+#pragma once
+
+#include "Renderer/Enumerations.h"
+
+namespace sge
+{
+    struct Query
+    {
+        QueryType type;
+    };
+}
\ No newline at end of file
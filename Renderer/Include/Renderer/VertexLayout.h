@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 #include "Renderer/Enumerations.h"
 
 namespace sge
@@ -7,19 +9,40 @@ namespace sge
 	// TODO Why 15?
 	static const unsigned int MAX_NUMBER_OF_ELEMENTS = 15;
 
+	// size is the number of components of the given format.
 	struct VertexElement
 	{
 		size_t offset;
 		size_t size;
 		VertexSemantic semantic;
+		VertexFormat format;
 	};
 
+	// Bytes taken by an element in the vertex, padded to 4 so every attribute stays aligned.
+	inline size_t getVertexElementBytes(const VertexElement& element)
+	{
+		size_t componentBytes = 4;
+
+		switch (element.format)
+		{
+		case VertexFormat::FLOAT: componentBytes = 4; break;
+		case VertexFormat::HALF: componentBytes = 2; break;
+		case VertexFormat::UNORM8: componentBytes = 1; break;
+		case VertexFormat::SNORM8: componentBytes = 1; break;
+		case VertexFormat::UNORM16: componentBytes = 2; break;
+		case VertexFormat::SNORM16: componentBytes = 2; break;
+		}
+
+		return (element.size * componentBytes + 3) & ~static_cast<size_t>(3);
+	}
+
 	struct VertexLayoutDescription
 	{
 		size_t count;
 		VertexElement elements[MAX_NUMBER_OF_ELEMENTS];
 	};
 
+	// Offsets and stride are in bytes.
 	struct VertexLayout
 	{
 		size_t count;
@@ -0,0 +1,791 @@
+#include <algorithm>
+
+#include "Renderer/CommandList.h"
+#include "Renderer/GraphicsDevice.h"
+#include "Renderer/Viewport.h"
+
+#include "Core/Assert.h"
+
+namespace sge
+{
+	namespace
+	{
+		// Enough for a 32768 x 32768 mip chain, decoded into arrays on the stack.
+		const size_t MAX_TEXTURE_LEVELS = 16;
+	}
+
+	CommandList::CommandList(size_t size) :
+		immediateDevice(nullptr),
+		data(size),
+		position(0)
+	{
+	}
+
+	CommandList::CommandList(GraphicsDevice* device) :
+		immediateDevice(device),
+		position(0)
+	{
+	}
+
+	void CommandList::reset()
+	{
+		position = 0;
+	}
+
+	void CommandList::writeOpcode(Opcode opcode)
+	{
+		write(static_cast<uint8>(opcode));
+	}
+
+	void CommandList::writeBytes(const void* source, size_t size)
+	{
+		if (size == 0)
+		{
+			return;
+		}
+
+		if (position + size > data.size())
+		{
+			grow(size);
+		}
+
+		std::memcpy(&data[position], source, size);
+		position += size;
+	}
+
+	void CommandList::grow(size_t size)
+	{
+		// The storage only grows, so a list reused every frame stops allocating after the first ones.
+		data.resize(std::max(std::max(data.size() * 2, position + size), size_t(4096)));
+	}
+
+	void CommandList::clear(float r, float g, float b, float a)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->clear(r, g, b, a);
+
+			return;
+		}
+
+		writeOpcode(Opcode::CLEAR);
+		write(r);
+		write(g);
+		write(b);
+		write(a);
+	}
+
+	void CommandList::bindRenderTarget(RenderTarget* renderTarget)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->bindRenderTarget(renderTarget);
+
+			return;
+		}
+
+		writeOpcode(Opcode::BIND_RENDER_TARGET);
+		write(renderTarget);
+	}
+
+	void CommandList::debindRenderTarget()
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->debindRenderTarget();
+
+			return;
+		}
+
+		writeOpcode(Opcode::DEBIND_RENDER_TARGET);
+	}
+
+	void CommandList::bindPipeline(Pipeline* pipeline)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->bindPipeline(pipeline);
+
+			return;
+		}
+
+		writeOpcode(Opcode::BIND_PIPELINE);
+		write(pipeline);
+	}
+
+	void CommandList::debindPipeline(Pipeline* pipeline)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->debindPipeline(pipeline);
+
+			return;
+		}
+
+		writeOpcode(Opcode::DEBIND_PIPELINE);
+		write(pipeline);
+	}
+
+	void CommandList::bindVertexBuffer(Buffer* buffer)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->bindVertexBuffer(buffer);
+
+			return;
+		}
+
+		writeOpcode(Opcode::BIND_VERTEX_BUFFER);
+		write(buffer);
+	}
+
+	void CommandList::bindIndexBuffer(Buffer* buffer)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->bindIndexBuffer(buffer);
+
+			return;
+		}
+
+		writeOpcode(Opcode::BIND_INDEX_BUFFER);
+		write(buffer);
+	}
+
+	void CommandList::bindVertexUniformBuffer(Buffer* buffer, size_t slot)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->bindVertexUniformBuffer(buffer, slot);
+
+			return;
+		}
+
+		writeOpcode(Opcode::BIND_VERTEX_UNIFORM_BUFFER);
+		write(buffer);
+		write(static_cast<uint32>(slot));
+	}
+
+	void CommandList::bindPixelUniformBuffer(Buffer* buffer, size_t slot)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->bindPixelUniformBuffer(buffer, slot);
+
+			return;
+		}
+
+		writeOpcode(Opcode::BIND_PIXEL_UNIFORM_BUFFER);
+		write(buffer);
+		write(static_cast<uint32>(slot));
+	}
+
+	void CommandList::bindStorageBuffer(Buffer* buffer, size_t slot)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->bindStorageBuffer(buffer, slot);
+
+			return;
+		}
+
+		writeOpcode(Opcode::BIND_STORAGE_BUFFER);
+		write(buffer);
+		write(static_cast<uint32>(slot));
+	}
+
+	void CommandList::bindIndirectBuffer(Buffer* buffer)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->bindIndirectBuffer(buffer);
+
+			return;
+		}
+
+		writeOpcode(Opcode::BIND_INDIRECT_BUFFER);
+		write(buffer);
+	}
+
+	void CommandList::bindViewport(const Viewport* viewport)
+	{
+		if (immediateDevice)
+		{
+			Viewport copy = *viewport;
+			immediateDevice->bindViewport(&copy);
+
+			return;
+		}
+
+		writeOpcode(Opcode::BIND_VIEWPORT);
+		write(*viewport);
+	}
+
+	void CommandList::setDepthState(DepthFunction function, bool write)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->setDepthState(function, write);
+
+			return;
+		}
+
+		writeOpcode(Opcode::SET_DEPTH_STATE);
+		this->write(static_cast<uint8>(function));
+		this->write(static_cast<uint8>(write));
+	}
+
+	void CommandList::setColorWrite(bool enabled)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->setColorWrite(enabled);
+
+			return;
+		}
+
+		writeOpcode(Opcode::SET_COLOR_WRITE);
+		write(static_cast<uint8>(enabled));
+	}
+
+	void CommandList::bindTexture(Texture* texture, size_t slot)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->bindTexture(texture, slot);
+
+			return;
+		}
+
+		writeOpcode(Opcode::BIND_TEXTURE);
+		write(texture);
+		write(static_cast<uint32>(slot));
+	}
+
+	void CommandList::debindTexture(Texture* texture, size_t slot)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->debindTexture(texture, slot);
+
+			return;
+		}
+
+		writeOpcode(Opcode::DEBIND_TEXTURE);
+		write(texture);
+		write(static_cast<uint32>(slot));
+	}
+
+	void CommandList::bindCubeMap(CubeMap* cubeMap, size_t slot)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->bindCubeMap(cubeMap, slot);
+
+			return;
+		}
+
+		writeOpcode(Opcode::BIND_CUBE_MAP);
+		write(cubeMap);
+		write(static_cast<uint32>(slot));
+	}
+
+	void CommandList::debindCubeMap(CubeMap* cubeMap, size_t slot)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->debindCubeMap(cubeMap, slot);
+
+			return;
+		}
+
+		writeOpcode(Opcode::DEBIND_CUBE_MAP);
+		write(cubeMap);
+		write(static_cast<uint32>(slot));
+	}
+
+	void CommandList::copyData(Buffer* buffer, size_t size, const void* data)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->copyData(buffer, size, data);
+
+			return;
+		}
+
+		SGE_ASSERT(size <= UINT32_MAX);
+
+		// A null source only sizes the buffer, which is kept as a flag instead of copying zeros.
+		writeOpcode(Opcode::COPY_DATA);
+		write(buffer);
+		write(static_cast<uint32>(size));
+		write(static_cast<uint8>(data != nullptr));
+
+		if (data)
+		{
+			writeBytes(data, size);
+		}
+	}
+
+	void CommandList::copySubData(Buffer* buffer, size_t offset, size_t size, const void* data)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->copySubData(buffer, offset, size, data);
+
+			return;
+		}
+
+		SGE_ASSERT(offset <= UINT32_MAX && size <= UINT32_MAX);
+
+		writeOpcode(Opcode::COPY_SUB_DATA);
+		write(buffer);
+		write(static_cast<uint32>(offset));
+		write(static_cast<uint32>(size));
+		writeBytes(data, size);
+	}
+
+	void CommandList::copyBufferData(Buffer* source, size_t sourceOffset, Buffer* destination, size_t destinationOffset, size_t size)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->copyBufferData(source, sourceOffset, destination, destinationOffset, size);
+
+			return;
+		}
+
+		SGE_ASSERT(sourceOffset <= UINT32_MAX && destinationOffset <= UINT32_MAX && size <= UINT32_MAX);
+
+		writeOpcode(Opcode::COPY_BUFFER_DATA);
+		write(source);
+		write(static_cast<uint32>(sourceOffset));
+		write(destination);
+		write(static_cast<uint32>(destinationOffset));
+		write(static_cast<uint32>(size));
+	}
+
+	void CommandList::streamTextures(size_t budget)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->streamTextures(budget);
+
+			return;
+		}
+
+		writeOpcode(Opcode::STREAM_TEXTURES);
+		write(static_cast<uint32>(budget));
+	}
+
+	void CommandList::setTextureLevels(Texture* texture, size_t count, size_t firstLevel, const unsigned char* const levels[], const size_t sizes[])
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->setTextureLevels(texture, count, firstLevel, levels, sizes);
+
+			return;
+		}
+
+		SGE_ASSERT(count <= MAX_TEXTURE_LEVELS && firstLevel < count);
+
+		writeOpcode(Opcode::SET_TEXTURE_LEVELS);
+		write(texture);
+		write(static_cast<uint32>(count));
+		write(static_cast<uint32>(firstLevel));
+
+		for (size_t level = 0; level < count; level++)
+		{
+			write(levels[level]);
+			write(static_cast<uint32>(sizes[level]));
+		}
+	}
+
+	void CommandList::beginQuery(Query* query)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->beginQuery(query);
+
+			return;
+		}
+
+		writeOpcode(Opcode::BEGIN_QUERY);
+		write(query);
+	}
+
+	void CommandList::endQuery(Query* query)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->endQuery(query);
+
+			return;
+		}
+
+		writeOpcode(Opcode::END_QUERY);
+		write(query);
+	}
+
+	void CommandList::draw(size_t count)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->draw(count);
+
+			return;
+		}
+
+		writeOpcode(Opcode::DRAW);
+		write(static_cast<uint32>(count));
+	}
+
+	void CommandList::drawIndexed(size_t count)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->drawIndexed(count);
+
+			return;
+		}
+
+		writeOpcode(Opcode::DRAW_INDEXED);
+		write(static_cast<uint32>(count));
+	}
+
+	void CommandList::drawInstanced(size_t count, size_t instanceCount)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->drawInstanced(count, instanceCount);
+
+			return;
+		}
+
+		writeOpcode(Opcode::DRAW_INSTANCED);
+		write(static_cast<uint32>(count));
+		write(static_cast<uint32>(instanceCount));
+	}
+
+	void CommandList::drawInstancedIndexed(size_t count, size_t instanceCount)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->drawInstancedIndexed(count, instanceCount);
+
+			return;
+		}
+
+		writeOpcode(Opcode::DRAW_INSTANCED_INDEXED);
+		write(static_cast<uint32>(count));
+		write(static_cast<uint32>(instanceCount));
+	}
+
+	void CommandList::drawIndirect(size_t drawCount, size_t offset)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->drawIndirect(drawCount, offset);
+
+			return;
+		}
+
+		writeOpcode(Opcode::DRAW_INDIRECT);
+		write(static_cast<uint32>(drawCount));
+		write(static_cast<uint32>(offset));
+	}
+
+	void CommandList::drawIndexedIndirect(size_t drawCount, size_t offset)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->drawIndexedIndirect(drawCount, offset);
+
+			return;
+		}
+
+		writeOpcode(Opcode::DRAW_INDEXED_INDIRECT);
+		write(static_cast<uint32>(drawCount));
+		write(static_cast<uint32>(offset));
+	}
+
+	void CommandList::dispatch(size_t x, size_t y, size_t z)
+	{
+		if (immediateDevice)
+		{
+			immediateDevice->dispatch(x, y, z);
+
+			return;
+		}
+
+		writeOpcode(Opcode::DISPATCH);
+		write(static_cast<uint32>(x));
+		write(static_cast<uint32>(y));
+		write(static_cast<uint32>(z));
+	}
+
+	void CommandList::append(const CommandList& other, size_t begin, size_t end)
+	{
+		if (immediateDevice)
+		{
+			other.submit(immediateDevice, begin, end);
+
+			return;
+		}
+
+		SGE_ASSERT(!other.immediateDevice && begin <= end && end <= other.position);
+
+		if (begin < end)
+		{
+			writeBytes(&other.data[begin], end - begin);
+		}
+	}
+
+	void CommandList::submit(GraphicsDevice* device) const
+	{
+		submit(device, 0, position);
+	}
+
+	void CommandList::submit(GraphicsDevice* device, size_t begin, size_t end) const
+	{
+		SGE_ASSERT(begin <= end && end <= position);
+
+		if (begin == end)
+		{
+			return;
+		}
+
+		const uint8* cursor = &data[0] + begin;
+		const uint8* last = &data[0] + end;
+
+		while (cursor < last)
+		{
+			Opcode opcode = static_cast<Opcode>(*cursor++);
+
+			switch (opcode)
+			{
+			case Opcode::CLEAR:
+			{
+				float r = read<float>(cursor);
+				float g = read<float>(cursor);
+				float b = read<float>(cursor);
+				device->clear(r, g, b, read<float>(cursor));
+				break;
+			}
+
+			case Opcode::BIND_RENDER_TARGET:
+				device->bindRenderTarget(read<RenderTarget*>(cursor));
+				break;
+
+			case Opcode::DEBIND_RENDER_TARGET:
+				device->debindRenderTarget();
+				break;
+
+			case Opcode::BIND_PIPELINE:
+				device->bindPipeline(read<Pipeline*>(cursor));
+				break;
+
+			case Opcode::DEBIND_PIPELINE:
+				device->debindPipeline(read<Pipeline*>(cursor));
+				break;
+
+			case Opcode::BIND_VERTEX_BUFFER:
+				device->bindVertexBuffer(read<Buffer*>(cursor));
+				break;
+
+			case Opcode::BIND_INDEX_BUFFER:
+				device->bindIndexBuffer(read<Buffer*>(cursor));
+				break;
+
+			case Opcode::BIND_VERTEX_UNIFORM_BUFFER:
+			{
+				Buffer* buffer = read<Buffer*>(cursor);
+				device->bindVertexUniformBuffer(buffer, read<uint32>(cursor));
+				break;
+			}
+
+			case Opcode::BIND_PIXEL_UNIFORM_BUFFER:
+			{
+				Buffer* buffer = read<Buffer*>(cursor);
+				device->bindPixelUniformBuffer(buffer, read<uint32>(cursor));
+				break;
+			}
+
+			case Opcode::BIND_STORAGE_BUFFER:
+			{
+				Buffer* buffer = read<Buffer*>(cursor);
+				device->bindStorageBuffer(buffer, read<uint32>(cursor));
+				break;
+			}
+
+			case Opcode::BIND_INDIRECT_BUFFER:
+				device->bindIndirectBuffer(read<Buffer*>(cursor));
+				break;
+
+			case Opcode::BIND_VIEWPORT:
+			{
+				Viewport viewport = read<Viewport>(cursor);
+				device->bindViewport(&viewport);
+				break;
+			}
+
+			case Opcode::SET_DEPTH_STATE:
+			{
+				DepthFunction function = static_cast<DepthFunction>(read<uint8>(cursor));
+				device->setDepthState(function, read<uint8>(cursor) != 0);
+				break;
+			}
+
+			case Opcode::SET_COLOR_WRITE:
+				device->setColorWrite(read<uint8>(cursor) != 0);
+				break;
+
+			case Opcode::BIND_TEXTURE:
+			{
+				Texture* texture = read<Texture*>(cursor);
+				device->bindTexture(texture, read<uint32>(cursor));
+				break;
+			}
+
+			case Opcode::DEBIND_TEXTURE:
+			{
+				Texture* texture = read<Texture*>(cursor);
+				device->debindTexture(texture, read<uint32>(cursor));
+				break;
+			}
+
+			case Opcode::BIND_CUBE_MAP:
+			{
+				CubeMap* cubeMap = read<CubeMap*>(cursor);
+				device->bindCubeMap(cubeMap, read<uint32>(cursor));
+				break;
+			}
+
+			case Opcode::DEBIND_CUBE_MAP:
+			{
+				CubeMap* cubeMap = read<CubeMap*>(cursor);
+				device->debindCubeMap(cubeMap, read<uint32>(cursor));
+				break;
+			}
+
+			case Opcode::COPY_DATA:
+			{
+				Buffer* buffer = read<Buffer*>(cursor);
+				uint32 size = read<uint32>(cursor);
+				bool hasData = read<uint8>(cursor) != 0;
+
+				device->copyData(buffer, size, hasData ? cursor : nullptr);
+
+				if (hasData)
+				{
+					cursor += size;
+				}
+
+				break;
+			}
+
+			case Opcode::COPY_SUB_DATA:
+			{
+				Buffer* buffer = read<Buffer*>(cursor);
+				uint32 offset = read<uint32>(cursor);
+				uint32 size = read<uint32>(cursor);
+
+				device->copySubData(buffer, offset, size, cursor);
+				cursor += size;
+				break;
+			}
+
+			case Opcode::COPY_BUFFER_DATA:
+			{
+				Buffer* source = read<Buffer*>(cursor);
+				uint32 sourceOffset = read<uint32>(cursor);
+				Buffer* destination = read<Buffer*>(cursor);
+				uint32 destinationOffset = read<uint32>(cursor);
+
+				device->copyBufferData(source, sourceOffset, destination, destinationOffset, read<uint32>(cursor));
+				break;
+			}
+
+			case Opcode::STREAM_TEXTURES:
+				device->streamTextures(read<uint32>(cursor));
+				break;
+
+			case Opcode::SET_TEXTURE_LEVELS:
+			{
+				Texture* texture = read<Texture*>(cursor);
+				uint32 count = read<uint32>(cursor);
+				uint32 firstLevel = read<uint32>(cursor);
+
+				const unsigned char* levels[MAX_TEXTURE_LEVELS];
+				size_t sizes[MAX_TEXTURE_LEVELS];
+
+				for (uint32 level = 0; level < count; level++)
+				{
+					levels[level] = read<const unsigned char*>(cursor);
+					sizes[level] = read<uint32>(cursor);
+				}
+
+				device->setTextureLevels(texture, count, firstLevel, levels, sizes);
+				break;
+			}
+
+			case Opcode::BEGIN_QUERY:
+				device->beginQuery(read<Query*>(cursor));
+				break;
+
+			case Opcode::END_QUERY:
+				device->endQuery(read<Query*>(cursor));
+				break;
+
+			case Opcode::DRAW:
+				device->draw(read<uint32>(cursor));
+				break;
+
+			case Opcode::DRAW_INDEXED:
+				device->drawIndexed(read<uint32>(cursor));
+				break;
+
+			case Opcode::DRAW_INSTANCED:
+			{
+				uint32 count = read<uint32>(cursor);
+				device->drawInstanced(count, read<uint32>(cursor));
+				break;
+			}
+
+			case Opcode::DRAW_INSTANCED_INDEXED:
+			{
+				uint32 count = read<uint32>(cursor);
+				device->drawInstancedIndexed(count, read<uint32>(cursor));
+				break;
+			}
+
+			case Opcode::DRAW_INDIRECT:
+			{
+				uint32 drawCount = read<uint32>(cursor);
+				device->drawIndirect(drawCount, read<uint32>(cursor));
+				break;
+			}
+
+			case Opcode::DRAW_INDEXED_INDIRECT:
+			{
+				uint32 drawCount = read<uint32>(cursor);
+				device->drawIndexedIndirect(drawCount, read<uint32>(cursor));
+				break;
+			}
+
+			case Opcode::DISPATCH:
+			{
+				uint32 x = read<uint32>(cursor);
+				uint32 y = read<uint32>(cursor);
+				device->dispatch(x, y, read<uint32>(cursor));
+				break;
+			}
+
+			default:
+				SGE_ASSERT(false);
+				return;
+			}
+		}
+
+		SGE_ASSERT(cursor == last);
+	}
+}
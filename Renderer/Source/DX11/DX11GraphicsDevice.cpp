@@ -36,6 +36,41 @@ namespace sge
 		}
 	}
 
+	namespace
+	{
+		D3D11_COMPARISON_FUNC getDepthFunction(DepthFunction function)
+		{
+			switch (function)
+			{
+			case DepthFunction::LESS_EQUAL: return D3D11_COMPARISON_LESS_EQUAL;
+			case DepthFunction::EQUAL: return D3D11_COMPARISON_EQUAL;
+			case DepthFunction::ALWAYS: return D3D11_COMPARISON_ALWAYS;
+			default: return D3D11_COMPARISON_LESS;
+			}
+		}
+
+		D3D11_CULL_MODE getCullMode(CullMode mode)
+		{
+			switch (mode)
+			{
+			case CullMode::NONE: return D3D11_CULL_NONE;
+			case CullMode::FRONT: return D3D11_CULL_FRONT;
+			default: return D3D11_CULL_BACK;
+			}
+		}
+
+		D3D11_PRIMITIVE_TOPOLOGY getPrimitiveTopology(PrimitiveTopology topology)
+		{
+			switch (topology)
+			{
+			case PrimitiveTopology::TRIANGLE_STRIP: return D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
+			case PrimitiveTopology::LINE: return D3D11_PRIMITIVE_TOPOLOGY_LINELIST;
+			case PrimitiveTopology::POINT: return D3D11_PRIMITIVE_TOPOLOGY_POINTLIST;
+			default: return D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+			}
+		}
+	}
+
 	struct GraphicsDevice::Impl
 	{
 		Impl(Window& window) : 
@@ -213,6 +248,11 @@ namespace sge
 #endif
 	}
 
+	// Shaders are loaded precompiled as .cso, there is no program to cache.
+	void GraphicsDevice::setProgramCache(const char* directory)
+	{
+	}
+
 	void GraphicsDevice::swap()
 	{
 		impl->swapChain->Present(0, 0);
@@ -277,10 +317,12 @@ namespace sge
 		buffer = nullptr;
 	}
 
-	Pipeline* GraphicsDevice::createPipeline(VertexLayoutDescription* vertexLayoutDescription, Shader* vertexShader, Shader* pixelShader)
+	Pipeline* GraphicsDevice::createPipeline(VertexLayoutDescription* vertexLayoutDescription, Shader* vertexShader, Shader* pixelShader, const PipelineState& state)
 	{
 		DX11Pipeline* dx11Pipeline = new DX11Pipeline();
 
+		dx11Pipeline->header.state = state;
+
 		dx11Pipeline->vertexShader = reinterpret_cast<DX11Shader*>(vertexShader);
 		dx11Pipeline->pixelShader = reinterpret_cast<DX11Shader*>(pixelShader);
 
@@ -317,7 +359,7 @@ namespace sge
 				inputLayoutDesc[i].Format = DXGI_FORMAT_R32G32B32A32_FLOAT; break;
 			}
 
-			stride += vertexLayoutDescription->elements[i].size;
+			stride += getVertexElementBytes(vertexLayoutDescription->elements[i]);
 
 			switch (vertexLayoutDescription->elements[i].semantic)
 			{
@@ -393,7 +435,7 @@ namespace sge
 		ZeroMemory(&rasterizerDesc, sizeof(rasterizerDesc));
 
 		rasterizerDesc.FillMode = D3D11_FILL_SOLID;
-		rasterizerDesc.CullMode = D3D11_CULL_BACK;
+		rasterizerDesc.CullMode = getCullMode(state.cullMode);
 		rasterizerDesc.FrontCounterClockwise = TRUE;
 
 		result = impl->device->CreateRasterizerState(
@@ -412,8 +454,8 @@ namespace sge
 		depthStencilDesc.BackFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
 		depthStencilDesc.BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
 		depthStencilDesc.DepthEnable = TRUE;
-		depthStencilDesc.DepthFunc = D3D11_COMPARISON_LESS;
-		depthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+		depthStencilDesc.DepthFunc = getDepthFunction(state.depthFunction);
+		depthStencilDesc.DepthWriteMask = state.depthWrite ? D3D11_DEPTH_WRITE_MASK_ALL : D3D11_DEPTH_WRITE_MASK_ZERO;
 		depthStencilDesc.FrontFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
 		depthStencilDesc.FrontFace.StencilDepthFailOp = D3D11_STENCIL_OP_INCR;
 		depthStencilDesc.FrontFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
@@ -444,6 +486,25 @@ namespace sge
 		blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
 		blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
 
+		// The same factors for color and alpha, like glBlendFunc on GL4.
+		switch (state.blendMode)
+		{
+		case BlendMode::ALPHA:
+			blendDesc.RenderTarget[0].BlendEnable = TRUE;
+			blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+			blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+			blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_SRC_ALPHA;
+			blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+			break;
+		case BlendMode::ADDITIVE:
+			blendDesc.RenderTarget[0].BlendEnable = TRUE;
+			blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_ONE;
+			blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+			break;
+		default:
+			break;
+		}
+
 		result = impl->device->CreateBlendState(
 			&blendDesc, 
 			&dx11Pipeline->blendState);
@@ -655,7 +716,7 @@ namespace sge
 		impl->context->IASetInputLayout(dx11Pipeline->vertexLayout->inputLayout);
 		impl->context->VSSetShader(dx11Pipeline->vertexShader->vertexShader, 0, 0);
 		impl->context->PSSetShader(dx11Pipeline->pixelShader->pixelShader, 0, 0);
-		impl->context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		impl->context->IASetPrimitiveTopology(getPrimitiveTopology(dx11Pipeline->header.state.topology));
 		impl->context->PSSetSamplers(0, 1, &dx11Pipeline->samplerState);
 		impl->context->RSSetState(dx11Pipeline->rasterizerState);
 		impl->context->OMSetDepthStencilState(dx11Pipeline->depthStencilState, 0);
@@ -687,7 +748,7 @@ namespace sge
 		DX11Buffer* dx11Buffer = reinterpret_cast<DX11Buffer*>(buffer);
 
 		// TODO do we really need to do this?
-		UINT stride = impl->pipeline->vertexLayout->header.stride * sizeof(float);
+		UINT stride = impl->pipeline->vertexLayout->header.stride;
 		UINT offset = 0;
 
 		impl->context->IASetVertexBuffers(0, 1, &dx11Buffer->buffer, &stride, &offset);
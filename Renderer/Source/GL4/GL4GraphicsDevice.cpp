@@ -1,7 +1,13 @@
 #ifdef OPENGL4
 
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <vector>
 
 
 #include "SDL2/SDL.h"
@@ -12,6 +18,7 @@
 #include "Renderer/GL4/GL4Buffer.h"
 #include "Renderer/GL4/GL4CubeMap.h"
 #include "Renderer/GL4/GL4Pipeline.h"
+#include "Renderer/GL4/GL4Query.h"
 #include "Renderer/GL4/GL4RenderTarget.h"
 #include "Renderer/GL4/GL4Shader.h"
 #include "Renderer/GL4/GL4Texture.h"
@@ -22,6 +29,15 @@
 
 #include "Core/Assert.h"
 
+// EXT_texture_compression_s3tc isn't in the glad loader, every desktop driver exposes it.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 namespace sge
 {
 	void checkError()
@@ -45,10 +61,344 @@ namespace sge
 		}
 	}
 
+	namespace
+	{
+		// The glad loader stops at 4.4, so the 4.5 direct state access entry points are loaded here.
+		typedef void (APIENTRYP CreateObjectsFunction)(GLsizei n, GLuint* objects);
+		typedef void (APIENTRYP CreateTexturesFunction)(GLenum target, GLsizei n, GLuint* textures);
+		typedef void (APIENTRYP NamedBufferStorageFunction)(GLuint buffer, GLsizeiptr size, const void* data, GLbitfield flags);
+		typedef void (APIENTRYP NamedBufferDataFunction)(GLuint buffer, GLsizeiptr size, const void* data, GLenum usage);
+		typedef void (APIENTRYP NamedBufferSubDataFunction)(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);
+		typedef void (APIENTRYP TextureStorage2DFunction)(GLuint texture, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height);
+		typedef void (APIENTRYP TextureSubImage2DFunction)(GLuint texture, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+		typedef void (APIENTRYP CompressedTextureSubImage2DFunction)(GLuint texture, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLsizei size, const void* data);
+		typedef void (APIENTRYP TextureParameteriFunction)(GLuint texture, GLenum name, GLint value);
+		typedef void (APIENTRYP TextureParameterfFunction)(GLuint texture, GLenum name, GLfloat value);
+		typedef void (APIENTRYP GenerateTextureMipmapFunction)(GLuint texture);
+		typedef void (APIENTRYP VertexArrayAttribFunction)(GLuint vao, GLuint index);
+		typedef void (APIENTRYP VertexArrayAttribFormatFunction)(GLuint vao, GLuint index, GLint size, GLenum type, GLboolean normalized, GLuint offset);
+		typedef void (APIENTRYP VertexArrayAttribBindingFunction)(GLuint vao, GLuint index, GLuint binding);
+		typedef void (APIENTRYP VertexArrayElementBufferFunction)(GLuint vao, GLuint buffer);
+
+		struct DirectStateAccess
+		{
+			CreateObjectsFunction createBuffers;
+			NamedBufferStorageFunction namedBufferStorage;
+			NamedBufferDataFunction namedBufferData;
+			NamedBufferSubDataFunction namedBufferSubData;
+
+			CreateTexturesFunction createTextures;
+			TextureStorage2DFunction textureStorage2D;
+			TextureSubImage2DFunction textureSubImage2D;
+			CompressedTextureSubImage2DFunction compressedTextureSubImage2D;
+			TextureParameteriFunction textureParameteri;
+			TextureParameterfFunction textureParameterf;
+			GenerateTextureMipmapFunction generateTextureMipmap;
+
+			CreateObjectsFunction createVertexArrays;
+			VertexArrayAttribFunction enableVertexArrayAttrib;
+			VertexArrayAttribFormatFunction vertexArrayAttribFormat;
+			VertexArrayAttribBindingFunction vertexArrayAttribBinding;
+			VertexArrayElementBufferFunction vertexArrayElementBuffer;
+		};
+
+		template <typename T>
+		bool loadFunction(T& function, const char* name)
+		{
+			function = reinterpret_cast<T>(SDL_GL_GetProcAddress(name));
+
+			return function != nullptr;
+		}
+
+		// Returns false when any entry point is missing, the caller keeps the bind-to-edit path then.
+		bool loadDirectStateAccess(DirectStateAccess& dsa)
+		{
+			return
+				loadFunction(dsa.createBuffers, "glCreateBuffers") &&
+				loadFunction(dsa.namedBufferStorage, "glNamedBufferStorage") &&
+				loadFunction(dsa.namedBufferData, "glNamedBufferData") &&
+				loadFunction(dsa.namedBufferSubData, "glNamedBufferSubData") &&
+				loadFunction(dsa.createTextures, "glCreateTextures") &&
+				loadFunction(dsa.textureStorage2D, "glTextureStorage2D") &&
+				loadFunction(dsa.textureSubImage2D, "glTextureSubImage2D") &&
+				loadFunction(dsa.compressedTextureSubImage2D, "glCompressedTextureSubImage2D") &&
+				loadFunction(dsa.textureParameteri, "glTextureParameteri") &&
+				loadFunction(dsa.textureParameterf, "glTextureParameterf") &&
+				loadFunction(dsa.generateTextureMipmap, "glGenerateTextureMipmap") &&
+				loadFunction(dsa.createVertexArrays, "glCreateVertexArrays") &&
+				loadFunction(dsa.enableVertexArrayAttrib, "glEnableVertexArrayAttrib") &&
+				loadFunction(dsa.vertexArrayAttribFormat, "glVertexArrayAttribFormat") &&
+				loadFunction(dsa.vertexArrayAttribBinding, "glVertexArrayAttribBinding") &&
+				loadFunction(dsa.vertexArrayElementBuffer, "glVertexArrayElementBuffer");
+		}
+
+		void getAttribFormat(VertexFormat format, GLenum& type, GLboolean& normalized)
+		{
+			normalized = GL_TRUE;
+
+			switch (format)
+			{
+			case VertexFormat::FLOAT: type = GL_FLOAT; normalized = GL_FALSE; break;
+			case VertexFormat::HALF: type = GL_HALF_FLOAT; normalized = GL_FALSE; break;
+			case VertexFormat::UNORM8: type = GL_UNSIGNED_BYTE; break;
+			case VertexFormat::SNORM8: type = GL_BYTE; break;
+			case VertexFormat::UNORM16: type = GL_UNSIGNED_SHORT; break;
+			case VertexFormat::SNORM16: type = GL_SHORT; break;
+			default: type = GL_FLOAT; normalized = GL_FALSE; break;
+			}
+		}
+
+		// Returns 0 for the formats that are uploaded uncompressed.
+		GLenum getCompressedFormat(Format format)
+		{
+			switch (format)
+			{
+			case Format::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+			case Format::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+			case Format::BC5: return GL_COMPRESSED_RG_RGTC2;
+			default: return 0;
+			}
+		}
+
+		// Number of levels in a full mip chain, immutable storage allocates them all up front.
+		GLsizei getMipLevels(size_t width, size_t height)
+		{
+			GLsizei levels = 1;
+			size_t size = width > height ? width : height;
+
+			while (size > 1)
+			{
+				size >>= 1;
+				levels++;
+			}
+
+			return levels;
+		}
+
+		// Immutable storage for the layers and levels of a texture array, sampled like the 2D textures.
+		GLuint createArrayStorage(const GL4Texture* texture)
+		{
+			float maxValue;
+			glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxValue);
+
+			GLuint id;
+			glGenTextures(1, &id);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+
+			glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxValue);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+			glTexStorage3D(GL_TEXTURE_2D_ARRAY, texture->levels, texture->format, texture->width, texture->height, texture->layers);
+
+			glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+			return id;
+		}
+
+		GLenum getDepthFunction(DepthFunction function)
+		{
+			switch (function)
+			{
+			case DepthFunction::LESS_EQUAL: return GL_LEQUAL;
+			case DepthFunction::EQUAL: return GL_EQUAL;
+			case DepthFunction::ALWAYS: return GL_ALWAYS;
+			default: return GL_LESS;
+			}
+		}
+
+		// FNV-1a, the program binary cache key.
+		uint64 hash(uint64 value, const void* data, size_t size)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+			for (size_t i = 0; i < size; i++)
+			{
+				value = (value ^ bytes[i]) * 1099511628211ull;
+			}
+
+			return value;
+		}
+
+		void compileShader(GL4Shader* shader)
+		{
+			if (shader->id)
+			{
+				return;
+			}
+
+			GLint success;
+			GLchar infoLog[512];
+			const char* source = shader->source.c_str();
+
+			shader->id = glCreateShader(shader->type);
+
+			glShaderSource(shader->id, 1, &source, nullptr);
+			glCompileShader(shader->id);
+
+			glGetShaderiv(shader->id, GL_COMPILE_STATUS, &success);
+
+			if (!success)
+			{
+				glGetShaderInfoLog(shader->id, 512, nullptr, infoLog);
+				std::cout << "GL ERROR: Shader compilation: " << std::endl << infoLog << std::endl;
+			}
+		}
+
+		// The defines go after #version, which has to stay the first line.
+		std::string addDefines(const std::string& source, size_t count, const char* const defines[])
+		{
+			std::string lines;
+
+			for (size_t i = 0; i < count; i++)
+			{
+				lines += std::string("#define ") + defines[i] + "\n";
+			}
+
+			size_t position = 0;
+
+			if (source.compare(0, 8, "#version") == 0)
+			{
+				position = source.find('\n');
+				position = position == std::string::npos ? source.size() : position + 1;
+			}
+
+			return source.substr(0, position) + lines + source.substr(position);
+		}
+
+		bool isSampler(GLenum type)
+		{
+			switch (type)
+			{
+			case GL_SAMPLER_1D:
+			case GL_SAMPLER_2D:
+			case GL_SAMPLER_3D:
+			case GL_SAMPLER_CUBE:
+			case GL_SAMPLER_2D_SHADOW:
+			case GL_SAMPLER_CUBE_SHADOW:
+			case GL_SAMPLER_2D_ARRAY:
+			case GL_SAMPLER_2D_ARRAY_SHADOW:
+			case GL_SAMPLER_2D_MULTISAMPLE:
+			case GL_INT_SAMPLER_2D:
+			case GL_UNSIGNED_INT_SAMPLER_2D:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		std::string getResourceName(GLuint program, GLenum programInterface, GLuint index)
+		{
+			GLchar name[512];
+			GLsizei length = 0;
+
+			glGetProgramResourceName(program, programInterface, index, sizeof(name), &length, name);
+
+			return std::string(name, length);
+		}
+
+		void reflectBlocks(GLuint program, GLenum programInterface, std::vector<ShaderBlock>& blocks)
+		{
+			GLint count = 0;
+			glGetProgramInterfaceiv(program, programInterface, GL_ACTIVE_RESOURCES, &count);
+
+			blocks.resize(count);
+
+			for (GLint i = 0; i < count; i++)
+			{
+				const GLenum properties[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+				GLint values[2];
+
+				glGetProgramResourceiv(program, programInterface, i, 2, properties, 2, nullptr, values);
+
+				blocks[i].name = getResourceName(program, programInterface, i);
+				blocks[i].binding = values[0];
+				blocks[i].size = values[1];
+			}
+		}
+
+		// Indices of the blocks are their positions in the lists, uniforms point back at them.
+		void reflectProgram(GLuint program, PipelineReflection& reflection)
+		{
+			if (!program)
+			{
+				return;
+			}
+
+			reflectBlocks(program, GL_UNIFORM_BLOCK, reflection.uniformBlocks);
+			reflectBlocks(program, GL_SHADER_STORAGE_BLOCK, reflection.storageBlocks);
+
+			GLint count = 0;
+			glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+
+			for (GLint i = 0; i < count; i++)
+			{
+				const GLenum properties[] = { GL_BLOCK_INDEX, GL_OFFSET, GL_ARRAY_SIZE, GL_TYPE, GL_LOCATION };
+				GLint values[5];
+
+				glGetProgramResourceiv(program, GL_UNIFORM, i, 5, properties, 5, nullptr, values);
+
+				if (values[0] >= 0)
+				{
+					UniformMember member = { getResourceName(program, GL_UNIFORM, i), size_t(values[1]), size_t(values[2]) };
+					reflection.uniformBlocks[values[0]].members.push_back(member);
+				}
+				else if (isSampler(values[3]))
+				{
+					// The unit is the initial value, set by the binding layout qualifier.
+					GLint unit = 0;
+					glGetUniformiv(program, values[4], &unit);
+
+					ShaderSampler sampler = { getResourceName(program, GL_UNIFORM, i), size_t(unit) };
+					reflection.samplers.push_back(sampler);
+				}
+			}
+
+			reflection.reflected = true;
+		}
+
+		GLenum getPrimitiveMode(PrimitiveTopology topology)
+		{
+			switch (topology)
+			{
+			case PrimitiveTopology::TRIANGLE_STRIP: return GL_TRIANGLE_STRIP;
+			case PrimitiveTopology::LINE: return GL_LINES;
+			case PrimitiveTopology::POINT: return GL_POINTS;
+			default: return GL_TRIANGLES;
+			}
+		}
+	}
+
+	// Staging memory of the streamed textures, 4096 x 4096 RGBA fits.
+	const size_t STAGING_SIZE = 64 * 1024 * 1024;
+
+	// A texture waiting in the staging memory, texture is null once the texture has been deleted.
+	struct TextureUpload
+	{
+		GL4Texture* texture;
+		size_t offset;
+		size_t size;
+		size_t reserved;	// Bytes taken from the ring, including those skipped at its end.
+		uint32 ticket;
+		bool staged;
+	};
+
+	// Staging memory is reused once the copies reading it have completed.
+	struct StagingFence
+	{
+		GLsync sync;
+		size_t reserved;
+	};
+
 	struct GraphicsDevice::Impl
 	{
 		Impl(Window& window) :
-			window(window.getSDLWindow()), context(SDL_GL_CreateContext(window.getSDLWindow())), pipeline(nullptr)
+			window(window.getSDLWindow()), context(SDL_GL_CreateContext(window.getSDLWindow())), pipeline(nullptr),
+			blendMode(BlendMode::NONE), cullMode(CullMode::BACK), depthFunction(GL_LESS), depthWrite(GL_TRUE), colorWrite(GL_TRUE),
+			directStateAccess(false), programBinaries(false),
+			stagingBuffer(0), stagingMemory(nullptr), stagingHead(0), stagingUsed(0), nextTicket(0)
 		{
 		}
 
@@ -60,8 +410,216 @@ namespace sge
 		SDL_Window* window;
 		SDL_GLContext context;
 		GL4Pipeline* pipeline;
+
+		// Current fixed function state, redundant changes are skipped.
+		BlendMode blendMode;
+		CullMode cullMode;
+		GLenum depthFunction;
+		GLboolean depthWrite;
+		GLboolean colorWrite;
+
+		// Objects are created and edited by name when the context has 4.5 or ARB_direct_state_access.
+		bool directStateAccess;
+		DirectStateAccess dsa;
+
+		// Program binary cache, keyed by the shader sources and the driver.
+		std::string programCache;
+		std::string driverVersion;
+		bool programBinaries;
+
+		GLuint createProgram(GL4Shader* const shaders[], size_t count);
+		GLuint loadProgramBinary(const std::string& path);
+		void storeProgramBinary(GLuint program, const std::string& path);
+
+		// Texture streaming, a ring of persistently mapped staging memory any thread may write into.
+		// The mutex guards the ring and the uploads, the GL objects are only touched by the device thread.
+		GLuint stagingBuffer;
+		uint8* stagingMemory;
+		size_t stagingHead;
+		size_t stagingUsed;
+		uint32 nextTicket;
+		std::deque<TextureUpload> uploads;
+		std::deque<StagingFence> stagingFences;
+		std::mutex stagingMutex;
+
+		void createStagingBuffer();
+		void copyUpload(const TextureUpload& upload);
 	};
 
+	void GraphicsDevice::Impl::createStagingBuffer()
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		glGenBuffers(1, &stagingBuffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, STAGING_SIZE, nullptr, flags);
+
+		stagingMemory = static_cast<uint8*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, STAGING_SIZE, flags));
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		checkError();
+	}
+
+	void GraphicsDevice::Impl::copyUpload(const TextureUpload& upload)
+	{
+		GL4Texture* texture = upload.texture;
+
+		// Pixel calls read from the bound unpack buffer, the pointer is an offset into it.
+		const void* offset = reinterpret_cast<const void*>(upload.offset);
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer);
+
+		if (directStateAccess)
+		{
+			dsa.textureSubImage2D(texture->id, 0, 0, 0, texture->width, texture->height, GL_RGBA, GL_UNSIGNED_BYTE, offset);
+			dsa.generateTextureMipmap(texture->id);
+		}
+		else
+		{
+			glBindTexture(GL_TEXTURE_2D, texture->id);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture->width, texture->height, GL_RGBA, GL_UNSIGNED_BYTE, offset);
+			glGenerateMipmap(GL_TEXTURE_2D);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		texture->resident = true;
+
+		checkError();
+	}
+
+	// Links the shaders, or loads the program from the cache when the driver accepts the binary.
+	GLuint GraphicsDevice::Impl::createProgram(GL4Shader* const shaders[], size_t count)
+	{
+		std::string path;
+
+		if (programBinaries && !programCache.empty())
+		{
+			uint64 key = hash(14695981039346656037ull, driverVersion.data(), driverVersion.size());
+
+			for (size_t i = 0; i < count; i++)
+			{
+				key = hash(key, &shaders[i]->type, sizeof(GLenum));
+				key = hash(key, shaders[i]->source.data(), shaders[i]->source.size());
+			}
+
+			char name[32];
+			std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+
+			path = programCache + "/" + name;
+		}
+
+		GLuint program = path.empty() ? 0 : loadProgramBinary(path);
+
+		if (!program)
+		{
+			GLint success;
+			GLchar infoLog[512];
+
+			program = glCreateProgram();
+
+			for (size_t i = 0; i < count; i++)
+			{
+				compileShader(shaders[i]);
+				glAttachShader(program, shaders[i]->id);
+			}
+
+			if (!path.empty())
+			{
+				glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			}
+
+			glLinkProgram(program);
+
+			glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+			if (!success)
+			{
+				glGetProgramInfoLog(program, 512, nullptr, infoLog);
+				std::cout << "GL ERROR: Program linking: " << std::endl << infoLog << std::endl;
+
+				glDeleteProgram(program);
+			}
+			else if (!path.empty())
+			{
+				storeProgramBinary(program, path);
+			}
+		}
+
+		checkError();
+
+		return program;
+	}
+
+	GLuint GraphicsDevice::Impl::loadProgramBinary(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+
+		if (!file)
+		{
+			return 0;
+		}
+
+		GLenum format = 0;
+		file.read(reinterpret_cast<char*>(&format), sizeof(format));
+
+		std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		if (!file.eof() || binary.empty())
+		{
+			return 0;
+		}
+
+		GLuint program = glCreateProgram();
+		GLint success;
+
+		glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+		// Drivers reject binaries of other versions or hardware, the program is then linked from source.
+		if (!success)
+		{
+			std::cout << "Program binary " << path << " rejected, linking from source" << std::endl;
+
+			glDeleteProgram(program);
+			program = 0;
+		}
+
+		// A rejected binary may leave an error behind.
+		while (glGetError() != GL_NO_ERROR)
+		{
+		}
+
+		return program;
+	}
+
+	void GraphicsDevice::Impl::storeProgramBinary(GLuint program, const std::string& path)
+	{
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+		if (length <= 0)
+		{
+			return;
+		}
+
+		std::vector<char> binary(length);
+		GLenum format = 0;
+
+		glGetProgramBinary(program, length, &length, &format, binary.data());
+
+		std::ofstream file(path, std::ios::binary);
+
+		// A missing cache directory only costs the next start its link time.
+		if (file)
+		{
+			file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+			file.write(binary.data(), length);
+		}
+	}
+
 	GraphicsDevice::GraphicsDevice(Window& window) :
 		impl(new Impl(window))
 	{
@@ -84,20 +642,57 @@ namespace sge
 		glGetIntegerv(GL_MINOR_VERSION, &minor);
 
 		std::cout << "Using OpenGL version " << major << "." << minor << std::endl;
-		
+
+		if (major > 4 || (major == 4 && minor >= 5) || SDL_GL_ExtensionSupported("GL_ARB_direct_state_access"))
+		{
+			impl->directStateAccess = loadDirectStateAccess(impl->dsa);
+		}
+
+		std::cout << "Direct state access: " << (impl->directStateAccess ? "enabled" : "not available") << std::endl;
+
+		GLint binaryFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+
+		impl->programBinaries = binaryFormats > 0;
+		impl->driverVersion = std::string(reinterpret_cast<const char*>(glGetString(GL_VENDOR))) + "|" +
+			reinterpret_cast<const char*>(glGetString(GL_RENDERER)) + "|" +
+			reinterpret_cast<const char*>(glGetString(GL_VERSION));
+
+		// Matches the default PipelineState, pipelines change the rest when bound.
 		glEnable(GL_CULL_FACE);
+		glCullFace(GL_BACK);
 		glEnable(GL_DEPTH_TEST);
-        glEnable(GL_BLEND);
+		glDisable(GL_BLEND);
 		glEnable(GL_MULTISAMPLE);
 
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
 		checkError();
 	}
 
 	void GraphicsDevice::deinit()
 	{
+		for (auto& fence : impl->stagingFences)
+		{
+			glDeleteSync(fence.sync);
+		}
+
+		impl->stagingFences.clear();
+		impl->uploads.clear();
+
+		if (impl->stagingBuffer)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, impl->stagingBuffer);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glDeleteBuffers(1, &impl->stagingBuffer);
 
+			impl->stagingBuffer = 0;
+			impl->stagingMemory = nullptr;
+		}
+	}
+
+	void GraphicsDevice::setProgramCache(const char* directory)
+	{
+		impl->programCache = directory ? directory : "";
 	}
 
 	void GraphicsDevice::swap()
@@ -105,6 +700,16 @@ namespace sge
 		SDL_GL_SwapWindow(impl->window);
 	}
 
+	void GraphicsDevice::bindContext()
+	{
+		SDL_GL_MakeCurrent(impl->window, impl->context);
+	}
+
+	void GraphicsDevice::unbindContext()
+	{
+		SDL_GL_MakeCurrent(impl->window, nullptr);
+	}
+
 	void GraphicsDevice::clear(float r, float g, float b, float a)
 	{
 		glClearColor(r, g, b, a);
@@ -116,14 +721,23 @@ namespace sge
 	Buffer* GraphicsDevice::createBuffer(BufferType type, BufferUsage usage, size_t size)
 	{
 		GL4Buffer* buffer = new GL4Buffer();
-		
-		glGenBuffers(1, &buffer->id);
+
+		if (impl->directStateAccess)
+		{
+			impl->dsa.createBuffers(1, &buffer->id);
+		}
+		else
+		{
+			glGenBuffers(1, &buffer->id);
+		}
 
 		switch (type)
 		{
 		case BufferType::INDEX: buffer->target = GL_ELEMENT_ARRAY_BUFFER; break;
 		case BufferType::VERTEX: buffer->target = GL_ARRAY_BUFFER; break;
 		case BufferType::UNIFORM: buffer->target = GL_UNIFORM_BUFFER; break;
+		case BufferType::STORAGE: buffer->target = GL_SHADER_STORAGE_BUFFER; break;
+		case BufferType::INDIRECT: buffer->target = GL_DRAW_INDIRECT_BUFFER; break;
 		}
 
 		switch (usage)
@@ -149,17 +763,17 @@ namespace sge
 		buffer = nullptr;
 	}
 
-	Pipeline* GraphicsDevice::createPipeline(VertexLayoutDescription* vertexLayoutDescription, Shader* vertexShader, Shader* pixelShader)
+	Pipeline* GraphicsDevice::createPipeline(VertexLayoutDescription* vertexLayoutDescription, Shader* vertexShader, Shader* pixelShader, const PipelineState& state)
 	{
 		GL4Pipeline* gl4Pipeline = new GL4Pipeline();
+
+		gl4Pipeline->header.state = state;
+		gl4Pipeline->mode = getPrimitiveMode(state.topology);
 		GL4Shader* gl4VertexShader = reinterpret_cast<GL4Shader*>(vertexShader);
 		GL4Shader* gl4PixelShader = reinterpret_cast<GL4Shader*>(pixelShader);
 
-		glGenVertexArrays(1, &gl4Pipeline->vao);
-		glBindVertexArray(gl4Pipeline->vao);
-
-		GLint success;
-		GLchar infoLog[512];
+		gl4Pipeline->vertexSource = gl4VertexShader->source;
+		gl4Pipeline->pixelSource = gl4PixelShader->source;
 
 		gl4Pipeline->vertexLayout.count = vertexLayoutDescription->count;
 
@@ -167,59 +781,121 @@ namespace sge
 
 		for (size_t i = 0; i < gl4Pipeline->vertexLayout.count; i++)
 		{
-			gl4Pipeline->vertexLayout.elements[i].size = vertexLayoutDescription->elements[i].size;
+			gl4Pipeline->vertexLayout.elements[i] = vertexLayoutDescription->elements[i];
 			gl4Pipeline->vertexLayout.elements[i].offset = stride;
-			stride += vertexLayoutDescription->elements[i].size;
+			stride += getVertexElementBytes(vertexLayoutDescription->elements[i]);
 		}
 
 		gl4Pipeline->vertexLayout.stride = stride;
 
-		gl4Pipeline->program = glCreateProgram();
+		// The format lives in the VAO, binding a vertex buffer later only swaps binding point 0.
+		if (impl->directStateAccess)
+		{
+			impl->dsa.createVertexArrays(1, &gl4Pipeline->vao);
+		}
+		else
+		{
+			glGenVertexArrays(1, &gl4Pipeline->vao);
+			glBindVertexArray(gl4Pipeline->vao);
+		}
+
+		for (size_t i = 0; i < gl4Pipeline->vertexLayout.count; i++)
+		{
+			const VertexElement& element = gl4Pipeline->vertexLayout.elements[i];
+
+			GLenum type;
+			GLboolean normalized;
+			getAttribFormat(element.format, type, normalized);
 
-		glAttachShader(gl4Pipeline->program, gl4VertexShader->id);
-		glAttachShader(gl4Pipeline->program, gl4PixelShader->id);
-		glLinkProgram(gl4Pipeline->program);
+			if (impl->directStateAccess)
+			{
+				impl->dsa.enableVertexArrayAttrib(gl4Pipeline->vao, i);
+				impl->dsa.vertexArrayAttribFormat(gl4Pipeline->vao, i, element.size, type, normalized, element.offset);
+				impl->dsa.vertexArrayAttribBinding(gl4Pipeline->vao, i, 0);
+			}
+			else
+			{
+				glEnableVertexAttribArray(i);
+				glVertexAttribFormat(i, element.size, type, normalized, element.offset);
+				glVertexAttribBinding(i, 0);
+			}
+		}
 
-		glGetProgramiv(gl4Pipeline->program, GL_LINK_STATUS, &success);
+		GL4Shader* shaders[] = { gl4VertexShader, gl4PixelShader };
 
-		if (!success)
-		{
-			glGetProgramInfoLog(gl4Pipeline->program, 512, nullptr, infoLog);
-			std::cout << "GL ERROR: Program linking: " << std::endl << infoLog << std::endl;
+		gl4Pipeline->program = impl->createProgram(shaders, 2);
+
+		reflectProgram(gl4Pipeline->program, gl4Pipeline->header.reflection);
 
-			glDeleteProgram(gl4Pipeline->program);
+		std::cout << "Active uniform blocks: " << gl4Pipeline->header.reflection.uniformBlocks.size() << std::endl;
+
+		if (!impl->directStateAccess)
+		{
+			glBindVertexArray(0);
 		}
 
+		checkError();
 
-		GLint numberOfUniformBlocks = 0;
-		GLuint* uniformBlocks;
+		return &gl4Pipeline->header;
+	}
 
-		glGetProgramInterfaceiv(gl4Pipeline->program, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &numberOfUniformBlocks);
+	Pipeline* GraphicsDevice::createPipelineVariant(Pipeline* pipeline, size_t count, const char* const defines[])
+	{
+		GL4Pipeline* gl4Pipeline = reinterpret_cast<GL4Pipeline*>(pipeline);
+
+		SGE_ASSERT(!gl4Pipeline->pixelSource.empty());
+
+		GL4Shader vertexShader;
+		vertexShader.header.type = ShaderType::VERTEX;
+		vertexShader.id = 0;
+		vertexShader.type = GL_VERTEX_SHADER;
+		vertexShader.source = addDefines(gl4Pipeline->vertexSource, count, defines);
+
+		GL4Shader pixelShader;
+		pixelShader.header.type = ShaderType::PIXEL;
+		pixelShader.id = 0;
+		pixelShader.type = GL_FRAGMENT_SHADER;
+		pixelShader.source = addDefines(gl4Pipeline->pixelSource, count, defines);
 
-		uniformBlocks = new GLuint[numberOfUniformBlocks];
+		VertexLayoutDescription vertexLayoutDescription;
+		vertexLayoutDescription.count = gl4Pipeline->vertexLayout.count;
 
-		for (GLint i = 0; i < numberOfUniformBlocks; i++)
+		for (size_t i = 0; i < vertexLayoutDescription.count; i++)
 		{
-			const GLenum props[] = { GL_BLOCK_INDEX };
-			const GLenum props2[] = { GL_BUFFER_BINDING };
+			vertexLayoutDescription.elements[i] = gl4Pipeline->vertexLayout.elements[i];
+		}
 
-			GLint index;
-			GLint binding;
-			GLchar name[512];
-			GLsizei size;
+		Pipeline* variant = createPipeline(&vertexLayoutDescription, &vertexShader.header, &pixelShader.header, pipeline->state);
 
-			//glGetProgramResourceiv(gl4Pipeline->program, GL_UNIFORM, i, 1, props, 1, nullptr, &index);
-			glGetProgramResourceiv(gl4Pipeline->program, GL_UNIFORM_BLOCK, i, 1, props2, 1, nullptr, &binding);
-			glGetProgramResourceName(gl4Pipeline->program, GL_UNIFORM_BLOCK, i, 512, &size, name);
-			index = glGetUniformBlockIndex(gl4Pipeline->program, name);
-			std::cout << "Found uniform block: " << name << " at index " << index << " with binding " << binding << std::endl;
+		// Nothing was compiled when the program came from the cache.
+		if (vertexShader.id)
+		{
+			glDeleteShader(vertexShader.id);
+		}
 
-			//glUniformBlockBinding(gl4Pipeline->program, uniformBlocks[index], index);
+		if (pixelShader.id)
+		{
+			glDeleteShader(pixelShader.id);
 		}
 
-		std::cout << "Active uniform blocks: " << numberOfUniformBlocks << std::endl;
+		checkError();
 
-		glBindVertexArray(0);
+		return variant;
+	}
+
+	Pipeline* GraphicsDevice::createComputePipeline(Shader* computeShader)
+	{
+		GL4Pipeline* gl4Pipeline = new GL4Pipeline();
+		GL4Shader* gl4ComputeShader = reinterpret_cast<GL4Shader*>(computeShader);
+
+		// No vertex input, binding the pipeline binds no VAO.
+		gl4Pipeline->mode = GL_POINTS;
+		gl4Pipeline->vertexLayout.count = 0;
+		gl4Pipeline->vertexLayout.stride = 0;
+		gl4Pipeline->vao = 0;
+
+		gl4Pipeline->program = impl->createProgram(&gl4ComputeShader, 1);
+		reflectProgram(gl4Pipeline->program, gl4Pipeline->header.reflection);
 
 		checkError();
 
@@ -239,6 +915,22 @@ namespace sge
 	}
 
     RenderTarget* GraphicsDevice::createRenderTarget(size_t count, size_t width, size_t height, bool depth, bool stencil)
+    {
+        Format* formats = new Format[count];
+
+        for (size_t i = 0; i < count; i++)
+        {
+            formats[i] = Format::RGB;
+        }
+
+        RenderTarget* renderTarget = createRenderTarget(count, formats, width, height, depth, stencil);
+
+        delete[] formats;
+
+        return renderTarget;
+    }
+
+    RenderTarget* GraphicsDevice::createRenderTarget(size_t count, const Format formats[], size_t width, size_t height, bool depth, bool stencil)
     {
         GLint maxColorAttachments = 0;
         GLint maxDrawBuf = 0;
@@ -258,7 +950,7 @@ namespace sge
 
         for (size_t i = 0; i < count; i++)
         {
-            gl4RenderTarget->header.textures[i] = createTexture(width, height, nullptr, Format::RGB);
+            gl4RenderTarget->header.textures[i] = createTexture(width, height, nullptr, formats[i]);
             glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, reinterpret_cast<GL4Texture*>(gl4RenderTarget->header.textures[i])->id, 0);
             gl4RenderTarget->buffers[i] = GL_COLOR_ATTACHMENT0 + i;
         }
@@ -305,140 +997,589 @@ namespace sge
 	Shader* GraphicsDevice::createShader(ShaderType type, const char* source, size_t size)
 	{
 		GL4Shader* shader = new GL4Shader();
-		GLint success;
-		GLchar infoLog[512];
 
-		switch (type)
-		{
-		case ShaderType::VERTEX: shader->id = glCreateShader(GL_VERTEX_SHADER); break;
-		case ShaderType::PIXEL: shader->id = glCreateShader(GL_FRAGMENT_SHADER); break;
-		}
+		switch (type)
+		{
+		case ShaderType::VERTEX: shader->type = GL_VERTEX_SHADER; break;
+		case ShaderType::PIXEL: shader->type = GL_FRAGMENT_SHADER; break;
+		case ShaderType::COMPUTE: shader->type = GL_COMPUTE_SHADER; break;
+		}
+
+		// Compiled when a pipeline using it has to be linked from source.
+		shader->header.type = type;
+		shader->id = 0;
+		shader->source = source;
+
+		return &shader->header;
+	}
+
+	void GraphicsDevice::deleteShader(Shader* shader)
+	{
+		GL4Shader* gl4Shader = reinterpret_cast<GL4Shader*>(shader);
+
+		if (gl4Shader->id)
+		{
+			glDeleteShader(gl4Shader->id);
+		}
+
+		checkError();
+
+		delete gl4Shader;
+		shader = nullptr;
+	}
+
+    Texture* GraphicsDevice::createTexture(size_t width, size_t height, unsigned char* source, Format format)
+    {
+        GL4Texture* gl4Texture = new GL4Texture();
+        gl4Texture->width = static_cast<GLsizei>(width);
+        gl4Texture->height = static_cast<GLsizei>(height);
+        gl4Texture->resident = true;
+
+        GLenum f = GL_RGBA;
+        GLenum internalFormat = GL_RGBA;
+        GLenum sizedFormat = GL_RGBA8;
+        GLenum type = GL_UNSIGNED_BYTE;
+
+        switch (format)
+        {
+        case Format::RGB: f = internalFormat = GL_RGB; sizedFormat = GL_RGB8; break;
+        case Format::RGBA: f = internalFormat = GL_RGBA; sizedFormat = GL_RGBA8; break;
+        case Format::R32F: f = GL_RED; internalFormat = sizedFormat = GL_R32F; type = GL_FLOAT; break;
+        case Format::RGBA16F: f = GL_RGBA; internalFormat = sizedFormat = GL_RGBA16F; type = GL_FLOAT; break;
+        default: break;
+        }
+
+        gl4Texture->target = GL_TEXTURE_2D;
+        gl4Texture->layers = 0;
+        gl4Texture->format = sizedFormat;
+        gl4Texture->levels = getMipLevels(width, height);
+        gl4Texture->firstLevel = 0;
+
+        float maxValue;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxValue);
+
+        if (impl->directStateAccess)
+        {
+            GLuint id;
+            impl->dsa.createTextures(GL_TEXTURE_2D, 1, &id);
+            gl4Texture->id = id;
+
+            impl->dsa.textureParameterf(id, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxValue);
+            impl->dsa.textureParameteri(id, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            impl->dsa.textureParameteri(id, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            impl->dsa.textureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            impl->dsa.textureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+            impl->dsa.textureStorage2D(id, getMipLevels(width, height), sizedFormat, width, height);
+
+            if (source)
+            {
+                impl->dsa.textureSubImage2D(id, 0, 0, 0, width, height, f, type, source);
+            }
+
+            impl->dsa.generateTextureMipmap(id);
+
+            checkError();
+
+            return &gl4Texture->header;
+        }
+
+        glGenTextures(1, &gl4Texture->id);
+        checkError();
+
+        glBindTexture(GL_TEXTURE_2D, gl4Texture->id);
+
+        checkError();
+
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxValue);
+
+        checkError();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+        checkError();
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, f, type, source);
+
+        checkError();
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        checkError();
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        checkError();
+
+        return &gl4Texture->header;
+    }
+
+    Texture* GraphicsDevice::createTextTexture(size_t width, size_t height, unsigned char* source)
+    {
+        GL4Texture* gl4Texture = new GL4Texture();
+        gl4Texture->width = static_cast<GLsizei>(width);
+        gl4Texture->height = static_cast<GLsizei>(height);
+        gl4Texture->target = GL_TEXTURE_2D;
+        gl4Texture->layers = 0;
+        gl4Texture->format = GL_R8;
+        gl4Texture->levels = getMipLevels(width, height);
+        gl4Texture->firstLevel = 0;
+        gl4Texture->resident = true;
+
+        float maxValue;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxValue);
+
+        if (impl->directStateAccess)
+        {
+            GLuint id;
+            impl->dsa.createTextures(GL_TEXTURE_2D, 1, &id);
+            gl4Texture->id = id;
+
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            impl->dsa.textureParameterf(id, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxValue);
+            impl->dsa.textureParameteri(id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            impl->dsa.textureParameteri(id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            impl->dsa.textureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            impl->dsa.textureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+            impl->dsa.textureStorage2D(id, getMipLevels(width, height), GL_R8, width, height);
+            impl->dsa.textureSubImage2D(id, 0, 0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE, source);
+            impl->dsa.generateTextureMipmap(id);
+
+            checkError();
+
+            return &gl4Texture->header;
+        }
+
+        glGenTextures(1, &gl4Texture->id);
+        checkError();
+
+        glBindTexture(GL_TEXTURE_2D, gl4Texture->id);
+        checkError();
+
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxValue);
+
+        checkError();
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+        checkError();
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, source);
+
+        checkError();
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        checkError();
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        checkError();
+
+        return &gl4Texture->header;
+    }
+
+    Texture* GraphicsDevice::createTexture(size_t width, size_t height, size_t count, const unsigned char* const levels[], const size_t sizes[], Format format)
+    {
+        SGE_ASSERT(count > 0 && (format == Format::RGBA || getCompressedFormat(format) != 0));
+
+        GL4Texture* gl4Texture = new GL4Texture();
+        gl4Texture->width = static_cast<GLsizei>(width);
+        gl4Texture->height = static_cast<GLsizei>(height);
+        gl4Texture->resident = true;
+
+        GLenum compressedFormat = getCompressedFormat(format);
+        GLenum sizedFormat = compressedFormat ? compressedFormat : GL_RGBA8;
+
+        gl4Texture->target = GL_TEXTURE_2D;
+        gl4Texture->layers = 0;
+        gl4Texture->format = sizedFormat;
+        gl4Texture->levels = static_cast<GLint>(count);
+        gl4Texture->firstLevel = 0;
+
+        float maxValue;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxValue);
+
+        if (impl->directStateAccess)
+        {
+            GLuint id;
+            impl->dsa.createTextures(GL_TEXTURE_2D, 1, &id);
+            gl4Texture->id = id;
+
+            impl->dsa.textureParameterf(id, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxValue);
+            impl->dsa.textureParameteri(id, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            impl->dsa.textureParameteri(id, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            impl->dsa.textureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            impl->dsa.textureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+            impl->dsa.textureStorage2D(id, static_cast<GLsizei>(count), sizedFormat, width, height);
+
+            for (size_t level = 0; level < count; level++)
+            {
+                GLsizei levelWidth = width >> level ? static_cast<GLsizei>(width >> level) : 1;
+                GLsizei levelHeight = height >> level ? static_cast<GLsizei>(height >> level) : 1;
+
+                if (compressedFormat)
+                {
+                    impl->dsa.compressedTextureSubImage2D(id, level, 0, 0, levelWidth, levelHeight, compressedFormat, static_cast<GLsizei>(sizes[level]), levels[level]);
+                }
+                else
+                {
+                    impl->dsa.textureSubImage2D(id, level, 0, 0, levelWidth, levelHeight, GL_RGBA, GL_UNSIGNED_BYTE, levels[level]);
+                }
+            }
+
+            checkError();
+
+            return &gl4Texture->header;
+        }
+
+        glGenTextures(1, &gl4Texture->id);
+        glBindTexture(GL_TEXTURE_2D, gl4Texture->id);
+
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxValue);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+        // Immutable storage with only the cooked levels, the sampler never reads past the last one.
+        glTexStorage2D(GL_TEXTURE_2D, static_cast<GLsizei>(count), sizedFormat, width, height);
+
+        for (size_t level = 0; level < count; level++)
+        {
+            GLsizei levelWidth = width >> level ? static_cast<GLsizei>(width >> level) : 1;
+            GLsizei levelHeight = height >> level ? static_cast<GLsizei>(height >> level) : 1;
+
+            if (compressedFormat)
+            {
+                glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, levelWidth, levelHeight, compressedFormat, static_cast<GLsizei>(sizes[level]), levels[level]);
+            }
+            else
+            {
+                glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, levelWidth, levelHeight, GL_RGBA, GL_UNSIGNED_BYTE, levels[level]);
+            }
+        }
+
+        checkError();
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        return &gl4Texture->header;
+    }
+
+    Texture* GraphicsDevice::createTexture(TextureResource* source)
+    {
+        if (source->isCooked())
+        {
+            std::vector<const unsigned char*> levels;
+            std::vector<size_t> sizes;
+
+            for (size_t level = 0; level < source->getLevels(); level++)
+            {
+                levels.push_back(source->getLevelData(level));
+                sizes.push_back(source->getLevelSize(level));
+            }
+
+            return createTexture(source->getSize().x, source->getSize().y, levels.size(), levels.data(), sizes.data(), source->getPixelFormat());
+        }
+
+        return createTexture(source->getSize().x, source->getSize().y, source->getData(), Format::RGBA);
+    }
+
+    Texture* GraphicsDevice::createTextTexture(TextureResource* source)
+    {
+        return createTextTexture(source->getSize().x, source->getSize().y, source->getData());
+    }
+
+    Texture* GraphicsDevice::createStreamedTexture(size_t width, size_t height, uint32 placeholder)
+    {
+        SGE_ASSERT(width * height * 4 <= STAGING_SIZE);
+
+        if (!impl->stagingBuffer)
+        {
+            impl->createStagingBuffer();
+        }
+
+        // The storage and mip chain are allocated now, only the pixels arrive later.
+        Texture* texture = createTexture(width, height, nullptr, Format::RGBA);
+        GL4Texture* gl4Texture = reinterpret_cast<GL4Texture*>(texture);
+
+        for (GLint level = 0; level < getMipLevels(width, height); level++)
+        {
+            glClearTexImage(gl4Texture->id, level, GL_RGBA, GL_UNSIGNED_BYTE, &placeholder);
+        }
+
+        gl4Texture->resident = false;
+
+        checkError();
+
+        return texture;
+    }
+
+    size_t GraphicsDevice::getStagingSize() const
+    {
+        return STAGING_SIZE;
+    }
+
+    void* GraphicsDevice::beginTextureUpload(Texture* texture, size_t size, uint32& ticket)
+    {
+        std::lock_guard<std::mutex> lock(impl->stagingMutex);
+
+        SGE_ASSERT(impl->stagingMemory && size <= STAGING_SIZE);
+
+        // Uploads are copied and retired in order, so the free memory is the range after the head.
+        size_t offset = impl->stagingHead;
+        size_t skipped = 0;
+
+        if (offset + size > STAGING_SIZE)
+        {
+            skipped = STAGING_SIZE - offset;
+            offset = 0;
+        }
+
+        if (impl->stagingUsed + skipped + size > STAGING_SIZE)
+        {
+            return nullptr;
+        }
+
+        impl->stagingHead = offset + size;
+        impl->stagingUsed += skipped + size;
+        ticket = impl->nextTicket++;
+        impl->uploads.push_back({ reinterpret_cast<GL4Texture*>(texture), offset, size, skipped + size, ticket, false });
+
+        return impl->stagingMemory + offset;
+    }
+
+    void GraphicsDevice::endTextureUpload(uint32 ticket)
+    {
+        std::lock_guard<std::mutex> lock(impl->stagingMutex);
+
+        // Uploads are only retired once staged, so the upload is still there.
+        for (auto& upload : impl->uploads)
+        {
+            if (upload.ticket == ticket)
+            {
+                upload.staged = true;
+
+                return;
+            }
+        }
 
-		glShaderSource(shader->id, 1, &source, nullptr);
-		glCompileShader(shader->id);
+        SGE_ASSERT(false);
+    }
 
-		glGetShaderiv(shader->id, GL_COMPILE_STATUS, &success);
+    void GraphicsDevice::streamTextures(size_t budget)
+    {
+        std::lock_guard<std::mutex> lock(impl->stagingMutex);
 
-		if (!success)
-		{
-			glGetShaderInfoLog(shader->id, 512, nullptr, infoLog);
-			std::cout << "GL ERROR: Shader compilation: " << std::endl << infoLog << std::endl;
-		}
+        while (!impl->stagingFences.empty())
+        {
+            StagingFence& fence = impl->stagingFences.front();
+            GLenum status = glClientWaitSync(fence.sync, 0, 0);
 
-		checkError();
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            {
+                break;
+            }
 
-		return &shader->header;
-	}
+            glDeleteSync(fence.sync);
+            impl->stagingUsed -= fence.reserved;
+            impl->stagingFences.pop_front();
+        }
 
-	void GraphicsDevice::deleteShader(Shader* shader)
-	{
-		GL4Shader* gl4Shader = reinterpret_cast<GL4Shader*>(shader);
-		glDeleteShader(gl4Shader->id);
+        size_t copied = 0;
+        size_t reserved = 0;
 
-		checkError();
+        // At least one texture is copied, so a texture larger than the budget still arrives.
+        while (!impl->uploads.empty() && impl->uploads.front().staged && (copied == 0 || copied + impl->uploads.front().size <= budget))
+        {
+            const TextureUpload& upload = impl->uploads.front();
 
-		delete gl4Shader;
-		shader = nullptr;
-	}
+            if (upload.texture)
+            {
+                impl->copyUpload(upload);
+                copied += upload.size;
+            }
 
-    Texture* GraphicsDevice::createTexture(size_t width, size_t height, unsigned char* source, Format format)
+            reserved += upload.reserved;
+            impl->uploads.pop_front();
+        }
+
+        if (reserved)
+        {
+            impl->stagingFences.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), reserved });
+        }
+    }
+
+    void GraphicsDevice::deleteTexture(Texture* texture)
     {
-        GL4Texture* gl4Texture = new GL4Texture();
+        GL4Texture* gl4Texture = reinterpret_cast<GL4Texture*>(texture);
 
-        glGenTextures(1, &gl4Texture->id);
-        checkError();
+        if (!gl4Texture->resident)
+        {
+            std::lock_guard<std::mutex> lock(impl->stagingMutex);
+
+            // The staging memory is still retired in order, only the copy is skipped.
+            for (auto& upload : impl->uploads)
+            {
+                if (upload.texture == gl4Texture)
+                {
+                    upload.texture = nullptr;
+                }
+            }
+        }
 
-        glBindTexture(GL_TEXTURE_2D, gl4Texture->id);
+        glDeleteTextures(1, &gl4Texture->id);
 
         checkError();
 
-        float maxValue;
-        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxValue);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxValue);
+        delete gl4Texture;
+        texture = nullptr;
+    }
 
-        GLenum f;
+    void GraphicsDevice::setTextureLevels(Texture* texture, size_t count, size_t firstLevel, const unsigned char* const levels[], const size_t sizes[])
+    {
+        GL4Texture* gl4Texture = reinterpret_cast<GL4Texture*>(texture);
 
-        switch (format)
+        SGE_ASSERT(gl4Texture->target == GL_TEXTURE_2D && gl4Texture->resident && firstLevel < count && count <= static_cast<size_t>(gl4Texture->levels));
+        SGE_ASSERT(gl4Texture->format == GL_RGBA8 || gl4Texture->format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ||
+            gl4Texture->format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT || gl4Texture->format == GL_COMPRESSED_RG_RGTC2);
+
+        if (firstLevel == static_cast<size_t>(gl4Texture->firstLevel))
         {
-        case Format::RGB: f = GL_RGB; break;
-        case Format::RGBA: f = GL_RGBA; break;
-        default: break;
+            return;
         }
 
-        checkError();
+        bool compressed = gl4Texture->format != GL_RGBA8;
+        GLsizei first = static_cast<GLsizei>(firstLevel);
+        GLsizei width = gl4Texture->width >> first ? gl4Texture->width >> first : 1;
+        GLsizei height = gl4Texture->height >> first ? gl4Texture->height >> first : 1;
+
+        float maxValue;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxValue);
+
+        // Immutable storage can't shrink or grow, so the levels that stay are copied into a new texture.
+        GLuint id;
+        glGenTextures(1, &id);
+        glBindTexture(GL_TEXTURE_2D, id);
+
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxValue);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 
-        checkError();
-        glTexImage2D(GL_TEXTURE_2D, 0, f, width, height, 0, f, GL_UNSIGNED_BYTE, source);
+        glTexStorage2D(GL_TEXTURE_2D, static_cast<GLsizei>(count - firstLevel), gl4Texture->format, width, height);
 
-        checkError();
-        glGenerateMipmap(GL_TEXTURE_2D);
+        for (GLsizei level = first; level < static_cast<GLsizei>(count); level++)
+        {
+            GLsizei levelWidth = gl4Texture->width >> level ? gl4Texture->width >> level : 1;
+            GLsizei levelHeight = gl4Texture->height >> level ? gl4Texture->height >> level : 1;
+
+            if (level >= gl4Texture->firstLevel)
+            {
+                glCopyImageSubData(gl4Texture->id, GL_TEXTURE_2D, level - gl4Texture->firstLevel, 0, 0, 0,
+                    id, GL_TEXTURE_2D, level - first, 0, 0, 0, levelWidth, levelHeight, 1);
+            }
+            else if (compressed)
+            {
+                SGE_ASSERT(levels[level] != nullptr);
+                glCompressedTexSubImage2D(GL_TEXTURE_2D, level - first, 0, 0, levelWidth, levelHeight, gl4Texture->format, static_cast<GLsizei>(sizes[level]), levels[level]);
+            }
+            else
+            {
+                SGE_ASSERT(levels[level] != nullptr);
+                glTexSubImage2D(GL_TEXTURE_2D, level - first, 0, 0, levelWidth, levelHeight, GL_RGBA, GL_UNSIGNED_BYTE, levels[level]);
+            }
+        }
 
         checkError();
         glBindTexture(GL_TEXTURE_2D, 0);
 
+        glDeleteTextures(1, &gl4Texture->id);
+
         checkError();
 
-        return &gl4Texture->header;
+        gl4Texture->id = id;
+        gl4Texture->levels = static_cast<GLint>(count);
+        gl4Texture->firstLevel = first;
     }
 
-    Texture* GraphicsDevice::createTextTexture(size_t width, size_t height, unsigned char* source)
+    Texture* GraphicsDevice::createTextureArray(size_t width, size_t height, size_t layers, size_t levels, Format format)
     {
-        GL4Texture* gl4Texture = new GL4Texture();
+        GLenum compressedFormat = getCompressedFormat(format);
 
-        glGenTextures(1, &gl4Texture->id);
-        checkError();
+        SGE_ASSERT(layers > 0 && levels > 0 && (format == Format::RGBA || compressedFormat != 0));
 
-        glBindTexture(GL_TEXTURE_2D, gl4Texture->id);
-        checkError();
+        GL4Texture* gl4Texture = new GL4Texture();
+        gl4Texture->target = GL_TEXTURE_2D_ARRAY;
+        gl4Texture->layers = static_cast<GLsizei>(layers);
+        gl4Texture->width = static_cast<GLsizei>(width);
+        gl4Texture->height = static_cast<GLsizei>(height);
+        gl4Texture->format = compressedFormat ? compressedFormat : GL_RGBA8;
+        gl4Texture->levels = static_cast<GLint>(levels);
+        gl4Texture->firstLevel = 0;
+        gl4Texture->resident = true;
 
-        float maxValue;
-        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxValue);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxValue);
+        gl4Texture->id = createArrayStorage(gl4Texture);
 
-        checkError();
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        return &gl4Texture->header;
+    }
 
-        checkError();
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, source);
+    void GraphicsDevice::setTextureLayers(Texture* texture, size_t layers)
+    {
+        GL4Texture* gl4Texture = reinterpret_cast<GL4Texture*>(texture);
 
-        checkError();
-        glGenerateMipmap(GL_TEXTURE_2D);
+        SGE_ASSERT(gl4Texture->target == GL_TEXTURE_2D_ARRAY && layers >= static_cast<size_t>(gl4Texture->layers));
 
-        checkError();
-        glBindTexture(GL_TEXTURE_2D, 0);
+        GLuint previous = gl4Texture->id;
+        GLsizei previousLayers = gl4Texture->layers;
 
-        checkError();
+        gl4Texture->layers = static_cast<GLsizei>(layers);
+        gl4Texture->id = createArrayStorage(gl4Texture);
 
-        return &gl4Texture->header;
-    }
+        // Like the levels of a 2D texture, the layers of immutable storage are fixed, so the old ones are copied over.
+        for (GLint level = 0; level < gl4Texture->levels; level++)
+        {
+            GLsizei levelWidth = gl4Texture->width >> level ? gl4Texture->width >> level : 1;
+            GLsizei levelHeight = gl4Texture->height >> level ? gl4Texture->height >> level : 1;
 
-    Texture* GraphicsDevice::createTexture(TextureResource* source)
-    {
-        return createTexture(source->getSize().x, source->getSize().y, source->getData(), Format::RGBA);
-    }
+            glCopyImageSubData(previous, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+                gl4Texture->id, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, levelWidth, levelHeight, previousLayers);
+        }
 
-    Texture* GraphicsDevice::createTextTexture(TextureResource* source)
-    {
-        return createTextTexture(source->getSize().x, source->getSize().y, source->getData());
+        glDeleteTextures(1, &previous);
+
+        checkError();
     }
 
-    void GraphicsDevice::deleteTexture(Texture* texture)
+    void GraphicsDevice::copyTextureLayer(Texture* texture, size_t layer, const unsigned char* const levels[], const size_t sizes[])
     {
         GL4Texture* gl4Texture = reinterpret_cast<GL4Texture*>(texture);
-        glDeleteTextures(1, &gl4Texture->id);
 
-        checkError();
+        SGE_ASSERT(gl4Texture->target == GL_TEXTURE_2D_ARRAY && layer < static_cast<size_t>(gl4Texture->layers));
 
-        delete gl4Texture;
-        texture = nullptr;
+        glBindTexture(GL_TEXTURE_2D_ARRAY, gl4Texture->id);
+
+        for (GLint level = 0; level < gl4Texture->levels; level++)
+        {
+            GLsizei levelWidth = gl4Texture->width >> level ? gl4Texture->width >> level : 1;
+            GLsizei levelHeight = gl4Texture->height >> level ? gl4Texture->height >> level : 1;
+
+            if (gl4Texture->format != GL_RGBA8)
+            {
+                glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, static_cast<GLint>(layer), levelWidth, levelHeight, 1,
+                    gl4Texture->format, static_cast<GLsizei>(sizes[level]), levels[level]);
+            }
+            else
+            {
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, static_cast<GLint>(layer), levelWidth, levelHeight, 1,
+                    GL_RGBA, GL_UNSIGNED_BYTE, levels[level]);
+            }
+        }
+
+        checkError();
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
     }
 
     CubeMap* GraphicsDevice::createCubeMap(TextureResource* source[])
@@ -450,6 +1591,18 @@ namespace sge
 
 		for (size_t i = 0; i < 6; i++)
 		{
+			GLenum compressedFormat = getCompressedFormat(source[i]->getPixelFormat());
+
+			// Cube maps sample only the first level, the rest of a cooked chain is skipped.
+			if (compressedFormat)
+			{
+				glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+					0, compressedFormat, source[i]->getSize().x, source[i]->getSize().y, 0, static_cast<GLsizei>(source[i]->getLevelSize(0)), source[i]->getData()
+				);
+
+				continue;
+			}
+
             glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
                 0, GL_RGBA, source[i]->getSize().x, source[i]->getSize().y, 0, GL_RGBA, GL_UNSIGNED_BYTE, source[i]->getData()
 			);
@@ -482,6 +1635,34 @@ namespace sge
 		glUseProgram(gl4Pipeline->program);
 		glBindVertexArray(gl4Pipeline->vao);
 
+		const PipelineState& state = pipeline->state;
+
+		if (state.blendMode != impl->blendMode)
+		{
+			switch (state.blendMode)
+			{
+			case BlendMode::NONE: glDisable(GL_BLEND); break;
+			case BlendMode::ALPHA: glEnable(GL_BLEND); glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); break;
+			case BlendMode::ADDITIVE: glEnable(GL_BLEND); glBlendFunc(GL_ONE, GL_ONE); break;
+			}
+
+			impl->blendMode = state.blendMode;
+		}
+
+		if (state.cullMode != impl->cullMode)
+		{
+			switch (state.cullMode)
+			{
+			case CullMode::NONE: glDisable(GL_CULL_FACE); break;
+			case CullMode::BACK: glEnable(GL_CULL_FACE); glCullFace(GL_BACK); break;
+			case CullMode::FRONT: glEnable(GL_CULL_FACE); glCullFace(GL_FRONT); break;
+			}
+
+			impl->cullMode = state.cullMode;
+		}
+
+		setDepthState(state.depthFunction, state.depthWrite);
+
 		checkError();
 
 		impl->pipeline = gl4Pipeline;
@@ -522,20 +1703,7 @@ namespace sge
 	{
 		SGE_ASSERT(impl->pipeline);
 
-		bindBuffer(buffer);
-
-		for (size_t i = 0; i < impl->pipeline->vertexLayout.count; i++)
-		{
-			glEnableVertexAttribArray(i);
-
-			glVertexAttribPointer(
-				i, 
-				impl->pipeline->vertexLayout.elements[i].size, 
-				GL_FLOAT, 
-				GL_FALSE, 
-				impl->pipeline->vertexLayout.stride * sizeof(GLfloat), 
-				(void*)(impl->pipeline->vertexLayout.elements[i].offset * sizeof(GLfloat)));
-		}
+		glBindVertexBuffer(0, reinterpret_cast<GL4Buffer*>(buffer)->id, 0, impl->pipeline->vertexLayout.stride);
 
 		checkError();
 	}
@@ -544,6 +1712,15 @@ namespace sge
 	{
 		SGE_ASSERT(impl->pipeline);
 
+		if (impl->directStateAccess)
+		{
+			impl->dsa.vertexArrayElementBuffer(impl->pipeline->vao, reinterpret_cast<GL4Buffer*>(buffer)->id);
+
+			checkError();
+
+			return;
+		}
+
 		bindBuffer(buffer);
 	}
 
@@ -565,6 +1742,20 @@ namespace sge
 		checkError();
 	}
 
+	void GraphicsDevice::bindStorageBuffer(Buffer* buffer, size_t slot)
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, slot, reinterpret_cast<GL4Buffer*>(buffer)->id);
+
+		checkError();
+	}
+
+	void GraphicsDevice::bindIndirectBuffer(Buffer* buffer)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, reinterpret_cast<GL4Buffer*>(buffer)->id);
+
+		checkError();
+	}
+
 	void GraphicsDevice::bindViewport(Viewport* viewport)
 	{
 		glViewport(viewport->x, viewport->y, viewport->width, viewport->height);
@@ -572,10 +1763,46 @@ namespace sge
 		checkError();
 	}
 
+	void GraphicsDevice::setDepthState(DepthFunction function, bool write)
+	{
+		GLenum glFunction = getDepthFunction(function);
+
+		if (glFunction != impl->depthFunction)
+		{
+			glDepthFunc(glFunction);
+			impl->depthFunction = glFunction;
+		}
+
+		GLboolean glWrite = write ? GL_TRUE : GL_FALSE;
+
+		if (glWrite != impl->depthWrite)
+		{
+			glDepthMask(glWrite);
+			impl->depthWrite = glWrite;
+		}
+
+		checkError();
+	}
+
+	void GraphicsDevice::setColorWrite(bool enabled)
+	{
+		GLboolean glEnabled = enabled ? GL_TRUE : GL_FALSE;
+
+		if (glEnabled != impl->colorWrite)
+		{
+			glColorMask(glEnabled, glEnabled, glEnabled, glEnabled);
+			impl->colorWrite = glEnabled;
+		}
+
+		checkError();
+	}
+
 	void GraphicsDevice::bindTexture(Texture* texture, size_t slot)
 	{
+		GL4Texture* gl4Texture = reinterpret_cast<GL4Texture*>(texture);
+
 		glActiveTexture(GL_TEXTURE0 + slot);
-		glBindTexture(GL_TEXTURE_2D, reinterpret_cast<GL4Texture*>(texture)->id);
+		glBindTexture(gl4Texture->target, gl4Texture->id);
 
 		checkError();
 	}
@@ -583,7 +1810,7 @@ namespace sge
 	void GraphicsDevice::debindTexture(Texture* texture, size_t slot)
 	{
         glActiveTexture(GL_TEXTURE0 + slot);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindTexture(reinterpret_cast<GL4Texture*>(texture)->target, 0);
 
 		checkError();
 	}
@@ -607,7 +1834,25 @@ namespace sge
 	void GraphicsDevice::copyData(Buffer* buffer, size_t size, const void* data)
 	{
 		GL4Buffer* gl4Buffer = reinterpret_cast<GL4Buffer*>(buffer);
-		glBufferData(gl4Buffer->target, size, data, gl4Buffer->usage);
+
+		if (!impl->directStateAccess)
+		{
+			// The copy target leaves the element array binding of the current VAO alone.
+			glBindBuffer(GL_COPY_WRITE_BUFFER, gl4Buffer->id);
+			glBufferData(GL_COPY_WRITE_BUFFER, size, data, gl4Buffer->usage);
+		}
+		else if (gl4Buffer->usage == GL_STATIC_DRAW)
+		{
+			// Immutable storage is allocated once, static buffers are filled when they are created.
+			SGE_ASSERT(gl4Buffer->header.size == 0);
+
+			impl->dsa.namedBufferStorage(gl4Buffer->id, size, data, 0);
+		}
+		else
+		{
+			impl->dsa.namedBufferData(gl4Buffer->id, size, data, gl4Buffer->usage);
+		}
+
 		gl4Buffer->header.size = size;
 		checkError();
 	}
@@ -615,35 +1860,156 @@ namespace sge
 	void GraphicsDevice::copySubData(Buffer* buffer, size_t offset, size_t size, const void* data)
 	{
 		GL4Buffer* gl4Buffer = reinterpret_cast<GL4Buffer*>(buffer);
-		glBufferSubData(gl4Buffer->target, offset, size, data);
+
+		if (impl->directStateAccess)
+		{
+			SGE_ASSERT(gl4Buffer->usage != GL_STATIC_DRAW);
+
+			impl->dsa.namedBufferSubData(gl4Buffer->id, offset, size, data);
+		}
+		else
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, gl4Buffer->id);
+			glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+		}
+
+		checkError();
+	}
+
+	void GraphicsDevice::copyBufferData(Buffer* source, size_t sourceOffset, Buffer* destination, size_t destinationOffset, size_t size)
+	{
+		SGE_ASSERT(sourceOffset + size <= source->size && destinationOffset + size <= destination->size);
+
+		glBindBuffer(GL_COPY_READ_BUFFER, reinterpret_cast<GL4Buffer*>(source)->id);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, reinterpret_cast<GL4Buffer*>(destination)->id);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, destinationOffset, size);
+
+		checkError();
+	}
+
+	Query* GraphicsDevice::createQuery(QueryType type)
+	{
+		GL4Query* gl4Query = new GL4Query();
+
+		gl4Query->header.type = type;
+
+		switch (type)
+		{
+		case QueryType::SAMPLES_PASSED: gl4Query->target = GL_SAMPLES_PASSED; break;
+		case QueryType::ANY_SAMPLES_PASSED: gl4Query->target = GL_ANY_SAMPLES_PASSED_CONSERVATIVE; break;
+		}
+
+		glGenQueries(1, &gl4Query->id);
+
+		checkError();
+
+		return &gl4Query->header;
+	}
+
+	void GraphicsDevice::deleteQuery(Query* query)
+	{
+		GL4Query* gl4Query = reinterpret_cast<GL4Query*>(query);
+
+		glDeleteQueries(1, &gl4Query->id);
+
+		checkError();
+
+		delete gl4Query;
+		query = nullptr;
+	}
+
+	void GraphicsDevice::beginQuery(Query* query)
+	{
+		GL4Query* gl4Query = reinterpret_cast<GL4Query*>(query);
+
+		glBeginQuery(gl4Query->target, gl4Query->id);
+
+		checkError();
+	}
+
+	void GraphicsDevice::endQuery(Query* query)
+	{
+		GL4Query* gl4Query = reinterpret_cast<GL4Query*>(query);
+
+		glEndQuery(gl4Query->target);
+
+		checkError();
+	}
+
+	bool GraphicsDevice::getQueryResult(Query* query, uint64& result, bool wait)
+	{
+		GL4Query* gl4Query = reinterpret_cast<GL4Query*>(query);
+
+		if (!wait)
+		{
+			GLuint available = GL_FALSE;
+			glGetQueryObjectuiv(gl4Query->id, GL_QUERY_RESULT_AVAILABLE, &available);
+
+			if (available == GL_FALSE)
+			{
+				checkError();
+
+				return false;
+			}
+		}
+
+		GLuint64 value = 0;
+		glGetQueryObjectui64v(gl4Query->id, GL_QUERY_RESULT, &value);
+		result = value;
 
 		checkError();
+
+		return true;
 	}
 
 	void GraphicsDevice::draw(size_t count)
 	{
-		glDrawArrays(GL_TRIANGLES, 0, count);
+		glDrawArrays(impl->pipeline->mode, 0, count);
 
 		checkError();
 	}
 
 	void GraphicsDevice::drawIndexed(size_t count)
 	{
-		glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, nullptr);
+		glDrawElements(impl->pipeline->mode, count, GL_UNSIGNED_INT, nullptr);
 
 		checkError();
 	}
 
 	void GraphicsDevice::drawInstanced(size_t count, size_t instanceCount)
 	{
-		glDrawArraysInstanced(GL_TRIANGLES, 0, count, instanceCount);
+		glDrawArraysInstanced(impl->pipeline->mode, 0, count, instanceCount);
 
 		checkError();
 	}
 
 	void GraphicsDevice::drawInstancedIndexed(size_t count, size_t instanceCount)
 	{
-		glDrawElementsInstanced(GL_TRIANGLES, count, GL_UNSIGNED_INT, nullptr, instanceCount);
+		glDrawElementsInstanced(impl->pipeline->mode, count, GL_UNSIGNED_INT, nullptr, instanceCount);
+
+		checkError();
+	}
+
+	void GraphicsDevice::drawIndirect(size_t drawCount, size_t offset)
+	{
+		glMultiDrawArraysIndirect(impl->pipeline->mode, reinterpret_cast<const void*>(offset), drawCount, 0);
+
+		checkError();
+	}
+
+	void GraphicsDevice::drawIndexedIndirect(size_t drawCount, size_t offset)
+	{
+		glMultiDrawElementsIndirect(impl->pipeline->mode, GL_UNSIGNED_INT, reinterpret_cast<const void*>(offset), drawCount, 0);
+
+		checkError();
+	}
+
+	void GraphicsDevice::dispatch(size_t x, size_t y, size_t z)
+	{
+		glDispatchCompute(x, y, z);
+
+		// The results usually feed draws right away, as storage, vertices or indirect arguments.
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
 
 		checkError();
 	}
@@ -0,0 +1,145 @@
+#ifdef HEADLESS
+
+#include "Renderer/Headless/CommandLog.h"
+
+namespace sge
+{
+	CommandStats::CommandStats() :
+		drawCalls(0), stateChanges(0), bytesUploaded(0), vertices(0)
+	{
+		for (auto& count : counts)
+		{
+			count = 0;
+		}
+	}
+
+	void CommandStats::add(const CommandStats& other)
+	{
+		for (size_t i = 0; i < static_cast<size_t>(Command::COUNT); i++)
+		{
+			counts[i] += other.counts[i];
+		}
+
+		drawCalls += other.drawCalls;
+		stateChanges += other.stateChanges;
+		bytesUploaded += other.bytesUploaded;
+		vertices += other.vertices;
+	}
+
+	CommandLog::CommandLog() :
+		frameCount(0)
+	{
+	}
+
+	void CommandLog::record(Command command, uint64 argument)
+	{
+		entries.push_back({ command, argument });
+		stats.counts[static_cast<size_t>(command)]++;
+	}
+
+	void CommandLog::recordUpload(Command command, uint64 bytes)
+	{
+		record(command, bytes);
+		stats.bytesUploaded += bytes;
+	}
+
+	void CommandLog::recordDraw(Command command, uint64 vertices)
+	{
+		record(command, vertices);
+		stats.drawCalls++;
+		stats.vertices += vertices;
+	}
+
+	void CommandLog::recordStateChange()
+	{
+		stats.stateChanges++;
+	}
+
+	void CommandLog::endFrame()
+	{
+		frameEntries.swap(entries);
+		entries.clear();
+
+		frameStats = stats;
+		totalStats.add(stats);
+		stats = CommandStats();
+
+		frameCount++;
+	}
+
+	void CommandLog::print(std::ostream& stream) const
+	{
+		double frames = frameCount ? static_cast<double>(frameCount) : 1.0;
+
+		stream << "Frames: " << frameCount << std::endl;
+		stream << "Draw calls per frame: " << totalStats.drawCalls / frames << std::endl;
+		stream << "Vertices per frame: " << totalStats.vertices / frames << std::endl;
+		stream << "State changes per frame: " << totalStats.stateChanges / frames << std::endl;
+		stream << "Bytes uploaded per frame: " << totalStats.bytesUploaded / frames << std::endl;
+
+		for (size_t i = 0; i < static_cast<size_t>(Command::COUNT); i++)
+		{
+			if (totalStats.counts[i])
+			{
+				stream << "  " << getName(static_cast<Command>(i)) << ": " << totalStats.counts[i] / frames << std::endl;
+			}
+		}
+	}
+
+	const char* CommandLog::getName(Command command)
+	{
+		switch (command)
+		{
+		case Command::CLEAR: return "clear";
+		case Command::SWAP: return "swap";
+		case Command::CREATE_BUFFER: return "createBuffer";
+		case Command::DELETE_BUFFER: return "deleteBuffer";
+		case Command::CREATE_PIPELINE: return "createPipeline";
+		case Command::DELETE_PIPELINE: return "deletePipeline";
+		case Command::CREATE_RENDER_TARGET: return "createRenderTarget";
+		case Command::DELETE_RENDER_TARGET: return "deleteRenderTarget";
+		case Command::CREATE_SHADER: return "createShader";
+		case Command::DELETE_SHADER: return "deleteShader";
+		case Command::CREATE_TEXTURE: return "createTexture";
+		case Command::DELETE_TEXTURE: return "deleteTexture";
+		case Command::CREATE_CUBE_MAP: return "createCubeMap";
+		case Command::DELETE_CUBE_MAP: return "deleteCubeMap";
+		case Command::CREATE_QUERY: return "createQuery";
+		case Command::DELETE_QUERY: return "deleteQuery";
+		case Command::BIND_PIPELINE: return "bindPipeline";
+		case Command::DEBIND_PIPELINE: return "debindPipeline";
+		case Command::BIND_RENDER_TARGET: return "bindRenderTarget";
+		case Command::DEBIND_RENDER_TARGET: return "debindRenderTarget";
+		case Command::BIND_VERTEX_BUFFER: return "bindVertexBuffer";
+		case Command::BIND_INDEX_BUFFER: return "bindIndexBuffer";
+		case Command::BIND_VERTEX_UNIFORM_BUFFER: return "bindVertexUniformBuffer";
+		case Command::BIND_PIXEL_UNIFORM_BUFFER: return "bindPixelUniformBuffer";
+		case Command::BIND_STORAGE_BUFFER: return "bindStorageBuffer";
+		case Command::BIND_INDIRECT_BUFFER: return "bindIndirectBuffer";
+		case Command::BIND_VIEWPORT: return "bindViewport";
+		case Command::SET_DEPTH_STATE: return "setDepthState";
+		case Command::SET_COLOR_WRITE: return "setColorWrite";
+		case Command::BIND_TEXTURE: return "bindTexture";
+		case Command::DEBIND_TEXTURE: return "debindTexture";
+		case Command::BIND_CUBE_MAP: return "bindCubeMap";
+		case Command::DEBIND_CUBE_MAP: return "debindCubeMap";
+		case Command::COPY_DATA: return "copyData";
+		case Command::COPY_SUB_DATA: return "copySubData";
+		case Command::COPY_BUFFER_DATA: return "copyBufferData";
+		case Command::COPY_TEXTURE: return "copyTexture";
+		case Command::BEGIN_QUERY: return "beginQuery";
+		case Command::END_QUERY: return "endQuery";
+		case Command::GET_QUERY_RESULT: return "getQueryResult";
+		case Command::DRAW: return "draw";
+		case Command::DRAW_INDEXED: return "drawIndexed";
+		case Command::DRAW_INSTANCED: return "drawInstanced";
+		case Command::DRAW_INSTANCED_INDEXED: return "drawInstancedIndexed";
+		case Command::DRAW_INDIRECT: return "drawIndirect";
+		case Command::DRAW_INDEXED_INDIRECT: return "drawIndexedIndirect";
+		case Command::DISPATCH: return "dispatch";
+		default: return "unknown";
+		}
+	}
+}
+
+#endif
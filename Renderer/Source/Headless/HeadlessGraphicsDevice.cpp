@@ -0,0 +1,774 @@
+#ifdef HEADLESS
+
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Renderer/GraphicsDevice.h"
+#include "Renderer/Buffer.h"
+#include "Renderer/CubeMap.h"
+#include "Renderer/IndirectCommand.h"
+#include "Renderer/Pipeline.h"
+#include "Renderer/Query.h"
+#include "Renderer/RenderTarget.h"
+#include "Renderer/Shader.h"
+#include "Renderer/Texture.h"
+#include "Renderer/Viewport.h"
+#include "Renderer/Window.h"
+#include "Renderer/Headless/CommandLog.h"
+
+#include "Resources/TextureResource.h"
+
+#include "Core/Assert.h"
+
+namespace sge
+{
+	namespace
+	{
+		// Same limit as the staging memory of the GL4 device.
+		const size_t STAGING_SIZE = 64 * 1024 * 1024;
+
+		struct TextureUpload
+		{
+			Texture* texture;
+			std::vector<uint8> pixels;
+			uint32 ticket;
+			bool staged;
+		};
+
+		size_t getPixelSize(Format format)
+		{
+			switch (format)
+			{
+			case Format::RGB: return 3;
+			case Format::RGBA: return 4;
+			case Format::R32F: return 4;
+			case Format::RGBA16F: return 8;
+			default: return 4;
+			}
+		}
+	}
+
+	// Does no GPU work, every call is only validated and recorded. The resources are the
+	// plain headers of the interface, so nothing but their bookkeeping is allocated.
+	struct GraphicsDevice::Impl
+	{
+		Impl() :
+			pipeline(nullptr), renderTarget(nullptr), vertexBuffer(nullptr), indexBuffer(nullptr), indirectBuffer(nullptr),
+			blendMode(BlendMode::NONE), cullMode(CullMode::BACK), depthFunction(DepthFunction::LESS), depthWrite(true), colorWrite(true),
+			stagingUsed(0), nextTicket(0)
+		{
+			viewport = { 0, 0, 0, 0 };
+		}
+
+		// Counts a state change when the value differs from the current one.
+		template<typename T>
+		void change(T& current, const T& value)
+		{
+			if (current != value)
+			{
+				current = value;
+				log.recordStateChange();
+			}
+		}
+
+		template<typename T>
+		void changeSlot(std::vector<T>& slots, size_t slot, const T& value)
+		{
+			if (slot >= slots.size())
+			{
+				slots.resize(slot + 1, nullptr);
+			}
+
+			change(slots[slot], value);
+		}
+
+		CommandLog log;
+
+		Pipeline* pipeline;
+		RenderTarget* renderTarget;
+		Buffer* vertexBuffer;
+		Buffer* indexBuffer;
+		Buffer* indirectBuffer;
+		std::vector<Buffer*> uniformBuffers;
+		std::vector<Buffer*> storageBuffers;
+		std::vector<const void*> textures;
+		Viewport viewport;
+		BlendMode blendMode;
+		CullMode cullMode;
+		DepthFunction depthFunction;
+		bool depthWrite;
+		bool colorWrite;
+
+		// Contents of the indirect buffers, so the vertices of indirect draws can be counted.
+		std::unordered_map<const Buffer*, std::vector<uint8>> indirectData;
+
+		// Streamed textures, staged in memory of their own and dropped once copied.
+		std::deque<TextureUpload> uploads;
+		size_t stagingUsed;
+		uint32 nextTicket;
+		std::mutex stagingMutex;
+	};
+
+	GraphicsDevice::GraphicsDevice(Window& /*window*/) :
+		impl(new Impl())
+	{
+	}
+
+	GraphicsDevice::~GraphicsDevice()
+	{
+		delete impl;
+	}
+
+	void GraphicsDevice::init()
+	{
+		std::cout << "Using the headless graphics device" << std::endl;
+	}
+
+	void GraphicsDevice::deinit()
+	{
+	}
+
+	// Nothing is linked headless, so there are no program binaries to cache.
+	void GraphicsDevice::setProgramCache(const char* /*directory*/)
+	{
+	}
+
+	const CommandLog& GraphicsDevice::getCommandLog() const
+	{
+		return impl->log;
+	}
+
+	void GraphicsDevice::swap()
+	{
+		impl->log.record(Command::SWAP);
+		impl->log.endFrame();
+	}
+
+	void GraphicsDevice::bindContext()
+	{
+	}
+
+	void GraphicsDevice::unbindContext()
+	{
+	}
+
+	void GraphicsDevice::clear(float /*r*/, float /*g*/, float /*b*/, float /*a*/)
+	{
+		impl->log.record(Command::CLEAR);
+	}
+
+	Buffer* GraphicsDevice::createBuffer(BufferType type, BufferUsage /*usage*/, size_t size)
+	{
+		impl->log.record(Command::CREATE_BUFFER, size);
+
+		Buffer* buffer = new Buffer();
+		buffer->size = 0;
+
+		if (type == BufferType::INDIRECT)
+		{
+			impl->indirectData[buffer];
+		}
+
+		return buffer;
+	}
+
+	void GraphicsDevice::deleteBuffer(Buffer* buffer)
+	{
+		impl->log.record(Command::DELETE_BUFFER);
+		impl->indirectData.erase(buffer);
+
+		delete buffer;
+	}
+
+	Pipeline* GraphicsDevice::createPipeline(VertexLayoutDescription* vertexLayoutDescription, Shader* vertexShader, Shader* pixelShader, const PipelineState& state)
+	{
+		SGE_ASSERT(vertexLayoutDescription && vertexShader && pixelShader);
+
+		impl->log.record(Command::CREATE_PIPELINE);
+
+		Pipeline* pipeline = new Pipeline();
+		pipeline->state = state;
+
+		return pipeline;
+	}
+
+	Pipeline* GraphicsDevice::createPipelineVariant(Pipeline* pipeline, size_t count, const char* const defines[])
+	{
+		SGE_ASSERT(pipeline && (count == 0 || defines));
+
+		impl->log.record(Command::CREATE_PIPELINE);
+
+		Pipeline* variant = new Pipeline();
+		variant->state = pipeline->state;
+
+		return variant;
+	}
+
+	Pipeline* GraphicsDevice::createComputePipeline(Shader* computeShader)
+	{
+		SGE_ASSERT(computeShader && computeShader->type == ShaderType::COMPUTE);
+
+		impl->log.record(Command::CREATE_PIPELINE);
+
+		return new Pipeline();
+	}
+
+	void GraphicsDevice::deletePipeline(Pipeline* pipeline)
+	{
+		impl->log.record(Command::DELETE_PIPELINE);
+
+		delete pipeline;
+	}
+
+	RenderTarget* GraphicsDevice::createRenderTarget(size_t count, size_t width, size_t height, bool depth, bool stencil)
+	{
+		std::vector<Format> formats(count, Format::RGB);
+
+		return createRenderTarget(count, formats.data(), width, height, depth, stencil);
+	}
+
+	RenderTarget* GraphicsDevice::createRenderTarget(size_t count, const Format /*formats*/[], size_t /*width*/, size_t /*height*/, bool /*depth*/, bool /*stencil*/)
+	{
+		impl->log.record(Command::CREATE_RENDER_TARGET, count);
+
+		RenderTarget* renderTarget = new RenderTarget();
+
+		renderTarget->count = count;
+		renderTarget->textures = new Texture*[count];
+
+		for (size_t i = 0; i < count; i++)
+		{
+			renderTarget->textures[i] = new Texture();
+		}
+
+		return renderTarget;
+	}
+
+	void GraphicsDevice::deleteRenderTarget(RenderTarget* renderTarget)
+	{
+		impl->log.record(Command::DELETE_RENDER_TARGET);
+
+		for (size_t i = 0; i < renderTarget->count; i++)
+		{
+			delete renderTarget->textures[i];
+		}
+
+		delete[] renderTarget->textures;
+		delete renderTarget;
+	}
+
+	Shader* GraphicsDevice::createShader(ShaderType type, const char* /*source*/, size_t size)
+	{
+		impl->log.record(Command::CREATE_SHADER, size);
+
+		Shader* shader = new Shader();
+		shader->type = type;
+
+		return shader;
+	}
+
+	void GraphicsDevice::deleteShader(Shader* shader)
+	{
+		impl->log.record(Command::DELETE_SHADER);
+
+		delete shader;
+	}
+
+	Texture* GraphicsDevice::createTexture(size_t width, size_t height, unsigned char* source, Format format)
+	{
+		impl->log.recordUpload(Command::CREATE_TEXTURE, source ? width * height * getPixelSize(format) : 0);
+
+		return new Texture();
+	}
+
+	Texture* GraphicsDevice::createTextTexture(size_t width, size_t height, unsigned char* source)
+	{
+		impl->log.recordUpload(Command::CREATE_TEXTURE, source ? width * height : 0);
+
+		return new Texture();
+	}
+
+	Texture* GraphicsDevice::createTexture(size_t /*width*/, size_t /*height*/, size_t count, const unsigned char* const /*levels*/[], const size_t sizes[], Format /*format*/)
+	{
+		SGE_ASSERT(count > 0);
+
+		size_t bytes = 0;
+
+		for (size_t level = 0; level < count; level++)
+		{
+			bytes += sizes[level];
+		}
+
+		impl->log.recordUpload(Command::CREATE_TEXTURE, bytes);
+
+		return new Texture();
+	}
+
+	Texture* GraphicsDevice::createTexture(TextureResource* source)
+	{
+		if (source->isCooked())
+		{
+			std::vector<const unsigned char*> levels;
+			std::vector<size_t> sizes;
+
+			for (size_t level = 0; level < source->getLevels(); level++)
+			{
+				levels.push_back(source->getLevelData(level));
+				sizes.push_back(source->getLevelSize(level));
+			}
+
+			return createTexture(source->getSize().x, source->getSize().y, levels.size(), levels.data(), sizes.data(), source->getPixelFormat());
+		}
+
+		return createTexture(source->getSize().x, source->getSize().y, source->getData(), Format::RGBA);
+	}
+
+	Texture* GraphicsDevice::createTextTexture(TextureResource* source)
+	{
+		return createTextTexture(source->getSize().x, source->getSize().y, source->getData());
+	}
+
+	Texture* GraphicsDevice::createStreamedTexture(size_t width, size_t height, uint32 /*placeholder*/)
+	{
+		SGE_ASSERT(width * height * 4 <= STAGING_SIZE);
+
+		impl->log.record(Command::CREATE_TEXTURE);
+
+		return new Texture();
+	}
+
+	size_t GraphicsDevice::getStagingSize() const
+	{
+		return STAGING_SIZE;
+	}
+
+	void* GraphicsDevice::beginTextureUpload(Texture* texture, size_t size, uint32& ticket)
+	{
+		std::lock_guard<std::mutex> lock(impl->stagingMutex);
+
+		if (impl->stagingUsed + size > STAGING_SIZE)
+		{
+			return nullptr;
+		}
+
+		impl->stagingUsed += size;
+		ticket = impl->nextTicket++;
+		impl->uploads.push_back({ texture, std::vector<uint8>(size), ticket, false });
+
+		return impl->uploads.back().pixels.data();
+	}
+
+	void GraphicsDevice::endTextureUpload(uint32 ticket)
+	{
+		std::lock_guard<std::mutex> lock(impl->stagingMutex);
+
+		for (auto& upload : impl->uploads)
+		{
+			if (upload.ticket == ticket)
+			{
+				upload.staged = true;
+
+				return;
+			}
+		}
+
+		SGE_ASSERT(false);
+	}
+
+	void GraphicsDevice::streamTextures(size_t budget)
+	{
+		std::lock_guard<std::mutex> lock(impl->stagingMutex);
+
+		size_t copied = 0;
+
+		while (!impl->uploads.empty() && impl->uploads.front().staged && (copied == 0 || copied + impl->uploads.front().pixels.size() <= budget))
+		{
+			TextureUpload& upload = impl->uploads.front();
+
+			if (upload.texture)
+			{
+				impl->log.recordUpload(Command::COPY_TEXTURE, upload.pixels.size());
+				copied += upload.pixels.size();
+			}
+
+			impl->stagingUsed -= upload.pixels.size();
+			impl->uploads.pop_front();
+		}
+	}
+
+	void GraphicsDevice::deleteTexture(Texture* texture)
+	{
+		impl->log.record(Command::DELETE_TEXTURE);
+
+		{
+			std::lock_guard<std::mutex> lock(impl->stagingMutex);
+
+			for (auto& upload : impl->uploads)
+			{
+				if (upload.texture == texture)
+				{
+					upload.texture = nullptr;
+				}
+			}
+		}
+
+		delete texture;
+	}
+
+	void GraphicsDevice::setTextureLevels(Texture* texture, size_t count, size_t firstLevel, const unsigned char* const levels[], const size_t sizes[])
+	{
+		SGE_ASSERT(texture && firstLevel < count);
+
+		// Only the restored levels are passed in, the ones that stay are copied on the device.
+		size_t bytes = 0;
+
+		for (size_t level = firstLevel; level < count; level++)
+		{
+			if (levels[level])
+			{
+				bytes += sizes[level];
+			}
+		}
+
+		impl->log.recordUpload(Command::COPY_TEXTURE, bytes);
+	}
+
+	Texture* GraphicsDevice::createTextureArray(size_t /*width*/, size_t /*height*/, size_t layers, size_t levels, Format /*format*/)
+	{
+		SGE_ASSERT(layers > 0 && levels > 0);
+
+		impl->log.record(Command::CREATE_TEXTURE);
+
+		return new Texture();
+	}
+
+	void GraphicsDevice::setTextureLayers(Texture* texture, size_t layers)
+	{
+		SGE_ASSERT(texture && layers > 0);
+
+		// The existing layers are copied on the device.
+		impl->log.record(Command::COPY_TEXTURE);
+	}
+
+	void GraphicsDevice::copyTextureLayer(Texture* texture, size_t /*layer*/, const unsigned char* const levels[], const size_t sizes[])
+	{
+		SGE_ASSERT(texture && levels && sizes);
+
+		// Headless textures don't keep their levels, the first one stands for the layer.
+		impl->log.recordUpload(Command::COPY_TEXTURE, sizes[0]);
+	}
+
+	CubeMap* GraphicsDevice::createCubeMap(TextureResource* source[])
+	{
+		uint64 bytes = 0;
+
+		for (size_t i = 0; i < 6; i++)
+		{
+			bytes += source[i]->getLevelSize(0);
+		}
+
+		impl->log.recordUpload(Command::CREATE_CUBE_MAP, bytes);
+
+		return new CubeMap();
+	}
+
+	void GraphicsDevice::deleteCubeMap(CubeMap* cubeMap)
+	{
+		impl->log.record(Command::DELETE_CUBE_MAP);
+
+		delete cubeMap;
+	}
+
+	void GraphicsDevice::bindPipeline(Pipeline* pipeline)
+	{
+		impl->log.record(Command::BIND_PIPELINE);
+		impl->change(impl->pipeline, pipeline);
+
+		// The fixed function state of the pipeline counts like separate changes.
+		impl->change(impl->blendMode, pipeline->state.blendMode);
+		impl->change(impl->cullMode, pipeline->state.cullMode);
+		impl->change(impl->depthFunction, pipeline->state.depthFunction);
+		impl->change(impl->depthWrite, pipeline->state.depthWrite);
+	}
+
+	void GraphicsDevice::debindPipeline(Pipeline* /*pipeline*/)
+	{
+		impl->log.record(Command::DEBIND_PIPELINE);
+		impl->change(impl->pipeline, static_cast<Pipeline*>(nullptr));
+	}
+
+	void GraphicsDevice::bindRenderTarget(RenderTarget* renderTarget)
+	{
+		impl->log.record(Command::BIND_RENDER_TARGET);
+		impl->change(impl->renderTarget, renderTarget);
+	}
+
+	void GraphicsDevice::debindRenderTarget()
+	{
+		impl->log.record(Command::DEBIND_RENDER_TARGET);
+		impl->change(impl->renderTarget, static_cast<RenderTarget*>(nullptr));
+	}
+
+	void GraphicsDevice::bindVertexBuffer(Buffer* buffer)
+	{
+		SGE_ASSERT(impl->pipeline);
+
+		impl->log.record(Command::BIND_VERTEX_BUFFER);
+		impl->change(impl->vertexBuffer, buffer);
+	}
+
+	void GraphicsDevice::bindIndexBuffer(Buffer* buffer)
+	{
+		SGE_ASSERT(impl->pipeline);
+
+		impl->log.record(Command::BIND_INDEX_BUFFER);
+		impl->change(impl->indexBuffer, buffer);
+	}
+
+	void GraphicsDevice::bindVertexUniformBuffer(Buffer* buffer, size_t slot)
+	{
+		SGE_ASSERT(impl->pipeline);
+
+		impl->log.record(Command::BIND_VERTEX_UNIFORM_BUFFER, slot);
+		impl->changeSlot(impl->uniformBuffers, slot, buffer);
+	}
+
+	void GraphicsDevice::bindPixelUniformBuffer(Buffer* buffer, size_t slot)
+	{
+		SGE_ASSERT(impl->pipeline);
+
+		impl->log.record(Command::BIND_PIXEL_UNIFORM_BUFFER, slot);
+		impl->changeSlot(impl->uniformBuffers, slot, buffer);
+	}
+
+	void GraphicsDevice::bindStorageBuffer(Buffer* buffer, size_t slot)
+	{
+		impl->log.record(Command::BIND_STORAGE_BUFFER, slot);
+		impl->changeSlot(impl->storageBuffers, slot, buffer);
+	}
+
+	void GraphicsDevice::bindIndirectBuffer(Buffer* buffer)
+	{
+		SGE_ASSERT(impl->indirectData.count(buffer));
+
+		impl->log.record(Command::BIND_INDIRECT_BUFFER);
+		impl->change(impl->indirectBuffer, buffer);
+	}
+
+	void GraphicsDevice::bindViewport(Viewport* viewport)
+	{
+		impl->log.record(Command::BIND_VIEWPORT);
+
+		Viewport& current = impl->viewport;
+
+		if (current.x != viewport->x || current.y != viewport->y || current.width != viewport->width || current.height != viewport->height)
+		{
+			current = *viewport;
+			impl->log.recordStateChange();
+		}
+	}
+
+	void GraphicsDevice::setDepthState(DepthFunction function, bool write)
+	{
+		impl->log.record(Command::SET_DEPTH_STATE);
+		impl->change(impl->depthFunction, function);
+		impl->change(impl->depthWrite, write);
+	}
+
+	void GraphicsDevice::setColorWrite(bool enabled)
+	{
+		impl->log.record(Command::SET_COLOR_WRITE);
+		impl->change(impl->colorWrite, enabled);
+	}
+
+	void GraphicsDevice::bindTexture(Texture* texture, size_t slot)
+	{
+		impl->log.record(Command::BIND_TEXTURE, slot);
+		impl->changeSlot(impl->textures, slot, static_cast<const void*>(texture));
+	}
+
+	void GraphicsDevice::debindTexture(Texture* /*texture*/, size_t slot)
+	{
+		impl->log.record(Command::DEBIND_TEXTURE, slot);
+		impl->changeSlot(impl->textures, slot, static_cast<const void*>(nullptr));
+	}
+
+	void GraphicsDevice::bindCubeMap(CubeMap* cubeMap, size_t slot)
+	{
+		impl->log.record(Command::BIND_CUBE_MAP, slot);
+		impl->changeSlot(impl->textures, slot, static_cast<const void*>(cubeMap));
+	}
+
+	void GraphicsDevice::debindCubeMap(CubeMap* /*cubeMap*/, size_t slot)
+	{
+		impl->log.record(Command::DEBIND_CUBE_MAP, slot);
+		impl->changeSlot(impl->textures, slot, static_cast<const void*>(nullptr));
+	}
+
+	void GraphicsDevice::copyData(Buffer* buffer, size_t size, const void* data)
+	{
+		impl->log.recordUpload(Command::COPY_DATA, size);
+
+		buffer->size = size;
+
+		auto indirect = impl->indirectData.find(buffer);
+
+		if (indirect != impl->indirectData.end())
+		{
+			indirect->second.assign(size, 0);
+
+			if (data)
+			{
+				std::memcpy(indirect->second.data(), data, size);
+			}
+		}
+	}
+
+	void GraphicsDevice::copySubData(Buffer* buffer, size_t offset, size_t size, const void* data)
+	{
+		SGE_ASSERT(offset + size <= buffer->size);
+
+		impl->log.recordUpload(Command::COPY_SUB_DATA, size);
+
+		auto indirect = impl->indirectData.find(buffer);
+
+		if (indirect != impl->indirectData.end())
+		{
+			std::memcpy(indirect->second.data() + offset, data, size);
+		}
+	}
+
+	void GraphicsDevice::copyBufferData(Buffer* source, size_t sourceOffset, Buffer* destination, size_t destinationOffset, size_t size)
+	{
+		SGE_ASSERT(sourceOffset + size <= source->size && destinationOffset + size <= destination->size);
+
+		impl->log.record(Command::COPY_BUFFER_DATA, size);
+
+		auto indirect = impl->indirectData.find(destination);
+
+		if (indirect != impl->indirectData.end())
+		{
+			auto sourceData = impl->indirectData.find(source);
+			SGE_ASSERT(sourceData != impl->indirectData.end());
+
+			std::memcpy(indirect->second.data() + destinationOffset, sourceData->second.data() + sourceOffset, size);
+		}
+	}
+
+	Query* GraphicsDevice::createQuery(QueryType type)
+	{
+		impl->log.record(Command::CREATE_QUERY);
+
+		Query* query = new Query();
+		query->type = type;
+
+		return query;
+	}
+
+	void GraphicsDevice::deleteQuery(Query* query)
+	{
+		impl->log.record(Command::DELETE_QUERY);
+
+		delete query;
+	}
+
+	void GraphicsDevice::beginQuery(Query* /*query*/)
+	{
+		impl->log.record(Command::BEGIN_QUERY);
+	}
+
+	void GraphicsDevice::endQuery(Query* /*query*/)
+	{
+		impl->log.record(Command::END_QUERY);
+	}
+
+	bool GraphicsDevice::getQueryResult(Query* query, uint64& result, bool /*wait*/)
+	{
+		impl->log.record(Command::GET_QUERY_RESULT);
+
+		// Nothing is rasterized, so everything counts as visible and no samples are shaded.
+		result = query->type == QueryType::ANY_SAMPLES_PASSED ? 1 : 0;
+
+		return true;
+	}
+
+	void GraphicsDevice::draw(size_t count)
+	{
+		SGE_ASSERT(impl->pipeline);
+
+		impl->log.recordDraw(Command::DRAW, count);
+	}
+
+	void GraphicsDevice::drawIndexed(size_t count)
+	{
+		SGE_ASSERT(impl->pipeline && impl->indexBuffer);
+
+		impl->log.recordDraw(Command::DRAW_INDEXED, count);
+	}
+
+	void GraphicsDevice::drawInstanced(size_t count, size_t instanceCount)
+	{
+		SGE_ASSERT(impl->pipeline);
+
+		impl->log.recordDraw(Command::DRAW_INSTANCED, count * instanceCount);
+	}
+
+	void GraphicsDevice::drawInstancedIndexed(size_t count, size_t instanceCount)
+	{
+		SGE_ASSERT(impl->pipeline && impl->indexBuffer);
+
+		impl->log.recordDraw(Command::DRAW_INSTANCED_INDEXED, count * instanceCount);
+	}
+
+	void GraphicsDevice::drawIndirect(size_t drawCount, size_t offset)
+	{
+		SGE_ASSERT(impl->pipeline && impl->indirectBuffer);
+		SGE_ASSERT(offset + drawCount * sizeof(DrawIndirectCommand) <= impl->indirectBuffer->size);
+
+		const uint8* data = impl->indirectData[impl->indirectBuffer].data() + offset;
+		uint64 vertices = 0;
+
+		for (size_t i = 0; i < drawCount; i++)
+		{
+			DrawIndirectCommand command;
+			std::memcpy(&command, data + i * sizeof(DrawIndirectCommand), sizeof(DrawIndirectCommand));
+
+			vertices += static_cast<uint64>(command.count) * command.instanceCount;
+		}
+
+		impl->log.recordDraw(Command::DRAW_INDIRECT, vertices);
+	}
+
+	void GraphicsDevice::drawIndexedIndirect(size_t drawCount, size_t offset)
+	{
+		SGE_ASSERT(impl->pipeline && impl->indexBuffer && impl->indirectBuffer);
+		SGE_ASSERT(offset + drawCount * sizeof(DrawIndexedIndirectCommand) <= impl->indirectBuffer->size);
+
+		const uint8* data = impl->indirectData[impl->indirectBuffer].data() + offset;
+		uint64 vertices = 0;
+
+		for (size_t i = 0; i < drawCount; i++)
+		{
+			DrawIndexedIndirectCommand command;
+			std::memcpy(&command, data + i * sizeof(DrawIndexedIndirectCommand), sizeof(DrawIndexedIndirectCommand));
+
+			vertices += static_cast<uint64>(command.count) * command.instanceCount;
+		}
+
+		impl->log.recordDraw(Command::DRAW_INDEXED_INDIRECT, vertices);
+	}
+
+	void GraphicsDevice::dispatch(size_t x, size_t y, size_t z)
+	{
+		SGE_ASSERT(impl->pipeline);
+
+		// No shader runs here, buffers written by the dispatch keep the contents uploaded to them.
+		impl->log.record(Command::DISPATCH, static_cast<uint64>(x) * y * z);
+	}
+}
+
+#endif
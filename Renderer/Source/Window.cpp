@@ -9,17 +9,29 @@ namespace sge
 		width(width),
 		height(height)
 	{
+#if defined(HEADLESS)
+		// Nothing is shown, so the window only keeps its size.
+		(void)title;
+		(void)x;
+		(void)y;
+
+		window = nullptr;
+#else
 		Uint32 flags = SDL_WINDOW_SHOWN;
 
 #if defined(OPENGL4)
 		flags |= SDL_WINDOW_OPENGL;
 #endif
 		window = SDL_CreateWindow(title, x, y, width, height, flags);
+#endif
 	}
 
 	Window::~Window()
 	{
-		SDL_DestroyWindow(window);
+		if (window)
+		{
+			SDL_DestroyWindow(window);
+		}
 	}
 
 	SDL_Window* Window::getSDLWindow()
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Renderer/Enumerations.h"
+
+namespace sge
+{
+	/** \brief Size in bytes of an image in the given format, compressed formats round the size up to whole 4x4 blocks.*/
+	size_t getImageSize(Format format, size_t width, size_t height);
+
+	/** \brief Compresses an RGBA8 image into BC1, BC3 or BC5 blocks.
+	*
+	*	BC1 keeps the color, BC3 adds the alpha channel and BC5 keeps the red and green channels of normal maps.
+	*	Edge blocks of images that aren't a multiple of four repeat the last row and column.
+	*
+	*	\param const unsigned char* source : The RGBA8 pixels.
+	*	\param unsigned char* destination : Memory for getImageSize(format, width, height) bytes.
+	*/
+	void compressImage(Format format, const unsigned char* source, size_t width, size_t height, unsigned char* destination);
+
+	/** \brief Halves an RGBA8 image with a box filter, odd sizes repeat the last row and column.
+	*
+	*	\param unsigned char* destination : Memory for the max(width / 2, 1) x max(height / 2, 1) image.
+	*/
+	void downsampleImage(const unsigned char* source, size_t width, size_t height, unsigned char* destination);
+
+	/** \brief Filters the levels after the first of an RGBA8 mip chain, each from the one before it.
+	*
+	*	\param unsigned char* destination : Memory for the levels after the first, back to back and largest first.
+	*/
+	void createMipChain(const unsigned char* source, size_t width, size_t height, size_t levels, unsigned char* destination);
+}
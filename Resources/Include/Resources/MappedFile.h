@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+
+namespace sge
+{
+	/** \brief A whole file mapped read only into memory.
+	*
+	*	The pages are read in by the OS when they are first touched, so resources can point into
+	*	the mapping instead of reading and copying the file. The view stays valid until the file
+	*	is closed or the MappedFile destroyed.
+	*/
+	class MappedFile
+	{
+	public:
+		/** \brief The constructor, the file is opened separately.*/
+		MappedFile();
+
+		/** \brief The destructor, unmaps the file.*/
+		~MappedFile();
+
+		/** \brief Maps a file, closing the one mapped before.
+		*
+		*	\param const std::string& path : The path to the file.
+		*
+		*	\return Returns false when the file doesn't exist, is empty or can't be mapped.
+		*/
+		bool open(const std::string& path);
+
+		/** \brief Unmaps the file, pointers into it are invalid after this.*/
+		void close();
+
+		/** \brief Gets the first byte of the file, nullptr when no file is mapped.*/
+		const unsigned char* getData() const { return data; }
+
+		/** \brief Gets the size of the file in bytes.*/
+		size_t getSize() const { return size; }
+
+	private:
+		MappedFile(const MappedFile&) = delete;
+		void operator=(const MappedFile&) = delete;
+
+		const unsigned char* data;	/**<  Start of the view. */
+		size_t size;				/**<  Bytes in the view. */
+	};
+}
@@ -16,12 +16,15 @@
 
 #include "stb_image.h"
 
+#include "Resources/MappedFile.h"
 #include "Resources/TextureResource.h"
+#include "Core/Bounds.h"
 #include "Core/Math.h"
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "Renderer/Texture.h"
 #include "Renderer/GraphicsDevice.h"
+#include "Renderer/VertexLayout.h"
 
 struct Vertex {
 	// Position
@@ -36,57 +39,236 @@ struct Vertex {
 	sge::math::vec2 UV;
 };
 
+// Packed form of Vertex, 24 instead of 56 bytes. Decoded in VertexShaderLights.glsl.
+struct PackedVertex {
+	// Position as unorm16 relative to the mesh bounds
+	uint16 Position[4];
+	// Octahedral encoded normal and tangent, snorm16
+	uint32 Normal;
+	uint32 Tangent;
+	// Sign of the bitangent, cross(Normal, Tangent) * sign
+	int8 BitangentSign[4];
+	// Half float UV
+	uint32 UV;
+};
+
 namespace sge
 {
+	// Read only array of mesh data, either owning its elements or pointing into a cooked model file.
+	template <typename T>
+	class MeshArray
+	{
+	public:
+		MeshArray() : pointer(nullptr), count(0)
+		{
+		}
+
+		// Takes the elements over, moving a vector keeps its storage.
+		MeshArray(std::vector<T>&& values) : storage(std::move(values)), pointer(storage.data()), count(storage.size())
+		{
+		}
+
+		// Points to elements owned elsewhere, they have to outlive the array.
+		MeshArray(const T* values, size_t count) : pointer(values), count(count)
+		{
+		}
+
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		const T* data() const { return pointer; }
+		const T* begin() const { return pointer; }
+		const T* end() const { return pointer + count; }
+		const T& operator[](size_t index) const { return pointer[index]; }
+
+	private:
+		MeshArray(const MeshArray&) = delete;
+		void operator=(const MeshArray&) = delete;
+
+		std::vector<T> storage;
+		const T* pointer;
+		size_t count;
+	};
+
 	class Mesh {
 	public:
 		/*  Mesh Data  */
-		std::vector<Vertex> vertices;
-		std::vector<unsigned int> indices;
+		sge::MeshArray<Vertex> vertices;
+		sge::MeshArray<unsigned int> indices;
 		std::vector<sge::TextureResource> textures;
+
+		// Positions of the vertices for the position buffer, empty when they are gathered from the vertices.
+		sge::MeshArray<sge::math::vec3> positions;
 		
 		sge::Texture* diffuseTexture;
 		sge::Texture* normalTexture;
 		sge::Texture* specularTexture;
 
+		// The resources the textures were created from, null for textures set from outside.
+		sge::TextureResource* diffuseSource;
+		sge::TextureResource* normalSource;
+		sge::TextureResource* specularSource;
+
 		sge::Buffer* vertexBuffer;
 		sge::Buffer* indexBuffer;
 
+		// Tightly packed positions for depth only passes.
+		sge::Buffer* positionBuffer;
+
+		// Bounds of the vertex positions.
+		sge::AABB bounds;
+
+		// Set by createBuffers when the buffers hold PackedVertex, positions decode as position * scale + offset.
+		bool packed;
+		sge::math::vec4 positionScale;
+		sge::math::vec4 positionOffset;
+
+		// Where the positions live in the shared static geometry of the renderer, staticBlock is -1
+		// until the mesh is first drawn indirectly.
+		int32 staticBlock;
+		uint32 staticFirst;
+
 		/*  Functions  */
 		// Constructor
-		Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<sge::TextureResource> textures)
+		Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<sge::TextureResource> textures) :
+			vertices(std::move(vertices)), indices(std::move(indices)), textures(std::move(textures))
 		{
-			this->vertices = vertices;
-			this->indices = indices;
-			this->textures = textures;
-			diffuseTexture = nullptr;
-			normalTexture = nullptr;
-			specularTexture = nullptr;
+			initialize();
+
+			for (auto& vertex : this->vertices)
+			{
+				bounds.expand(vertex.Position);
+			}
+		}
+
+		// Constructor for cooked meshes, the data stays in the mapped file and the bounds were computed when cooking.
+		Mesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, const sge::math::vec3* positions,
+			const sge::AABB& bounds, std::vector<sge::TextureResource> textures) :
+			vertices(vertices, vertexCount), indices(indices, indexCount), textures(std::move(textures)), positions(positions, vertexCount), bounds(bounds)
+		{
+			initialize();
+		}
+
+		// Layouts of the interleaved and position only buffers of a packed mesh.
+		static VertexLayoutDescription getPackedLayout()
+		{
+			VertexLayoutDescription layout = { 5,
+			{
+				{ 0, 4, VertexSemantic::POSITION, VertexFormat::UNORM16 },
+				{ 0, 2, VertexSemantic::NORMAL, VertexFormat::SNORM16 },
+				{ 0, 2, VertexSemantic::TANGENT, VertexFormat::SNORM16 },
+				{ 0, 1, VertexSemantic::BINORMAL, VertexFormat::SNORM8 },
+				{ 0, 2, VertexSemantic::TEXCOORD, VertexFormat::HALF }
+			} };
+
+			return layout;
+		}
+
+		static VertexLayoutDescription getPackedPositionLayout()
+		{
+			VertexLayoutDescription layout = { 1,
+			{
+				{ 0, 3, VertexSemantic::POSITION, VertexFormat::UNORM16 }
+			} };
+
+			return layout;
 		}
 
-		void createBuffers(GraphicsDevice* device)
+		// Returns the number of bytes the vertex buffer takes. The buffers are created once, later calls keep them.
+		size_t createBuffers(GraphicsDevice* device, bool packVertices = false)
 		{
-			for (auto texture : textures)
+			if (vertexBuffer)
+			{
+				return vertices.size() * (packed ? sizeof(PackedVertex) : sizeof(Vertex));
+			}
+
+			for (auto& texture : textures)
 			{
 				if (texture.getTypeName() == "texture_diffuse")
 				{
 					diffuseTexture = device->createTexture(&texture);
+					diffuseSource = &texture;
 				}
 				else if (texture.getTypeName() == "texture_normal")
 				{
                     normalTexture = device->createTexture(&texture);
+                    normalSource = &texture;
 				}
 				else if (texture.getTypeName() == "texture_specular")
 				{
                     specularTexture = device->createTexture(&texture);
+                    specularSource = &texture;
 				}
 			}
 			//plaa
-			vertexBuffer = device->createBuffer(sge::BufferType::VERTEX, sge::BufferUsage::DYNAMIC, vertices.size()*sizeof(Vertex));
 			indexBuffer = device->createBuffer(sge::BufferType::INDEX, sge::BufferUsage::DYNAMIC, indices.size()*sizeof(unsigned int));
-			device->bindVertexBuffer(vertexBuffer);
-			device->bindIndexBuffer(indexBuffer);
+
+			if (packVertices)
+			{
+				return createPackedBuffers(device);
+			}
+
+			vertexBuffer = device->createBuffer(sge::BufferType::VERTEX, sge::BufferUsage::STATIC, vertices.size()*sizeof(Vertex));
 			device->copyData(vertexBuffer, sizeof(Vertex) * vertices.size(), vertices.data());
+
+			positionBuffer = device->createBuffer(sge::BufferType::VERTEX, sge::BufferUsage::STATIC, vertices.size() * sizeof(sge::math::vec3));
+
+			if (!positions.empty())
+			{
+				device->copyData(positionBuffer, sizeof(sge::math::vec3) * positions.size(), positions.data());
+			}
+			else
+			{
+				std::vector<sge::math::vec3> gathered;
+				gathered.reserve(vertices.size());
+
+				for (auto& vertex : vertices)
+				{
+					gathered.push_back(vertex.Position);
+				}
+
+				device->copyData(positionBuffer, sizeof(sge::math::vec3) * gathered.size(), gathered.data());
+			}
+
+			return sizeof(Vertex) * vertices.size();
+		}
+
+		// Deletes what createBuffers made, textures set from outside are left to their owner.
+		void deleteBuffers(GraphicsDevice* device)
+		{
+			if (!vertexBuffer)
+			{
+				return;
+			}
+
+			if (diffuseSource)
+			{
+				device->deleteTexture(diffuseTexture);
+				diffuseTexture = nullptr;
+				diffuseSource = nullptr;
+			}
+
+			if (normalSource)
+			{
+				device->deleteTexture(normalTexture);
+				normalTexture = nullptr;
+				normalSource = nullptr;
+			}
+
+			if (specularSource)
+			{
+				device->deleteTexture(specularTexture);
+				specularTexture = nullptr;
+				specularSource = nullptr;
+			}
+
+			device->deleteBuffer(vertexBuffer);
+			device->deleteBuffer(indexBuffer);
+			device->deleteBuffer(positionBuffer);
+
+			vertexBuffer = nullptr;
+			indexBuffer = nullptr;
+			positionBuffer = nullptr;
+			packed = false;
 		}
 
 		sge::Buffer* getVertexBuffer()
@@ -99,32 +281,102 @@ namespace sge
 			return indexBuffer;
 		}
 
+		sge::Buffer* getPositionBuffer()
+		{
+			return positionBuffer;
+		}
+
+		bool isPacked() const
+		{
+			return packed;
+		}
+
 		void setDiffuseTexture(sge::Texture* texture)
 		{
 			diffuseTexture = texture;
+			diffuseSource = nullptr;
 		}
 
 		void setSpecularTexture(sge::Texture* texture)
 		{
 			specularTexture = texture;
+			specularSource = nullptr;
 		}
 
 		void setNormalTexture(sge::Texture* texture)
 		{
 			normalTexture = texture;
+			normalSource = nullptr;
+		}
+
+	private:
+		void initialize()
+		{
+			diffuseTexture = nullptr;
+			normalTexture = nullptr;
+			specularTexture = nullptr;
+			diffuseSource = nullptr;
+			normalSource = nullptr;
+			specularSource = nullptr;
+
+			vertexBuffer = nullptr;
+			indexBuffer = nullptr;
+			positionBuffer = nullptr;
+
+			packed = false;
+			positionScale = sge::math::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+			positionOffset = sge::math::vec4(0.0f);
+
+			staticBlock = -1;
+			staticFirst = 0;
 		}
+
+		size_t createPackedBuffers(GraphicsDevice* device);
 	};
 
 	class ModelResource : public sge::Resource
 	{
 	public:
-		// Constructor, expects a filepath to a 3D model.
+		// Constructor, expects a filepath to a 3D model. The cooked file of the model is loaded in its place when it exists
+		// and was cooked from the model as it is now.
 		ModelResource(const std::string& resourcePath);
+
+		// Imports the model even when its cooked file is up to date, to compare the two.
+		ModelResource(const std::string& resourcePath, bool useCooked);
 		~ModelResource();
 
+		// The path of the cooked file that is loaded in place of a model.
+		static std::string getCookedPath(const std::string& modelPath);
+
+		// Imports a model and writes its meshes, bounds and texture references into a file that is mapped
+		// at load instead of imported. Returns false when the model can't be imported or the file written.
+		static bool cook(const std::string& modelPath, const std::string& cookedPath);
+
+		// True when the meshes point into a mapped cooked file.
+		bool isCooked() const { return cookedFile.getData() != nullptr; }
+
+		// False when the model couldn't be imported or had no meshes.
+		bool isLoaded() { return !meshes.empty(); }
+
 		std::vector<Mesh*> getMeshes();
 
-		void createBuffers();
+		// Returns the bounds of all the meshes in model space.
+		const sge::AABB& getBounds() { return bounds; }
+
+		// Packed vertices are quantized to PackedVertex, the pipelines drawing them need Mesh::getPackedLayout.
+		// Every load of a resident model shares it, so only the first call creates the buffers and decides
+		// whether they are packed, later calls keep them.
+		// Returns the bytes of the vertex buffers, getVertexCount() * sizeof(Vertex) when not packed.
+		size_t createBuffers(bool packVertices = false);
+
+		// Vertices of all the meshes.
+		size_t getVertexCount() const;
+
+		bool hasPackedVertices() const { return packedVertices; }
+
+		// Deletes the buffers and textures of the meshes on the thread owning the device, before the model
+		// is deleted. Whoever drew the meshes has to drop them first, createBuffers can make them again.
+		void deleteBuffers();
 
         void setDevice(GraphicsDevice* device) { this->device = device; }
 
@@ -132,10 +384,17 @@ namespace sge
         GraphicsDevice* device;
 		/*  Model Data  */
 		std::vector<Mesh*> meshes;
+		sge::AABB bounds;
+		bool packedVertices;
+		bool buffersCreated;
 		std::string directory;
 		std::vector<sge::TextureResource> textures_loaded; // Stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+		sge::MappedFile cookedFile; // The meshes of a cooked model point into it, so it lives as long as the model.
 
 		/*  Functions   */
+		// Maps a cooked model, returns false when the file is missing, invalid or older than the model.
+		bool loadCooked(const std::string& modelPath, const std::string& cookedPath);
+
 		// Loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
 		void loadModel(std::string path);
 
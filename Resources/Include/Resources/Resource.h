@@ -14,6 +14,9 @@ namespace sge
 		std::string& getResourcePath();
 		int getReferenceCount();
 
+		// False when the file couldn't be read, the resource is then empty.
+		virtual bool isLoaded() { return true; }
+
 	protected:
 
 		std::string resourcePath;
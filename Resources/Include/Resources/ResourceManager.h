@@ -1,4 +1,10 @@
 #pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <unordered_map>
 #include "Core/Assert.h"
@@ -23,12 +29,37 @@
 // and make sure they are not unloaded before all the references are cleared.
 //
 // When handle is no longer needed, release it to keep track of references.
+// Loading a path that is already resident returns a handle to the same
+// resource. Resources without references stay resident until unloadUnused,
+// which SceneManager calls after a scene change, so assets shared by the
+// old and the new scene are not read again.
+//
+// loadAsync returns the handle at once and reads the file on a worker thread.
+// The resource is published by update, until then getResource returns nullptr.
+// The callback of the load runs in update too, so it can create the graphics
+// objects of the resource when update is called on the thread owning the device:
+// sge::ResourceManager::getMgr().loadAsync<sge::ModelResource>("../Assets/cube.dae",
+//     [](sge::Handle<sge::ModelResource> handle) { ... });
+//
+// Handles resolve through a table of {magic, resource} entries indexed by the
+// handle, which never moves once allocated. getResource can be called from any
+// thread while update publishes resources, the rest of the manager is used from
+// one thread. unloadUnused leaves the resources it unloads to the second update
+// after it, so a pointer another thread resolved just before stays valid until
+// then. A thread keeping a resource for longer has to hold a referenced handle.
 
 namespace sge
 {
 	template<typename T>
 	class Handle;
 
+	enum class LoadState
+	{
+		LOADING,	// Being read on a worker thread.
+		READY,
+		FAILED		// The file couldn't be read or the resource was unloaded.
+	};
+
 	class ResourceManager
 	{
 	public:
@@ -37,6 +68,7 @@ namespace sge
 		~ResourceManager();
 
 		// This function generates a new resource into our Handle.
+		// A path loaded before shares its resource, the file is read only once.
 		template <typename T>
 		Handle<T> load(const std::string &filename)
 		{
@@ -49,78 +81,160 @@ namespace sge
 			Handle<T> handle(this);
 			unsigned int index;
 
+			if (findSlot(filename, index))
+			{
+				handle.init(index, slots[index].magic);
+				addReference(slots[index]);
+
+				// An asynchronous load of the path is running, so this one waits for it.
+				if (slots[index].state == LoadState::LOADING)
+				{
+					finishLoad(index);
+				}
+
+				return handle;
+			}
+
 			// Create a new resource pointer of our template type.
 			T* resource = new T(filename);
 
-			if (freeSlots.empty())
+			index = createSlot(handle, filename, resource->isLoaded() ? LoadState::READY : LoadState::FAILED);
+			slots[index].resource = resource;
+			setEntry(index);
+
+			// Finally we add +1 to our resource references.
+			addReference(slots[index]);
+
+			return handle;
+		};
+
+		// Loads a resource on a worker thread, the handle resolves to nullptr until update publishes it.
+		// The callback runs in update once the resource is ready or failed, the handle tells which.
+		// A path loaded before shares its resource, the callback then runs in the next update.
+		template <typename T>
+		Handle<T> loadAsync(const std::string& filename, std::function<void(Handle<T>)> callback = nullptr)
+		{
+			if (filename.empty())
+			{
+				std::cout << "Filename cannot be empty! Error loading resource." << std::endl;
+				return Handle<T>();
+			}
+
+			Handle<T> handle(this);
+			unsigned int index;
+			bool resident = findSlot(filename, index);
+
+			if (resident)
 			{
-				index = magicNumbers.size();
-				handle.init(index);
-				userData.insert({ filename, resource });
-				magicNumbers.push_back(handle.getMagic());
+				handle.init(index, slots[index].magic);
 			}
 			else
 			{
-				index = freeSlots.back();
-				handle.init(index);
-				freeSlots.pop_back();
-				magicNumbers[index] = handle.getMagic();
+				index = createSlot(handle, filename, LoadState::LOADING);
 			}
 
-			// Assertion to make sure our resource "chain" doesn't break
-			pathVec.push_back(filename);
-			SGE_ASSERT(pathVec.at(index) == filename);
+			addReference(slots[index]);
 
-			// Finally we add +1 to our resource references.
-			std::unordered_map<std::string, sge::Resource*>::iterator it;
-			it = userData.find(filename);
+			if (callback)
+			{
+				std::function<void()> call = [callback, handle]() { callback(handle); };
+
+				if (slots[index].state == LoadState::LOADING)
+				{
+					slots[index].callbacks.push_back(call);
+				}
+				else
+				{
+					readyCallbacks.push_back(call);
+				}
+			}
 
-			if (it != userData.end())
+			if (resident)
 			{
-				(*it).second->increaseRef();
+				return handle;
 			}
 
+			AsyncLoad load;
+			load.index = index;
+			load.magic = handle.getMagic();
+			load.path = filename;
+			load.create = [](const std::string& path) -> Resource* { return new T(path); };
+			load.resource = nullptr;
+
+			{
+				std::lock_guard<std::mutex> lock(loadMutex);
+
+				queuedLoads.push_back(load);
+				pendingLoads++;
+			}
+
+			startLoadThreads();
+			loadCondition.notify_one();
+
 			return handle;
-		};
+		}
+
+		// Publishes the resources finished on the worker threads and runs their callbacks on the calling thread.
+		// Deletes the resources unloaded before the previous update.
+		// The callbacks may start new loads but not call update.
+		void update();
+
+		// Number of asynchronous loads not yet published by update.
+		size_t getPendingLoads();
+
+		// True when update has resources to publish or delete, or callbacks to run.
+		bool hasFinishedLoads();
+
+		// The most files read at once, the worker threads finish their current file before a change.
+		void setLoadThreads(size_t count);
+		size_t getLoadThreads() const { return loadThreads; }
+
+		// State of the resource behind a handle, FAILED for handles of unloaded resources.
+		LoadState getLoadState(unsigned int index, unsigned int magic) const
+		{
+			return index < slots.size() && slots[index].magic == magic ? slots[index].state : LoadState::FAILED;
+		}
 
 		// Function for releasing the handle after it's become unnecessary.
+		// A resource without references stays loaded until unloadUnused, so it can be loaded again for free.
 		template <class T>
 		void release(Handle<T> handle)
 		{
 			unsigned int index = handle.getIndex();
 
-			SGE_ASSERT(index < pathVec.size());
-			SGE_ASSERT(magicNumbers[index] == handle.getMagic()); // We make sure we are releasing the correct handle by comparing the magic numbers.
-
-			magicNumbers[index] = 0;
-			freeSlots.push_back(index); // A new free slot is added to our list.
-
-			std::unordered_map<std::string, sge::Resource*>::iterator it;
-			std::string filename = pathVec.at(index);
-			it = userData.find(filename);
+			SGE_ASSERT(index < slots.size());
+			SGE_ASSERT(slots[index].magic == handle.getMagic()); // We make sure we are releasing the correct handle by comparing the magic numbers.
+			SGE_ASSERT(slots[index].references > 0);
 
-			if (it != userData.end()) // References are decreased after release.
-			{
-				(*it).second->decreaseRef();
-			}
+			Slot& slot = slots[index];
+			slot.references--; // References are decreased after release.
 
-			if ((*it).second->getReferenceCount() == 0) // If references have reached 0, we'll remove resource from memory.
+			if (slot.resource)
 			{
-				(*it).second->~Resource();
+				slot.resource->references = slot.references;
 			}
 
-			std::cout << filename << " | Handle released. References: " << (*it).second->getReferenceCount() << std::endl;
+			std::cout << slot.path << " | Handle released. References: " << slot.references << std::endl;
 		};
 
-		// Function to retrieve a resource pointer from our handle.
+		// Unloads the resources no handle refers to, call it when the unused ones aren't about to be loaded again.
+		// Their handles resolve to nullptr at once, the second update after deletes them.
+		// Returns the number of resources unloaded.
+		size_t unloadUnused();
+
+		// The callback runs in update right before a resource unloaded by unloadUnused is deleted, on the thread
+		// calling update, so users of the resource can drop what they made from it. Resources still resident when
+		// the manager is destroyed are deleted without it. Returns the ID removeUnloadCallback takes.
+		size_t addUnloadCallback(std::function<void(Resource*)> callback);
+		void removeUnloadCallback(size_t id);
+
+		// Function to retrieve a resource pointer from our handle, safe to call from any thread.
+		// Asynchronous loads aren't there until published, unloaded resources resolve to nullptr.
+		// The pointer stays valid while the handle is referenced, or until the second update after the resource is unloaded.
 		template <typename T>
 		T* getResource(sge::Handle<T>& handle)
 		{
-			std::string path = pathVec.at(handle.getIndex());
-
-			std::unordered_map<std::string, sge::Resource*>::iterator it;
-			it = userData.find(path);
-			return static_cast<T*>((*it).second);
+			return static_cast<T*>(findResource(handle.getIndex(), handle.getMagic()));
 		}
 
 		static ResourceManager& getMgr()
@@ -136,17 +250,170 @@ namespace sge
 
 	private:
 
-		// Keeps track of the resource paths and pointers for comparison.
-		std::unordered_map<std::string, sge::Resource*> userData;
+		// A resident resource, all the handles loading its path share the slot.
+		struct Slot
+		{
+			std::string path;
+			Resource* resource;			// nullptr while loading.
+			unsigned int magic;			// 0 for free slots.
+			unsigned int generation;	// Magic of the next path in the slot, changed whenever the slot is freed.
+			int references;
+			LoadState state;
+			std::vector<std::function<void()>> callbacks;	// Waiting for the asynchronous load.
+		};
+
+		// What a handle resolves to, written by the thread using the manager and read by any.
+		struct Entry
+		{
+			std::atomic<unsigned int> magic;	// 0 while the entry is being changed or free.
+			std::atomic<Resource*> resource;
+		};
+
+		// Entries are allocated a block at a time, blocks cover every index a handle can hold.
+		// Magic numbers fit the 16 bits a handle has for them, 0 is reserved for null handles.
+		enum
+		{
+			ENTRY_BLOCK_SIZE = 256,
+			ENTRY_BLOCKS = 65536 / ENTRY_BLOCK_SIZE,
+			MAX_MAGIC = 65535
+		};
 
-		// Magic numbers are used as an ID to make sure we have the correct resource.
-		std::vector<unsigned int> magicNumbers;
+		struct AsyncLoad
+		{
+			unsigned int index;
+			unsigned int magic;
+			std::string path;
+			std::function<Resource*(const std::string&)> create;	// Runs on a worker thread.
+			Resource* resource;
+		};
+
+		Resource* findResource(unsigned int index, unsigned int magic) const
+		{
+			Entry* block = entryBlocks[index / ENTRY_BLOCK_SIZE].load(std::memory_order_acquire);
+
+			if (!block || magic == 0)
+			{
+				return nullptr;
+			}
+
+			Entry& entry = block[index % ENTRY_BLOCK_SIZE];
+
+			if (entry.magic.load(std::memory_order_acquire) != magic)
+			{
+				return nullptr;
+			}
+
+			Resource* resource = entry.resource.load(std::memory_order_acquire);
+
+			// The magic is cleared before the entry changes, so a resource read mid change is dropped.
+			return entry.magic.load(std::memory_order_acquire) == magic ? resource : nullptr;
+		}
+
+		// Points the entry of a slot to its resource, the slot has to be up to date.
+		void setEntry(unsigned int index);
+
+		bool findSlot(const std::string& filename, unsigned int& index) const
+		{
+			auto it = pathIds.find(filename);
+
+			if (it == pathIds.end())
+			{
+				return false;
+			}
+
+			index = it->second;
+
+			return true;
+		}
+
+		// Gives the handle a free slot for the path.
+		template <typename T>
+		unsigned int createSlot(Handle<T>& handle, const std::string& filename, LoadState state)
+		{
+			unsigned int index;
+
+			if (freeSlots.empty())
+			{
+				index = slots.size();
+				slots.push_back(Slot());
+				slots[index].generation = 1;
+			}
+			else
+			{
+				index = freeSlots.back();
+				freeSlots.pop_back();
+			}
+
+			Slot& slot = slots[index];
+
+			// Stale handles of the previous path in the slot hold an older generation, whatever their type.
+			handle.init(index, slot.generation);
+
+			slot.path = filename;
+			slot.resource = nullptr;
+			slot.magic = slot.generation;
+			slot.references = 0;
+			slot.state = state;
+
+			pathIds[filename] = index;
+			setEntry(index);
+
+			return index;
+		}
+
+		void addReference(Slot& slot)
+		{
+			slot.references++;
+
+			if (slot.resource)
+			{
+				slot.resource->references = slot.references;
+			}
+		}
+
+		// Waits for the asynchronous load of a slot and publishes it.
+		void finishLoad(unsigned int index);
+
+		void publish(AsyncLoad& load);
+		void startLoadThreads();
+		void stopLoadThreads();
+		void runLoads();
+
+		// Resident resources, the index of the slot is the ID of its path.
+		std::vector<Slot> slots;
+
+		// Lookup table of the slots, kept apart so readers never see the slots reallocate.
+		std::atomic<Entry*> entryBlocks[ENTRY_BLOCKS];
+
+		// Interned paths, a load looks its path up once.
+		std::unordered_map<std::string, unsigned int> pathIds;
 
 		// Free slots are used to optimise resource storing.
 		std::vector<unsigned int> freeSlots;
 
-		// Resource paths.
-		std::vector<std::string> pathVec;
+		// Callbacks of asynchronous loads that found their resource resident.
+		std::vector<std::function<void()>> readyCallbacks;
+
+		// Asynchronous loads, the worker threads take them from the queue and hand them back finished.
+		std::vector<std::thread> loadWorkers;
+		std::mutex loadMutex;
+		std::condition_variable loadCondition;
+		std::condition_variable finishedCondition;
+		std::deque<AsyncLoad> queuedLoads;
+		std::vector<AsyncLoad> finishedLoads;
+		std::vector<AsyncLoad> publishedLoads;
+
+		// Unloaded resources other threads may still be reading, the next update expires the retired
+		// ones and deletes the expired ones. Guarded by the load mutex too, for hasFinishedLoads.
+		std::vector<Resource*> retiredResources;
+		std::vector<Resource*> expiredResources;
+
+		size_t pendingLoads;
+		size_t loadThreads;
+		bool stopLoads;
+
+		std::unordered_map<size_t, std::function<void(Resource*)>> unloadCallbacks;
+		size_t nextUnloadCallback;
 
 		// Deletes all loaded resources.
 		void releaseAll();
@@ -200,7 +467,8 @@ namespace sge
 
 		Handle(ResourceManager* refManager) : refManager(refManager) { HANDLE.m_Handle = 0; }
 
-		void init(unsigned int index);
+		// Initialization gives our handle its index and the magic number of the slot.
+		void init(unsigned int index, unsigned int magic);
 
 		// Methods for managing our Handle
 
@@ -219,24 +487,27 @@ namespace sge
 			return (!HANDLE.m_Handle);
 		}
 
+		// Asynchronous loads are ready once update published them, synchronous ones right away.
+		bool isReady()				const
+		{
+			return refManager && refManager->getLoadState(getIndex(), getMagic()) == LoadState::READY;
+		}
+
+		bool hasFailed()			const
+		{
+			return !refManager || refManager->getLoadState(getIndex(), getMagic()) == LoadState::FAILED;
+		}
+
 	};
 
-	// Initialization gives our handle its index and magic numbers.
 	template <typename TAG>
-	void Handle<TAG>::init(unsigned int index)
+	void Handle<TAG>::init(unsigned int index, unsigned int magic)
 	{
 		// Check if the handle is valid and within allocated range.
 		SGE_ASSERT(isNull());
-		SGE_ASSERT(index <= HANDLE.MAX_INDEX);
-
-		static unsigned int s_AutoMagic = 0;
-		if (++s_AutoMagic > HANDLE.MAX_MAGIC)
-		{
-			// Value 0 is reserved for Null handle.
-			s_AutoMagic = 1;
-		}
+		SGE_ASSERT(index <= HANDLE.MAX_INDEX && magic != 0 && magic <= HANDLE.MAX_MAGIC);
 
 		HANDLE.MAXBITS.m_Index = index;
-		HANDLE.MAXBITS.m_Magic = s_AutoMagic;
+		HANDLE.MAXBITS.m_Magic = magic;
 	}
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "stb_image.h"
 #include "Renderer/Texture.h"
 #include "Renderer/GraphicsDevice.h"
@@ -53,12 +55,55 @@ namespace sge
 		void setTypename(const std::string& typeName);
 
         int getFormat();
+
+		/** \brief Tells if the pixels were loaded, false when the file couldn't be read or decoded.*/
+		bool isLoaded();
+
+		/** \brief Gets the format of the stored pixels, RGBA unless the texture was cooked into compressed blocks.*/
+		Format getPixelFormat();
+
+		/** \brief Tells if the texture was loaded from a cooked file with its mip chain.*/
+		bool isCooked();
+
+		/** \brief Gets the number of stored mip levels, 1 for images decoded at load.*/
+		size_t getLevels();
+
+		/** \brief Gets the pixels of a mip level, getData returns the first level.*/
+		unsigned char* getLevelData(size_t level);
+
+		/** \brief Gets the size of a mip level in bytes.*/
+		size_t getLevelSize(size_t level);
+
+		/** \brief Gets the path of the cooked file that is loaded in place of an image.
+		*
+		*	\param const std::string& imagePath : The path of the source image.
+		*/
+		static std::string getCookedPath(const std::string& imagePath);
+
+		/** \brief Cooks an image into a file with its whole mip chain precomputed and compressed.
+		*
+		*	The mips are box filtered from the RGBA8 image and compressed to BC1, BC3 or BC5, RGBA keeps
+		*	them uncompressed. Loading the cooked file skips the image decode and the runtime mip generation.
+		*
+		*	\param const std::string& imagePath : The path of the source image.
+		*	\param const std::string& cookedPath : The path of the written file, usually getCookedPath(imagePath).
+		*	\param Format format : BC1, BC3, BC5 or RGBA.
+		*
+		*	\return Returns false when the image can't be decoded or the file can't be written.
+		*/
+		static bool cook(const std::string& imagePath, const std::string& cookedPath, Format format);
+
 	private:
+		bool loadCooked(const std::string& cookedPath);
+
 		int width;				/**<  Width of the texture. */
 		int height;				/**<  Height of the texture. */
 		int format;	            /**<  Number of components in texture. */
 		std::string typeName;	/**<  Type of the texture. */
 		unsigned char* data;	/**<  Texture data pointer. */
 		Texture texture;		/**<  Texture class. */
+		Format pixelFormat;		/**<  Format of the stored pixels. */
+		std::vector<size_t> levelOffsets;	/**<  Offsets of the cooked mip levels from the data pointer. */
+		std::vector<size_t> levelSizes;		/**<  Sizes of the cooked mip levels, empty for decoded images. */
 	};
 }
\ No newline at end of file
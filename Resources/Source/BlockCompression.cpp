@@ -0,0 +1,329 @@
+#include <cmath>
+#include <cstdlib>
+
+#include "Resources/BlockCompression.h"
+
+#include "Core/Assert.h"
+#include "Core/Types.h"
+
+namespace sge
+{
+	namespace
+	{
+		uint16 packColor(const uint8* color)
+		{
+			uint16 r = static_cast<uint16>((color[0] * 31 + 127) / 255);
+			uint16 g = static_cast<uint16>((color[1] * 63 + 127) / 255);
+			uint16 b = static_cast<uint16>((color[2] * 31 + 127) / 255);
+
+			return static_cast<uint16>((r << 11) | (g << 5) | b);
+		}
+
+		void unpackColor(uint16 packed, int color[3])
+		{
+			int r = (packed >> 11) & 31;
+			int g = (packed >> 5) & 63;
+			int b = packed & 31;
+
+			color[0] = (r << 3) | (r >> 2);
+			color[1] = (g << 2) | (g >> 4);
+			color[2] = (b << 3) | (b >> 2);
+		}
+
+		// Picks the endpoints at the extremes of the principal axis of the block colors.
+		void encodeColorBlock(const uint8 block[64], uint8* destination)
+		{
+			float mean[3] = { 0.0f, 0.0f, 0.0f };
+			float minimum[3] = { 255.0f, 255.0f, 255.0f };
+			float maximum[3] = { 0.0f, 0.0f, 0.0f };
+
+			for (size_t i = 0; i < 16; i++)
+			{
+				for (size_t c = 0; c < 3; c++)
+				{
+					float value = block[i * 4 + c];
+					mean[c] += value / 16.0f;
+					minimum[c] = std::fmin(minimum[c], value);
+					maximum[c] = std::fmax(maximum[c], value);
+				}
+			}
+
+			float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+			for (size_t i = 0; i < 16; i++)
+			{
+				float r = block[i * 4] - mean[0];
+				float g = block[i * 4 + 1] - mean[1];
+				float b = block[i * 4 + 2] - mean[2];
+
+				covariance[0] += r * r;
+				covariance[1] += r * g;
+				covariance[2] += r * b;
+				covariance[3] += g * g;
+				covariance[4] += g * b;
+				covariance[5] += b * b;
+			}
+
+			float axis[3] = { maximum[0] - minimum[0], maximum[1] - minimum[1], maximum[2] - minimum[2] };
+
+			for (size_t iteration = 0; iteration < 4; iteration++)
+			{
+				float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+				float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+				float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+				float length = std::fmax(std::fabs(x), std::fmax(std::fabs(y), std::fabs(z)));
+
+				if (length < 1e-6f)
+				{
+					break;
+				}
+
+				axis[0] = x / length;
+				axis[1] = y / length;
+				axis[2] = z / length;
+			}
+
+			size_t low = 0;
+			size_t high = 0;
+			float lowDot = 0.0f;
+			float highDot = 0.0f;
+
+			for (size_t i = 0; i < 16; i++)
+			{
+				float dot = block[i * 4] * axis[0] + block[i * 4 + 1] * axis[1] + block[i * 4 + 2] * axis[2];
+
+				if (i == 0 || dot < lowDot)
+				{
+					lowDot = dot;
+					low = i;
+				}
+
+				if (i == 0 || dot > highDot)
+				{
+					highDot = dot;
+					high = i;
+				}
+			}
+
+			uint16 color0 = packColor(block + high * 4);
+			uint16 color1 = packColor(block + low * 4);
+
+			// The first endpoint has to be the larger one, otherwise the block decodes in the 3 color mode.
+			if (color0 < color1)
+			{
+				uint16 swap = color0;
+				color0 = color1;
+				color1 = swap;
+			}
+
+			uint32 indices = 0;
+
+			if (color0 != color1)
+			{
+				int palette[4][3];
+				unpackColor(color0, palette[0]);
+				unpackColor(color1, palette[1]);
+
+				for (size_t c = 0; c < 3; c++)
+				{
+					palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+					palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+				}
+
+				for (size_t i = 0; i < 16; i++)
+				{
+					uint32 best = 0;
+					int bestDistance = 0;
+
+					for (uint32 p = 0; p < 4; p++)
+					{
+						int r = block[i * 4] - palette[p][0];
+						int g = block[i * 4 + 1] - palette[p][1];
+						int b = block[i * 4 + 2] - palette[p][2];
+						int distance = r * r + g * g + b * b;
+
+						if (p == 0 || distance < bestDistance)
+						{
+							bestDistance = distance;
+							best = p;
+						}
+					}
+
+					indices |= best << (i * 2);
+				}
+			}
+
+			destination[0] = static_cast<uint8>(color0);
+			destination[1] = static_cast<uint8>(color0 >> 8);
+			destination[2] = static_cast<uint8>(color1);
+			destination[3] = static_cast<uint8>(color1 >> 8);
+			destination[4] = static_cast<uint8>(indices);
+			destination[5] = static_cast<uint8>(indices >> 8);
+			destination[6] = static_cast<uint8>(indices >> 16);
+			destination[7] = static_cast<uint8>(indices >> 24);
+		}
+
+		// Encodes one channel of the block in the 8 value mode, shared by the BC3 alpha and both BC5 channels.
+		void encodeChannelBlock(const uint8 block[64], size_t channel, uint8* destination)
+		{
+			int minimum = 255;
+			int maximum = 0;
+
+			for (size_t i = 0; i < 16; i++)
+			{
+				int value = block[i * 4 + channel];
+				minimum = value < minimum ? value : minimum;
+				maximum = value > maximum ? value : maximum;
+			}
+
+			uint64 indices = 0;
+
+			if (maximum != minimum)
+			{
+				int palette[8];
+				palette[0] = maximum;
+				palette[1] = minimum;
+
+				for (int p = 1; p < 7; p++)
+				{
+					palette[p + 1] = ((7 - p) * maximum + p * minimum + 3) / 7;
+				}
+
+				for (size_t i = 0; i < 16; i++)
+				{
+					int value = block[i * 4 + channel];
+					uint64 best = 0;
+					int bestDistance = 256;
+
+					for (uint64 p = 0; p < 8; p++)
+					{
+						int distance = std::abs(value - palette[p]);
+
+						if (distance < bestDistance)
+						{
+							bestDistance = distance;
+							best = p;
+						}
+					}
+
+					indices |= best << (i * 3);
+				}
+			}
+
+			destination[0] = static_cast<uint8>(maximum);
+			destination[1] = static_cast<uint8>(minimum);
+
+			for (size_t i = 0; i < 6; i++)
+			{
+				destination[i + 2] = static_cast<uint8>(indices >> (i * 8));
+			}
+		}
+
+		size_t getBlockSize(Format format)
+		{
+			switch (format)
+			{
+			case Format::BC1: return 8;
+			case Format::BC3: return 16;
+			case Format::BC5: return 16;
+			default: return 0;
+			}
+		}
+	}
+
+	size_t getImageSize(Format format, size_t width, size_t height)
+	{
+		switch (format)
+		{
+		case Format::RGB: return width * height * 3;
+		case Format::RGBA: return width * height * 4;
+		case Format::R32F: return width * height * 4;
+		case Format::RGBA16F: return width * height * 8;
+		default: return ((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format);
+		}
+	}
+
+	void compressImage(Format format, const unsigned char* source, size_t width, size_t height, unsigned char* destination)
+	{
+		SGE_ASSERT(getBlockSize(format) != 0);
+
+		uint8 block[64];
+
+		for (size_t y = 0; y < height; y += 4)
+		{
+			for (size_t x = 0; x < width; x += 4)
+			{
+				for (size_t i = 0; i < 16; i++)
+				{
+					size_t px = x + i % 4 < width ? x + i % 4 : width - 1;
+					size_t py = y + i / 4 < height ? y + i / 4 : height - 1;
+					const unsigned char* pixel = source + (py * width + px) * 4;
+
+					block[i * 4] = pixel[0];
+					block[i * 4 + 1] = pixel[1];
+					block[i * 4 + 2] = pixel[2];
+					block[i * 4 + 3] = pixel[3];
+				}
+
+				switch (format)
+				{
+				case Format::BC1:
+					encodeColorBlock(block, destination);
+					break;
+				case Format::BC3:
+					encodeChannelBlock(block, 3, destination);
+					encodeColorBlock(block, destination + 8);
+					break;
+				case Format::BC5:
+					encodeChannelBlock(block, 0, destination);
+					encodeChannelBlock(block, 1, destination + 8);
+					break;
+				default:
+					break;
+				}
+
+				destination += getBlockSize(format);
+			}
+		}
+	}
+
+	void downsampleImage(const unsigned char* source, size_t width, size_t height, unsigned char* destination)
+	{
+		size_t halfWidth = width > 1 ? width / 2 : 1;
+		size_t halfHeight = height > 1 ? height / 2 : 1;
+
+		for (size_t y = 0; y < halfHeight; y++)
+		{
+			size_t y0 = y * 2 < height ? y * 2 : height - 1;
+			size_t y1 = y * 2 + 1 < height ? y * 2 + 1 : height - 1;
+
+			for (size_t x = 0; x < halfWidth; x++)
+			{
+				size_t x0 = x * 2 < width ? x * 2 : width - 1;
+				size_t x1 = x * 2 + 1 < width ? x * 2 + 1 : width - 1;
+
+				for (size_t c = 0; c < 4; c++)
+				{
+					unsigned int sum =
+						source[(y0 * width + x0) * 4 + c] + source[(y0 * width + x1) * 4 + c] +
+						source[(y1 * width + x0) * 4 + c] + source[(y1 * width + x1) * 4 + c];
+
+					destination[(y * halfWidth + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+				}
+			}
+		}
+	}
+
+	void createMipChain(const unsigned char* source, size_t width, size_t height, size_t levels, unsigned char* destination)
+	{
+		for (size_t level = 1; level < levels; level++)
+		{
+			downsampleImage(source, width, height, destination);
+
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+			source = destination;
+			destination += getImageSize(Format::RGBA, width, height);
+		}
+	}
+}
@@ -0,0 +1,126 @@
+#include "Resources/MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sge
+{
+	MappedFile::MappedFile() : data(nullptr), size(0)
+	{
+	}
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+#ifdef _WIN32
+	bool MappedFile::open(const std::string& path)
+	{
+		close();
+
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			CloseHandle(file);
+
+			return false;
+		}
+
+		// The view keeps the mapping alive, so neither handle is needed after this.
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+
+		if (!mapping)
+		{
+			return false;
+		}
+
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+
+		if (!view)
+		{
+			return false;
+		}
+
+		data = static_cast<const unsigned char*>(view);
+		size = static_cast<size_t>(fileSize.QuadPart);
+
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (data)
+		{
+			UnmapViewOfFile(data);
+		}
+
+		data = nullptr;
+		size = 0;
+	}
+#else
+	bool MappedFile::open(const std::string& path)
+	{
+		close();
+
+		int file = ::open(path.c_str(), O_RDONLY);
+
+		if (file < 0)
+		{
+			return false;
+		}
+
+		struct stat status;
+
+		if (fstat(file, &status) != 0 || status.st_size == 0)
+		{
+			::close(file);
+
+			return false;
+		}
+
+		// The mapping stays valid after the descriptor is closed.
+		void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		::close(file);
+
+		if (view == MAP_FAILED)
+		{
+			return false;
+		}
+
+		data = static_cast<const unsigned char*>(view);
+		size = static_cast<size_t>(status.st_size);
+
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (data)
+		{
+			munmap(const_cast<unsigned char*>(data), size);
+		}
+
+		data = nullptr;
+		size = 0;
+	}
+#endif
+}
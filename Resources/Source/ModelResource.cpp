@@ -1,15 +1,189 @@
+#include <cmath>
+#include <cstring>
+#include <sys/stat.h>
+
 #include "Resources/ModelResource.h"
 
 namespace sge
 {
+	namespace
+	{
+		const char COOKED_MAGIC[4] = { 'S', 'G', 'E', 'M' };
+		const uint32 COOKED_VERSION = 2;
+
+		// The data blocks start at multiples of it, so the mapped vertices are aligned like allocated ones.
+		const uint64 COOKED_ALIGNMENT = 16;
+
+		// Followed by the mesh table, the texture table and the data of every mesh: its vertices, indices
+		// and positions, each aligned to COOKED_ALIGNMENT from the start of the file.
+		struct CookedHeader
+		{
+			char magic[4];
+			uint32 version;
+			uint32 vertexSize;
+			uint32 meshCount;
+			uint32 textureCount;
+			uint32 pad;
+			float boundsMin[3];
+			float boundsMax[3];
+			uint64 fileSize;
+			uint64 sourceSize;		// Size and modification time of the model the file was cooked from.
+			uint64 sourceModified;
+		};
+
+		struct CookedMesh
+		{
+			uint64 vertexOffset;
+			uint64 indexOffset;
+			uint64 positionOffset;
+			uint32 vertexCount;
+			uint32 indexCount;
+			uint32 firstTexture;	// Textures of the mesh in the texture table.
+			uint32 textureCount;
+			float boundsMin[3];
+			float boundsMax[3];
+		};
+
+		struct CookedTexture
+		{
+			char typeName[32];
+			char path[224];
+		};
+
+		bool getSourceStamp(const std::string& path, uint64& size, uint64& modified)
+		{
+			struct stat status;
+
+			if (stat(path.c_str(), &status) != 0)
+			{
+				return false;
+			}
+
+			size = static_cast<uint64>(status.st_size);
+			modified = static_cast<uint64>(status.st_mtime);
+
+			return true;
+		}
+
+		uint64 alignOffset(uint64 offset)
+		{
+			return (offset + COOKED_ALIGNMENT - 1) / COOKED_ALIGNMENT * COOKED_ALIGNMENT;
+		}
+
+		bool copyString(const std::string& source, char* destination, size_t size)
+		{
+			if (source.size() >= size)
+			{
+				return false;
+			}
+
+			std::memset(destination, 0, size);
+			std::memcpy(destination, source.c_str(), source.size());
+
+			return true;
+		}
+
+		// Maps a unit vector onto the octahedron and unfolds it into [-1, 1]^2, packed as two snorm16.
+		uint32 encodeOctahedral(const math::vec3& direction)
+		{
+			math::vec3 n = direction / (std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z));
+			math::vec2 encoded(n.x, n.y);
+
+			if (n.z < 0.0f)
+			{
+				encoded.x = (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+				encoded.y = (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+			}
+
+			return math::packSnorm2x16(encoded);
+		}
+
+		math::vec3 safeNormalize(const math::vec3& v, const math::vec3& fallback)
+		{
+			float length = math::length(v);
+
+			return length > 0.0f ? v / length : fallback;
+		}
+	}
+
+	size_t Mesh::createPackedBuffers(GraphicsDevice* device)
+	{
+		math::vec3 extent = bounds.max - bounds.min;
+
+		// A flat mesh has no extent on one axis, any scale decodes it.
+		for (int i = 0; i < 3; i++)
+		{
+			if (extent[i] <= 0.0f)
+			{
+				extent[i] = 1.0f;
+			}
+		}
+
+		packed = true;
+		positionScale = math::vec4(extent, 0.0f);
+		positionOffset = math::vec4(bounds.min, 0.0f);
+
+		std::vector<PackedVertex> packedVertices(vertices.size());
+		std::vector<uint16> positions(vertices.size() * 4);
+
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			const Vertex& vertex = vertices[i];
+			PackedVertex& packedVertex = packedVertices[i];
+
+			math::vec3 position = math::clamp((vertex.Position - bounds.min) / extent, 0.0f, 1.0f);
+			math::vec3 normal = safeNormalize(vertex.Normal, math::vec3(0.0f, 0.0f, 1.0f));
+			math::vec3 tangent = safeNormalize(vertex.Tangent, math::vec3(1.0f, 0.0f, 0.0f));
+
+			for (int j = 0; j < 3; j++)
+			{
+				packedVertex.Position[j] = static_cast<uint16>(std::floor(position[j] * 65535.0f + 0.5f));
+				positions[i * 4 + j] = packedVertex.Position[j];
+			}
+
+			packedVertex.Position[3] = 0;
+			positions[i * 4 + 3] = 0;
+
+			packedVertex.Normal = encodeOctahedral(normal);
+			packedVertex.Tangent = encodeOctahedral(tangent);
+
+			packedVertex.BitangentSign[0] = math::dot(math::cross(normal, tangent), vertex.Bitangent) < 0.0f ? -127 : 127;
+			packedVertex.BitangentSign[1] = 0;
+			packedVertex.BitangentSign[2] = 0;
+			packedVertex.BitangentSign[3] = 0;
+
+			packedVertex.UV = math::packHalf2x16(vertex.UV);
+		}
+
+		vertexBuffer = device->createBuffer(sge::BufferType::VERTEX, sge::BufferUsage::STATIC, packedVertices.size() * sizeof(PackedVertex));
+		device->copyData(vertexBuffer, packedVertices.size() * sizeof(PackedVertex), packedVertices.data());
+
+		positionBuffer = device->createBuffer(sge::BufferType::VERTEX, sge::BufferUsage::STATIC, positions.size() * sizeof(uint16));
+		device->copyData(positionBuffer, positions.size() * sizeof(uint16), positions.data());
+
+		return packedVertices.size() * sizeof(PackedVertex);
+	}
+
 	// Constructor, expects a filepath to a 3D model.
-	ModelResource::ModelResource(const std::string& resourcePath) : sge::Resource(resourcePath)
+	ModelResource::ModelResource(const std::string& resourcePath) : ModelResource(resourcePath, true)
+	{
+	}
+
+	ModelResource::ModelResource(const std::string& resourcePath, bool useCooked) : sge::Resource(resourcePath), packedVertices(false), buffersCreated(false)
 	{
+		if (useCooked && this->loadCooked(resourcePath, getCookedPath(resourcePath)))
+		{
+			return;
+		}
+
 		this->loadModel(resourcePath);
 	}
 	ModelResource::~ModelResource()
 	{
-		meshes.erase(meshes.begin(), meshes.end());
+		for (auto mesh : meshes)
+		{
+			delete mesh;
+		}
 	}
 
 	std::vector<Mesh*> ModelResource::getMeshes()
@@ -17,12 +191,305 @@ namespace sge
 		return meshes;
 	}
 
-	void ModelResource::createBuffers()
+	size_t ModelResource::createBuffers(bool packVertices)
+	{
+		size_t bytes = 0;
+
+		if (buffersCreated)
+		{
+			packVertices = packedVertices;
+		}
+
+		for (auto mesh : meshes)
+		{
+			bytes += mesh->createBuffers(device, packVertices);
+		}
+
+		packedVertices = packVertices;
+		buffersCreated = true;
+
+		return bytes;
+	}
+
+	void ModelResource::deleteBuffers()
+	{
+		if (!buffersCreated)
+		{
+			return;
+		}
+
+		for (auto mesh : meshes)
+		{
+			mesh->deleteBuffers(device);
+		}
+
+		packedVertices = false;
+		buffersCreated = false;
+	}
+
+	size_t ModelResource::getVertexCount() const
 	{
+		size_t count = 0;
+
 		for (auto mesh : meshes)
 		{
-			mesh->createBuffers(device);
+			count += mesh->vertices.size();
+		}
+
+		return count;
+	}
+
+	std::string ModelResource::getCookedPath(const std::string& modelPath)
+	{
+		return modelPath + ".sgemdl";
+	}
+
+	bool ModelResource::cook(const std::string& modelPath, const std::string& cookedPath)
+	{
+		ModelResource model(modelPath, false);
+
+		if (model.meshes.empty())
+		{
+			std::cout << "Error cooking model " << modelPath << " : no meshes" << std::endl;
+
+			return false;
+		}
+
+		CookedHeader header;
+		std::memcpy(header.magic, COOKED_MAGIC, sizeof(COOKED_MAGIC));
+		header.version = COOKED_VERSION;
+		header.vertexSize = sizeof(Vertex);
+		header.meshCount = static_cast<uint32>(model.meshes.size());
+		header.textureCount = 0;
+		header.pad = 0;
+
+		if (!getSourceStamp(modelPath, header.sourceSize, header.sourceModified))
+		{
+			std::cout << "Error cooking model " << modelPath << " : can't read the file" << std::endl;
+
+			return false;
 		}
+
+		std::vector<CookedMesh> cookedMeshes(model.meshes.size());
+		std::vector<CookedTexture> cookedTextures;
+
+		for (size_t i = 0; i < model.meshes.size(); i++)
+		{
+			Mesh* mesh = model.meshes[i];
+			CookedMesh& cookedMesh = cookedMeshes[i];
+
+			cookedMesh.vertexCount = static_cast<uint32>(mesh->vertices.size());
+			cookedMesh.indexCount = static_cast<uint32>(mesh->indices.size());
+			cookedMesh.firstTexture = static_cast<uint32>(cookedTextures.size());
+			cookedMesh.textureCount = static_cast<uint32>(mesh->textures.size());
+
+			for (int j = 0; j < 3; j++)
+			{
+				cookedMesh.boundsMin[j] = mesh->bounds.min[j];
+				cookedMesh.boundsMax[j] = mesh->bounds.max[j];
+			}
+
+			for (auto& texture : mesh->textures)
+			{
+				CookedTexture cookedTexture;
+
+				if (!copyString(texture.getTypeName(), cookedTexture.typeName, sizeof(cookedTexture.typeName)) ||
+					!copyString(texture.getResourcePath(), cookedTexture.path, sizeof(cookedTexture.path)))
+				{
+					std::cout << "Error cooking model " << modelPath << " : texture path too long" << std::endl;
+
+					return false;
+				}
+
+				cookedTextures.push_back(cookedTexture);
+			}
+		}
+
+		header.textureCount = static_cast<uint32>(cookedTextures.size());
+
+		for (int j = 0; j < 3; j++)
+		{
+			header.boundsMin[j] = model.bounds.min[j];
+			header.boundsMax[j] = model.bounds.max[j];
+		}
+
+		uint64 tableSize = sizeof(header) + cookedMeshes.size() * sizeof(CookedMesh) + cookedTextures.size() * sizeof(CookedTexture);
+		uint64 offset = tableSize;
+
+		for (size_t i = 0; i < model.meshes.size(); i++)
+		{
+			CookedMesh& cookedMesh = cookedMeshes[i];
+
+			cookedMesh.vertexOffset = alignOffset(offset);
+			cookedMesh.indexOffset = alignOffset(cookedMesh.vertexOffset + cookedMesh.vertexCount * sizeof(Vertex));
+			cookedMesh.positionOffset = alignOffset(cookedMesh.indexOffset + cookedMesh.indexCount * sizeof(unsigned int));
+			offset = cookedMesh.positionOffset + cookedMesh.vertexCount * sizeof(math::vec3);
+		}
+
+		header.fileSize = offset;
+
+		std::ofstream file(cookedPath, std::ios::binary);
+
+		if (!file)
+		{
+			std::cout << "Error cooking model " << modelPath << " : can't write " << cookedPath << std::endl;
+
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(cookedMeshes.data()), cookedMeshes.size() * sizeof(CookedMesh));
+
+		if (!cookedTextures.empty())
+		{
+			file.write(reinterpret_cast<const char*>(cookedTextures.data()), cookedTextures.size() * sizeof(CookedTexture));
+		}
+
+		std::vector<math::vec3> positions;
+		const char padding[COOKED_ALIGNMENT] = {};
+		uint64 written = tableSize;
+
+		for (size_t i = 0; i < model.meshes.size(); i++)
+		{
+			const Mesh* mesh = model.meshes[i];
+			const CookedMesh& cookedMesh = cookedMeshes[i];
+
+			positions.clear();
+
+			for (auto& vertex : mesh->vertices)
+			{
+				positions.push_back(vertex.Position);
+			}
+
+			file.write(padding, cookedMesh.vertexOffset - written);
+			file.write(reinterpret_cast<const char*>(mesh->vertices.data()), mesh->vertices.size() * sizeof(Vertex));
+			file.write(padding, cookedMesh.indexOffset - cookedMesh.vertexOffset - mesh->vertices.size() * sizeof(Vertex));
+			file.write(reinterpret_cast<const char*>(mesh->indices.data()), mesh->indices.size() * sizeof(unsigned int));
+			file.write(padding, cookedMesh.positionOffset - cookedMesh.indexOffset - mesh->indices.size() * sizeof(unsigned int));
+			file.write(reinterpret_cast<const char*>(positions.data()), positions.size() * sizeof(math::vec3));
+
+			written = cookedMesh.positionOffset + positions.size() * sizeof(math::vec3);
+		}
+
+		if (!file)
+		{
+			std::cout << "Error cooking model " << modelPath << " : can't write " << cookedPath << std::endl;
+
+			return false;
+		}
+
+		return true;
+	}
+
+	bool ModelResource::loadCooked(const std::string& modelPath, const std::string& cookedPath)
+	{
+		if (!cookedFile.open(cookedPath))
+		{
+			return false;
+		}
+
+		const unsigned char* data = cookedFile.getData();
+		size_t size = cookedFile.getSize();
+		const CookedHeader* header = reinterpret_cast<const CookedHeader*>(data);
+
+		if (size < sizeof(CookedHeader) || std::memcmp(header->magic, COOKED_MAGIC, sizeof(COOKED_MAGIC)) != 0 ||
+			header->version != COOKED_VERSION || header->vertexSize != sizeof(Vertex))
+		{
+			std::cout << "Error loading cooked model " << cookedPath << " : unknown format" << std::endl;
+			cookedFile.close();
+
+			return false;
+		}
+
+		uint64 sourceSize, sourceModified;
+
+		// A model edited after cooking is imported again, without the model the cooked file is all there is.
+		if (getSourceStamp(modelPath, sourceSize, sourceModified) &&
+			(sourceSize != header->sourceSize || sourceModified != header->sourceModified))
+		{
+			std::cout << "Cooked model " << cookedPath << " is out of date, importing " << modelPath << std::endl;
+			cookedFile.close();
+
+			return false;
+		}
+
+		uint64 tableSize = sizeof(CookedHeader) + uint64(header->meshCount) * sizeof(CookedMesh) + uint64(header->textureCount) * sizeof(CookedTexture);
+
+		if (header->fileSize != size || tableSize > size)
+		{
+			std::cout << "Error loading cooked model " << cookedPath << " : truncated file" << std::endl;
+			cookedFile.close();
+
+			return false;
+		}
+
+		const CookedMesh* cookedMeshes = reinterpret_cast<const CookedMesh*>(data + sizeof(CookedHeader));
+		const CookedTexture* cookedTextures = reinterpret_cast<const CookedTexture*>(cookedMeshes + header->meshCount);
+
+		for (uint32 i = 0; i < header->meshCount; i++)
+		{
+			const CookedMesh& cookedMesh = cookedMeshes[i];
+
+			if (cookedMesh.vertexOffset + uint64(cookedMesh.vertexCount) * sizeof(Vertex) > size ||
+				cookedMesh.indexOffset + uint64(cookedMesh.indexCount) * sizeof(unsigned int) > size ||
+				cookedMesh.positionOffset + uint64(cookedMesh.vertexCount) * sizeof(math::vec3) > size ||
+				uint64(cookedMesh.firstTexture) + cookedMesh.textureCount > header->textureCount)
+			{
+				std::cout << "Error loading cooked model " << cookedPath << " : truncated file" << std::endl;
+
+				for (auto mesh : meshes)
+				{
+					delete mesh;
+				}
+
+				meshes.clear();
+				textures_loaded.clear();
+				cookedFile.close();
+
+				return false;
+			}
+
+			std::vector<sge::TextureResource> textures;
+
+			for (uint32 j = 0; j < cookedMesh.textureCount; j++)
+			{
+				const CookedTexture& cookedTexture = cookedTextures[cookedMesh.firstTexture + j];
+				std::string path(cookedTexture.path, strnlen(cookedTexture.path, sizeof(cookedTexture.path)));
+				std::string typeName(cookedTexture.typeName, strnlen(cookedTexture.typeName, sizeof(cookedTexture.typeName)));
+				bool loaded = false;
+
+				// Meshes sharing a texture share its pixels, like the textures of an imported model.
+				for (auto& texture : textures_loaded)
+				{
+					if (texture.getResourcePath() == path && texture.getTypeName() == typeName)
+					{
+						textures.push_back(texture);
+						loaded = true;
+						break;
+					}
+				}
+
+				if (!loaded)
+				{
+					sge::TextureResource texture(path);
+					texture.setTypename(typeName);
+					textures.push_back(texture);
+					textures_loaded.push_back(texture);
+				}
+			}
+
+			// The vertices are handed to the device straight from the mapping.
+			meshes.push_back(new Mesh(reinterpret_cast<const Vertex*>(data + cookedMesh.vertexOffset), cookedMesh.vertexCount,
+				reinterpret_cast<const unsigned int*>(data + cookedMesh.indexOffset), cookedMesh.indexCount,
+				reinterpret_cast<const math::vec3*>(data + cookedMesh.positionOffset),
+				AABB(math::vec3(cookedMesh.boundsMin[0], cookedMesh.boundsMin[1], cookedMesh.boundsMin[2]),
+				math::vec3(cookedMesh.boundsMax[0], cookedMesh.boundsMax[1], cookedMesh.boundsMax[2])), textures));
+		}
+
+		bounds = AABB(math::vec3(header->boundsMin[0], header->boundsMin[1], header->boundsMin[2]),
+			math::vec3(header->boundsMax[0], header->boundsMax[1], header->boundsMax[2]));
+
+		return true;
 	}
 
 	/*  Functions   */
@@ -55,6 +522,7 @@ namespace sge
 			// The scene contains all the data, node is just to keep stuff organized (like relations between nodes).
 			aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
 			this->meshes.push_back(this->processMesh(mesh, scene));
+			this->bounds.expand(this->meshes.back()->bounds);
 		}
 		// After we've processed all of the meshes (if any) we then recursively process each of the children nodes
 		for (unsigned int i = 0; i < node->mNumChildren; i++)
@@ -71,6 +539,9 @@ namespace sge
 		std::vector<unsigned int> indices;
 		std::vector<sge::TextureResource> textures;
 
+		vertices.reserve(mesh->mNumVertices);
+		indices.reserve(mesh->mNumFaces * 3);
+
 		// Walk through each of the mesh's vertices
 		for (unsigned int i = 0; i < mesh->mNumVertices; i++)
 		{
@@ -129,7 +600,7 @@ namespace sge
 		}
 
 		// Return a mesh object created from the extracted mesh data
-		return new Mesh(vertices, indices, textures);
+		return new Mesh(std::move(vertices), std::move(indices), std::move(textures));
 	}
 
 	std::vector<sge::TextureResource> ModelResource::loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName)
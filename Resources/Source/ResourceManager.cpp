@@ -2,29 +2,352 @@
 
 namespace sge
 {
-	ResourceManager::ResourceManager()
+	namespace
 	{
+		// Files are mostly waiting on the disk or the decoder, a couple of threads keep both busy.
+		const size_t DEFAULT_LOAD_THREADS = 2;
+	}
+
+	ResourceManager::ResourceManager() : pendingLoads(0), loadThreads(DEFAULT_LOAD_THREADS), stopLoads(false), nextUnloadCallback(1)
+	{
+		for (auto& block : entryBlocks)
+		{
+			block.store(nullptr, std::memory_order_relaxed);
+		}
 	}
 
 	ResourceManager::~ResourceManager()
 	{
+		stopLoadThreads();
+
+		// Loads never published, only the finished ones have created their resource.
+		for (auto& load : finishedLoads)
+		{
+			delete load.resource;
+		}
+
+		queuedLoads.clear();
+		finishedLoads.clear();
+
+		for (auto resource : expiredResources)
+		{
+			delete resource;
+		}
+
+		for (auto resource : retiredResources)
+		{
+			delete resource;
+		}
+
+		// The resources still resident at shutdown.
+		releaseAll();
+
+		for (auto& block : entryBlocks)
+		{
+			delete[] block.load(std::memory_order_relaxed);
+		}
+	}
+
+	void ResourceManager::update()
+	{
+		std::vector<Resource*> deletedResources;
+
+		{
+			std::lock_guard<std::mutex> lock(loadMutex);
+
+			publishedLoads.swap(finishedLoads);
+
+			// A whole update has passed since these were unloaded, no other thread is still reading them.
+			deletedResources.swap(expiredResources);
+			expiredResources.swap(retiredResources);
+		}
+
+		for (auto resource : deletedResources)
+		{
+			for (auto& callback : unloadCallbacks)
+			{
+				callback.second(resource);
+			}
+
+			delete resource;
+		}
+
+		for (auto& load : publishedLoads)
+		{
+			publish(load);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(loadMutex);
+
+			pendingLoads -= publishedLoads.size();
+		}
+
+		publishedLoads.clear();
+
+		// Swapped out first, the callbacks may load resources that are already resident.
+		std::vector<std::function<void()>> callbacks;
+		callbacks.swap(readyCallbacks);
+
+		for (auto& callback : callbacks)
+		{
+			callback();
+		}
+	}
+
+	void ResourceManager::publish(AsyncLoad& load)
+	{
+		Slot& slot = slots[load.index];
+
+		// Loading slots are never unloaded, so the slot is still the one the load was made for.
+		SGE_ASSERT(slot.magic == load.magic && slot.state == LoadState::LOADING);
+
+		slot.resource = load.resource;
+		slot.resource->references = slot.references;
+		slot.state = slot.resource->isLoaded() ? LoadState::READY : LoadState::FAILED;
+		setEntry(load.index);
+
+		readyCallbacks.insert(readyCallbacks.end(), slot.callbacks.begin(), slot.callbacks.end());
+		slot.callbacks.clear();
+	}
+
+	void ResourceManager::setEntry(unsigned int index)
+	{
+		SGE_ASSERT(index < ENTRY_BLOCKS * ENTRY_BLOCK_SIZE);
+
+		// Only this thread writes the table, so the block can't be allocated by anyone else meanwhile.
+		Entry* block = entryBlocks[index / ENTRY_BLOCK_SIZE].load(std::memory_order_relaxed);
+
+		if (!block)
+		{
+			block = new Entry[ENTRY_BLOCK_SIZE];
+
+			for (size_t i = 0; i < ENTRY_BLOCK_SIZE; i++)
+			{
+				block[i].magic.store(0, std::memory_order_relaxed);
+				block[i].resource.store(nullptr, std::memory_order_relaxed);
+			}
+
+			entryBlocks[index / ENTRY_BLOCK_SIZE].store(block, std::memory_order_release);
+		}
+
+		const Slot& slot = slots[index];
+		Entry& entry = block[index % ENTRY_BLOCK_SIZE];
+
+		if (entry.magic.load(std::memory_order_relaxed) == slot.magic)
+		{
+			entry.resource.store(slot.resource, std::memory_order_release);
+
+			return;
+		}
+
+		// Readers holding the old magic see it cleared before the resource changes.
+		entry.magic.store(0, std::memory_order_release);
+		entry.resource.store(slot.resource, std::memory_order_release);
+		entry.magic.store(slot.magic, std::memory_order_release);
+	}
+
+	void ResourceManager::finishLoad(unsigned int index)
+	{
+		std::unique_lock<std::mutex> lock(loadMutex);
+
+		while (true)
+		{
+			for (auto it = finishedLoads.begin(); it != finishedLoads.end(); ++it)
+			{
+				if (it->index == index)
+				{
+					AsyncLoad load = *it;
+					finishedLoads.erase(it);
+					pendingLoads--;
+
+					lock.unlock();
+					publish(load);
+
+					return;
+				}
+			}
+
+			// Not started yet, so it is loaded right here instead of waiting for a worker.
+			for (auto it = queuedLoads.begin(); it != queuedLoads.end(); ++it)
+			{
+				if (it->index == index)
+				{
+					AsyncLoad load = *it;
+					queuedLoads.erase(it);
+					pendingLoads--;
+
+					lock.unlock();
+					load.resource = load.create(load.path);
+					publish(load);
+
+					return;
+				}
+			}
+
+			finishedCondition.wait(lock);
+		}
+	}
+
+	size_t ResourceManager::getPendingLoads()
+	{
+		std::lock_guard<std::mutex> lock(loadMutex);
+
+		return pendingLoads;
+	}
+
+	bool ResourceManager::hasFinishedLoads()
+	{
+		std::lock_guard<std::mutex> lock(loadMutex);
+
+		return !finishedLoads.empty() || !readyCallbacks.empty() || !retiredResources.empty() || !expiredResources.empty();
+	}
+
+	void ResourceManager::setLoadThreads(size_t count)
+	{
+		SGE_ASSERT(count > 0);
+
+		// The workers finish their current file, the queued loads go on with the new workers.
+		stopLoadThreads();
+		loadThreads = count;
+		startLoadThreads();
+	}
+
+	void ResourceManager::startLoadThreads()
+	{
+		std::lock_guard<std::mutex> lock(loadMutex);
+
+		if (queuedLoads.empty())
+		{
+			return;
+		}
+
+		stopLoads = false;
+
+		while (loadWorkers.size() < loadThreads)
+		{
+			loadWorkers.push_back(std::thread(&ResourceManager::runLoads, this));
+		}
+	}
+
+	void ResourceManager::stopLoadThreads()
+	{
+		{
+			std::lock_guard<std::mutex> lock(loadMutex);
+
+			stopLoads = true;
+		}
+
+		loadCondition.notify_all();
+
+		for (auto& worker : loadWorkers)
+		{
+			worker.join();
+		}
+
+		loadWorkers.clear();
+	}
+
+	void ResourceManager::runLoads()
+	{
+		std::unique_lock<std::mutex> lock(loadMutex);
+
+		while (true)
+		{
+			loadCondition.wait(lock, [this]() { return !queuedLoads.empty() || stopLoads; });
+
+			if (stopLoads)
+			{
+				break;
+			}
+
+			AsyncLoad load = queuedLoads.front();
+			queuedLoads.pop_front();
+
+			lock.unlock();
+			load.resource = load.create(load.path);
+			lock.lock();
+
+			finishedLoads.push_back(load);
+			finishedCondition.notify_all();
+		}
 	}
 
 	void ResourceManager::printResources()
 	{
-		for (auto resource : userData)
+		for (auto& slot : slots)
 		{
-			std::cout << resource.first << ": "
-				<< resource.second->getReferenceCount() << " references" << std::endl;
+			if (slot.magic)
+			{
+				std::cout << slot.path << ": " << slot.references << " references" << std::endl;
+			}
 		}
 	}
 
+	size_t ResourceManager::unloadUnused()
+	{
+		std::vector<Resource*> unloadedResources;
+
+		for (unsigned int index = 0; index < slots.size(); index++)
+		{
+			Slot& slot = slots[index];
+
+			// A running load is unloaded by a later call, once it is published.
+			if (!slot.magic || slot.references > 0 || slot.state == LoadState::LOADING)
+			{
+				continue;
+			}
+
+			// Cleared from the table before it is retired, so other threads can't resolve it anymore.
+			unloadedResources.push_back(slot.resource);
+			pathIds.erase(slot.path);
+
+			slot.path.clear();
+			slot.resource = nullptr;
+			slot.magic = 0;
+			setEntry(index);
+
+			// Handles to the old path keep failing once the slot holds another one.
+			if (++slot.generation > MAX_MAGIC)
+			{
+				slot.generation = 1;
+			}
+
+			freeSlots.push_back(index);
+		}
+
+		std::lock_guard<std::mutex> lock(loadMutex);
+
+		retiredResources.insert(retiredResources.end(), unloadedResources.begin(), unloadedResources.end());
+
+		return unloadedResources.size();
+	}
+
+	size_t ResourceManager::addUnloadCallback(std::function<void(Resource*)> callback)
+	{
+		size_t id = nextUnloadCallback++;
+		unloadCallbacks[id] = callback;
+
+		return id;
+	}
+
+	void ResourceManager::removeUnloadCallback(size_t id)
+	{
+		unloadCallbacks.erase(id);
+	}
+
 	void ResourceManager::releaseAll()
 	{
-		for (auto resource : userData)
+		for (auto& slot : slots)
 		{
-			resource.second->~Resource();
-			std::cout << resource.first << "released." << std::endl;
+			if (slot.resource)
+			{
+				Resource* resource = slot.resource;
+				slot.resource = nullptr;
+				setEntry(static_cast<unsigned int>(&slot - slots.data()));
+				delete resource;
+				std::cout << slot.path << " released." << std::endl;
+			}
 		}
 	}
 }
\ No newline at end of file
@@ -1,9 +1,50 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
 #include "Resources/TextureResource.h"
+#include "Resources/BlockCompression.h"
+
+#include "Core/Assert.h"
 
 namespace sge
 {
-	TextureResource::TextureResource(const std::string& resourcePath) : sge::Resource(resourcePath)
+	namespace
+	{
+		const char COOKED_MAGIC[4] = { 'S', 'G', 'E', 'T' };
+		const uint32 COOKED_VERSION = 1;
+
+		// Followed by the size of each level and then the levels back to back, largest first.
+		struct CookedHeader
+		{
+			char magic[4];
+			uint32 version;
+			uint32 format;
+			uint32 width;
+			uint32 height;
+			uint32 levels;
+			uint32 flipped;
+		};
+
+		// The rows are stored in the order the backend samples them, the same as the decoded images.
+		uint32 getFlipped()
+		{
+#ifdef OPENGL4
+			return 1;
+#else
+			return 0;
+#endif
+		}
+	}
+
+	TextureResource::TextureResource(const std::string& resourcePath) : sge::Resource(resourcePath),
+		width(0), height(0), format(0), data(nullptr), pixelFormat(Format::RGBA)
 	{
+		if (loadCooked(getCookedPath(resourcePath)))
+		{
+			return;
+		}
+
 #ifdef OPENGL4
         // Flips texture rows for opengl.
         stbi_set_flip_vertically_on_load(true);
@@ -50,4 +91,200 @@ namespace sge
     {
         return format;
     }
+
+	bool TextureResource::isLoaded()
+	{
+		return data != nullptr;
+	}
+
+	Format TextureResource::getPixelFormat()
+	{
+		return pixelFormat;
+	}
+
+	bool TextureResource::isCooked()
+	{
+		return !levelSizes.empty();
+	}
+
+	size_t TextureResource::getLevels()
+	{
+		return levelSizes.empty() ? 1 : levelSizes.size();
+	}
+
+	unsigned char* TextureResource::getLevelData(size_t level)
+	{
+		return levelOffsets.empty() ? data : data + levelOffsets[level];
+	}
+
+	size_t TextureResource::getLevelSize(size_t level)
+	{
+		return levelSizes.empty() ? getImageSize(Format::RGBA, width, height) : levelSizes[level];
+	}
+
+	std::string TextureResource::getCookedPath(const std::string& imagePath)
+	{
+		return imagePath + ".sgetex";
+	}
+
+	bool TextureResource::cook(const std::string& imagePath, const std::string& cookedPath, Format format)
+	{
+		SGE_ASSERT(format == Format::RGBA || format == Format::BC1 || format == Format::BC3 || format == Format::BC5);
+
+#ifdef OPENGL4
+		stbi_set_flip_vertically_on_load(true);
+#endif
+		int width, height, components;
+		unsigned char* pixels = stbi_load(imagePath.c_str(), &width, &height, &components, STBI_rgb_alpha);
+
+		if (!pixels)
+		{
+			std::cout << "Error cooking texture " << imagePath << " : " << stbi_failure_reason() << std::endl;
+
+			return false;
+		}
+
+		std::ofstream file(cookedPath, std::ios::binary);
+
+		if (!file)
+		{
+			std::cout << "Error cooking texture " << imagePath << " : can't write " << cookedPath << std::endl;
+			stbi_image_free(pixels);
+
+			return false;
+		}
+
+		CookedHeader header;
+		std::memcpy(header.magic, COOKED_MAGIC, sizeof(COOKED_MAGIC));
+		header.version = COOKED_VERSION;
+		header.format = static_cast<uint32>(format);
+		header.width = width;
+		header.height = height;
+		header.levels = 1;
+		header.flipped = getFlipped();
+
+		std::vector<uint32> sizes(1, static_cast<uint32>(getImageSize(format, width, height)));
+
+		for (size_t w = width, h = height; w > 1 || h > 1; header.levels++)
+		{
+			w = w > 1 ? w / 2 : 1;
+			h = h > 1 ? h / 2 : 1;
+			sizes.push_back(static_cast<uint32>(getImageSize(format, w, h)));
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(sizes.data()), sizes.size() * sizeof(uint32));
+
+		// Each level is filtered from the previous uncompressed one, not from the compressed blocks.
+		std::vector<unsigned char> level(pixels, pixels + getImageSize(Format::RGBA, width, height));
+		std::vector<unsigned char> next;
+		std::vector<unsigned char> blocks;
+		size_t levelWidth = width;
+		size_t levelHeight = height;
+
+		stbi_image_free(pixels);
+
+		for (uint32 i = 0; i < header.levels; i++)
+		{
+			if (format == Format::RGBA)
+			{
+				file.write(reinterpret_cast<const char*>(level.data()), level.size());
+			}
+			else
+			{
+				blocks.resize(sizes[i]);
+				compressImage(format, level.data(), levelWidth, levelHeight, blocks.data());
+				file.write(reinterpret_cast<const char*>(blocks.data()), blocks.size());
+			}
+
+			if (i + 1 < header.levels)
+			{
+				next.resize(getImageSize(Format::RGBA, levelWidth > 1 ? levelWidth / 2 : 1, levelHeight > 1 ? levelHeight / 2 : 1));
+				downsampleImage(level.data(), levelWidth, levelHeight, next.data());
+				level.swap(next);
+
+				levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+				levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+			}
+		}
+
+		if (!file)
+		{
+			std::cout << "Error cooking texture " << imagePath << " : can't write " << cookedPath << std::endl;
+
+			return false;
+		}
+
+		return true;
+	}
+
+	bool TextureResource::loadCooked(const std::string& cookedPath)
+	{
+		std::ifstream file(cookedPath, std::ios::binary);
+
+		if (!file)
+		{
+			return false;
+		}
+
+		CookedHeader header;
+
+		if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+			std::memcmp(header.magic, COOKED_MAGIC, sizeof(COOKED_MAGIC)) != 0 ||
+			header.version != COOKED_VERSION || header.levels == 0 ||
+			(header.format != static_cast<uint32>(Format::RGBA) && header.format != static_cast<uint32>(Format::BC1) &&
+			header.format != static_cast<uint32>(Format::BC3) && header.format != static_cast<uint32>(Format::BC5)))
+		{
+			std::cout << "Error loading cooked texture " << cookedPath << " : unknown format" << std::endl;
+
+			return false;
+		}
+
+		if (header.flipped != getFlipped())
+		{
+			std::cout << "Error loading cooked texture " << cookedPath << " : cooked for another renderer" << std::endl;
+
+			return false;
+		}
+
+		std::vector<uint32> sizes(header.levels);
+
+		if (!file.read(reinterpret_cast<char*>(sizes.data()), sizes.size() * sizeof(uint32)))
+		{
+			std::cout << "Error loading cooked texture " << cookedPath << " : truncated file" << std::endl;
+
+			return false;
+		}
+
+		size_t total = 0;
+
+		for (uint32 size : sizes)
+		{
+			levelOffsets.push_back(total);
+			levelSizes.push_back(size);
+			total += size;
+		}
+
+		// Allocated like the stb_image pixels so both kinds of data are owned the same way.
+		data = static_cast<unsigned char*>(std::malloc(total));
+
+		if (!file.read(reinterpret_cast<char*>(data), total))
+		{
+			std::cout << "Error loading cooked texture " << cookedPath << " : truncated file" << std::endl;
+
+			std::free(data);
+			data = nullptr;
+			levelOffsets.clear();
+			levelSizes.clear();
+
+			return false;
+		}
+
+		width = header.width;
+		height = header.height;
+		pixelFormat = static_cast<Format>(header.format);
+		format = pixelFormat == Format::BC1 ? 3 : pixelFormat == Format::BC5 ? 2 : 4;
+
+		return true;
+	}
 }
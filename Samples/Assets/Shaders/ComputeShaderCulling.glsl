@@ -0,0 +1,84 @@
+#version 440 core
+
+// RenderSystem dispatches one invocation per draw and camera.
+layout(local_size_x = 64) in;
+
+struct DrawData
+{
+	mat4 M;
+	vec4 positionScale;
+	vec4 positionOffset;
+};
+
+struct DrawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint first;
+	uint baseInstance;
+};
+
+// Local space bounds of the mesh drawn by the command.
+struct CullInstance
+{
+	vec4 center;
+	vec4 extents;
+	DrawCommand command;
+};
+
+layout(binding = 4, std430) readonly buffer DrawDataBuffer
+{
+	DrawData draws[];
+};
+
+layout(binding = 5, std430) readonly buffer CullInstanceBuffer
+{
+	CullInstance instances[];
+};
+
+// Six planes per camera, normals pointing inwards.
+layout(binding = 6, std430) readonly buffer FrustumBuffer
+{
+	vec4 planes[];
+};
+
+layout(binding = 7, std430) writeonly buffer CommandBuffer
+{
+	DrawCommand commands[];
+};
+
+void main()
+{
+	uint instanceCount = uint(instances.length());
+	uint id = gl_GlobalInvocationID.x;
+
+	if (id >= instanceCount * uint(planes.length() / 6))
+	{
+		return;
+	}
+
+	uint camera = id / instanceCount;
+	CullInstance instance = instances[id % instanceCount];
+	mat4 M = draws[instance.command.baseInstance].M;
+
+	// Box around the transformed bounds, as AABB::transform does.
+	vec3 center = (M * vec4(instance.center.xyz, 1.0)).xyz;
+	vec3 extents = abs(M[0].xyz) * instance.extents.x + abs(M[1].xyz) * instance.extents.y + abs(M[2].xyz) * instance.extents.z;
+
+	bool visible = true;
+
+	for (uint i = 0; i < 6; i++)
+	{
+		vec4 plane = planes[camera * 6 + i];
+
+		if (dot(plane.xyz, center) + plane.w < -dot(abs(plane.xyz), extents))
+		{
+			visible = false;
+		}
+	}
+
+	// Culled draws keep their slot, the draw count of the multi-draw call is fixed.
+	DrawCommand command = instance.command;
+	command.instanceCount = visible ? 1u : 0u;
+	commands[id] = command;
+}
@@ -0,0 +1,22 @@
+#version 440 core
+
+layout(location = 0) out vec4 outColor;
+
+layout(binding = 0) uniform sampler2D lightTex;
+layout(binding = 1) uniform sampler2D depthTex;
+
+// Writes the lit G-buffer over the render target and restores its depth,
+// so geometry drawn forward afterwards is still occluded.
+void main()
+{
+	ivec2 coord = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(depthTex, coord, 0).r;
+	
+	if(depth <= 0.0)
+	{
+		discard;
+	}
+	
+	gl_FragDepth = depth;
+	outColor = vec4(texelFetch(lightTex, coord, 0).rgb, 1.0);
+}
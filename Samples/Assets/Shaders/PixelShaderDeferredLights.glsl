@@ -0,0 +1,135 @@
+#version 440 core
+
+layout(location = 0) out vec4 outColor;
+
+layout(binding = 0) uniform sampler2D albedoTex;
+layout(binding = 1) uniform sampler2D normalTex;
+layout(binding = 2) uniform sampler2D materialTex;
+layout(binding = 3) uniform sampler2D depthTex;
+
+struct DirLight
+{
+	vec4 direction;
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular;
+};
+
+struct PointLight
+{
+	vec4 position;
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular;
+	
+	float constant;
+	float mylinear;
+	float quadratic;
+	float pad2;
+};
+
+layout(binding = 1, std140) uniform pixelUniform
+{
+	mat4 inverseViewProj;
+	vec4 viewport;		// x, y, width, height in pixels
+	vec4 viewPos;
+	vec4 viewDepth;		// dot(viewDepth, worldPosition) is the view space depth
+	vec4 clusterTile;	// viewport origin and tile size in pixels
+	vec4 clusterDepth;	// slice scale, slice bias, 1 for logarithmic slices
+	ivec4 clusterGrid;	// cluster counts and the first cluster of this camera
+	float numofdl;
+};
+
+layout(binding = 0, std430) readonly buffer DirLightBuffer
+{
+	DirLight dirLight[];
+};
+
+layout(binding = 1, std430) readonly buffer PointLightBuffer
+{
+	PointLight pointLights[];
+};
+
+layout(binding = 2, std430) readonly buffer ClusterBuffer
+{
+	uvec2 clusters[];
+};
+
+layout(binding = 3, std430) readonly buffer LightIndexBuffer
+{
+	uint lightIndices[];
+};
+
+vec3 albedo;
+vec3 specularColor;
+float shininess;
+vec3 position;
+
+vec3 CalculateLight(vec3 lightDir, vec4 ambient, vec4 diffuse, vec4 specular, vec3 normal, vec3 viewDir);
+uvec2 FindCluster(float depth);
+
+void main()
+{
+	ivec2 coord = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(depthTex, coord, 0).r;
+	
+	// Nothing was drawn here.
+	if(depth <= 0.0)
+	{
+		outColor = vec4(0.0, 0.0, 0.0, 1.0);
+		return;
+	}
+	
+	vec4 normalShininess = texelFetch(normalTex, coord, 0);
+	albedo = texelFetch(albedoTex, coord, 0).rgb;
+	specularColor = texelFetch(materialTex, coord, 0).rgb;
+	shininess = normalShininess.w;
+	
+	vec2 ndc = (gl_FragCoord.xy - viewport.xy) / viewport.zw * 2.0 - 1.0;
+	vec4 world = inverseViewProj * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+	position = world.xyz / world.w;
+	
+	vec3 normal = normalize(normalShininess.xyz);
+	vec3 viewDir = normalize(viewPos.xyz - position);
+	vec3 result = vec3(0.0);
+	
+	for(int i = 0; i < int(numofdl); i++)
+		result += CalculateLight(normalize(-dirLight[i].direction.xyz), dirLight[i].ambient, dirLight[i].diffuse, dirLight[i].specular, normal, viewDir);
+	
+	uvec2 cluster = FindCluster(dot(viewDepth, vec4(position, 1.0)));
+	
+	for(uint i = 0; i < cluster.y; i++)
+	{
+		PointLight light = pointLights[lightIndices[cluster.x + i]];
+		
+		float distance = length(light.position.xyz - position);
+		float attenuation = 1.0 / (light.constant + light.mylinear * distance + light.quadratic * (distance * distance));
+		
+		result += attenuation * CalculateLight(normalize(light.position.xyz - position), light.ambient, light.diffuse, light.specular, normal, viewDir);
+	}
+	
+	outColor = vec4(result, 1.0);
+}
+
+// Blinn-Phong, matches PixelShaderLights.glsl.
+vec3 CalculateLight(vec3 lightDir, vec4 ambient, vec4 diffuse, vec4 specular, vec3 normal, vec3 viewDir)
+{
+	float diff = max(dot(normal, lightDir), 0.0);
+	
+	vec3 halfDir = normalize(lightDir + viewDir);
+	float spec = pow(max(dot(halfDir, normal), 0.0), shininess);
+	
+	return ambient.xyz * albedo + diffuse.xyz * diff * albedo + specular.xyz * spec * specularColor;
+}
+
+uvec2 FindCluster(float depth)
+{
+	float slice = clusterDepth.z > 0.5 ? log(max(depth, 1e-5)) : depth;
+	
+	ivec3 cell;
+	cell.xy = ivec2((gl_FragCoord.xy - clusterTile.xy) / clusterTile.zw);
+	cell.z = int(floor(slice * clusterDepth.x + clusterDepth.y));
+	cell = clamp(cell, ivec3(0), clusterGrid.xyz - 1);
+	
+	return clusters[clusterGrid.w + (cell.z * clusterGrid.y + cell.y) * clusterGrid.x + cell.x];
+}
@@ -0,0 +1,6 @@
+#version 440 core
+
+// Depth only pass, the color writes are masked off.
+void main()
+{
+}
@@ -0,0 +1,65 @@
+#version 440 core
+
+in vec2 texcoords;
+in vec3 normals;
+in vec3 fragPosition;
+in mat3 TBNVout;
+in float shininessVout;
+
+layout(location = 0) out vec4 outAlbedo;
+layout(location = 1) out vec4 outNormal;
+layout(location = 2) out vec4 outMaterial;
+layout(location = 3) out vec4 outDepth;
+
+// Compiled with the material feature defines of PixelShaderLights.glsl, the cube map isn't used here.
+#ifdef HAS_TEXTURE_ARRAYS
+// The textures are layers of arrays, the material table has the diffuse, normal and specular layer of every mesh.
+flat in int materialVout;
+
+layout(binding = 0) uniform sampler2DArray diffuseTex;
+layout(binding = 1) uniform sampler2DArray normalTex;
+layout(binding = 2) uniform sampler2DArray specularTex;
+
+layout(binding = 4, std430) readonly buffer MaterialBuffer
+{
+	ivec4 materials[];
+};
+
+#define DIFFUSE_COORDS vec3(texcoords, materials[materialVout].x)
+#define NORMAL_COORDS vec3(texcoords, materials[materialVout].y)
+#define SPECULAR_COORDS vec3(texcoords, materials[materialVout].z)
+#else
+layout(binding = 0) uniform sampler2D diffuseTex;
+layout(binding = 1) uniform sampler2D normalTex;
+layout(binding = 2) uniform sampler2D specularTex;
+
+#define DIFFUSE_COORDS texcoords
+#define NORMAL_COORDS texcoords
+#define SPECULAR_COORDS texcoords
+#endif
+
+void main()
+{
+	// TBNVout goes from world to tangent space, its transpose goes back.
+#ifdef HAS_NORMAL_TEX
+	vec3 normal = texture(normalTex, NORMAL_COORDS).rgb * 2.0 - 1.0;
+	normal = normalize(transpose(TBNVout) * normal);
+#else
+	vec3 normal = normalize(normals);
+#endif
+	
+#ifdef HAS_SPECULAR_TEX
+	vec3 specular = texture(specularTex, SPECULAR_COORDS).rgb;
+#else
+	vec3 specular = vec3(1.0);
+#endif
+	
+#ifdef HAS_DIFFUSE_TEX
+	outAlbedo = vec4(texture(diffuseTex, DIFFUSE_COORDS).rgb, 1.0);
+#else
+	outAlbedo = vec4(1.0);
+#endif
+	outNormal = vec4(normal, shininessVout);
+	outMaterial = vec4(specular, 1.0);
+	outDepth = vec4(gl_FragCoord.z, 0.0, 0.0, 1.0);
+}
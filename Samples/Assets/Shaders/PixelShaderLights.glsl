@@ -9,14 +9,34 @@ in float shininessVout;
 
 layout(location = 0) out vec4 outColor;
 
+// Material features are compiled in as HAS_DIFFUSE_TEX, HAS_NORMAL_TEX, HAS_SPECULAR_TEX, HAS_CUBE_TEX and
+// HAS_TEXTURE_ARRAYS, the renderer picks the variant matching the textures of the mesh.
+#ifdef HAS_TEXTURE_ARRAYS
+// The textures are layers of arrays, the material table has the diffuse, normal and specular layer of every mesh.
+flat in int materialVout;
+
+layout(binding = 0) uniform sampler2DArray diffuseTex;
+layout(binding = 1) uniform sampler2DArray normalTex;
+layout(binding = 2) uniform sampler2DArray specularTex;
+
+layout(binding = 4, std430) readonly buffer MaterialBuffer
+{
+	ivec4 materials[];
+};
+
+#define DIFFUSE_COORDS vec3(texcoords, materials[materialVout].x)
+#define NORMAL_COORDS vec3(texcoords, materials[materialVout].y)
+#define SPECULAR_COORDS vec3(texcoords, materials[materialVout].z)
+#else
 layout(binding = 0) uniform sampler2D diffuseTex;
 layout(binding = 1) uniform sampler2D normalTex;
 layout(binding = 2) uniform sampler2D specularTex;
-layout(binding = 3) uniform samplerCube cubeTex;
 
-#define NUM_POINT_LIGHTS 40
-#define NUM_DIR_LIGHTS 10
-#define NUM_SPOT_LIGHTS 0
+#define DIFFUSE_COORDS texcoords
+#define NORMAL_COORDS texcoords
+#define SPECULAR_COORDS texcoords
+#endif
+layout(binding = 3) uniform samplerCube cubeTex;
 
 struct DirLight
 {
@@ -42,44 +62,59 @@ struct PointLight
 
 layout(binding = 1, std140) uniform pixelUniform
 {
-	DirLight dirLight[NUM_DIR_LIGHTS];
-	PointLight pointLights[NUM_POINT_LIGHTS];
 	vec4 viewPos;
-	float numofpl;
+	vec4 viewDepth;		// dot(viewDepth, worldPosition) is the view space depth
+	vec4 clusterTile;	// viewport origin and tile size in pixels
+	vec4 clusterDepth;	// slice scale, slice bias, 1 for logarithmic slices
+	ivec4 clusterGrid;	// cluster counts and the first cluster of this camera
 	float numofdl;
-	float numofsl;
 	float glossyness;
-	int hasDiffuseTex;
-	int hasNormalTex;
-	int hasSpecularTex;
-	int hasCubeTex;
-	float pad;
+};
+
+layout(binding = 0, std430) readonly buffer DirLightBuffer
+{
+	DirLight dirLight[];
+};
+
+layout(binding = 1, std430) readonly buffer PointLightBuffer
+{
+	PointLight pointLights[];
+};
+
+// Offset and count into lightIndices for every cluster.
+layout(binding = 2, std430) readonly buffer ClusterBuffer
+{
+	uvec2 clusters[];
+};
+
+layout(binding = 3, std430) readonly buffer LightIndexBuffer
+{
+	uint lightIndices[];
 };
 
 vec3 CalculateDirectionLight(DirLight light, vec3 normal, vec3 viewDir);
 vec3 CalculatePointLight(PointLight light, vec3 normal, vec3 viewDir);
+vec3 Albedo();
+vec3 Specular();
+uvec2 FindCluster();
 
 void main()		
 {
 	int dl = int(numofdl);
-	int pl = int(numofpl);
+	uvec2 cluster = FindCluster();
 	
 	vec3 normal = vec3(0.0);
 	vec3 viewDir= vec3(0.0);
 	//normal texture
-	if(hasNormalTex == 1)
-	{
-		normal = normalize(normals);
-		normal = texture(normalTex, texcoords).rgb;
-		normal = normalize(normal * 2.0 - 1.0);
-		
-		viewDir = TBNVout * normalize(viewPos.xyz - fragPosition);
-	}
-	else
-	{
-		normal = normalize(normals);
-		viewDir = normalize(viewPos.xyz - fragPosition);
-	}	
+#ifdef HAS_NORMAL_TEX
+	normal = texture(normalTex, NORMAL_COORDS).rgb;
+	normal = normalize(normal * 2.0 - 1.0);
+	
+	viewDir = TBNVout * normalize(viewPos.xyz - fragPosition);
+#else
+	normal = normalize(normals);
+	viewDir = normalize(viewPos.xyz - fragPosition);
+#endif
 	
     vec3 result = vec3(0.0);
 	
@@ -87,51 +122,50 @@ void main()
 	for(int i = 0; i < dl; i++)
 		result += CalculateDirectionLight(dirLight[i], normal, viewDir);
 	
-	for(int i = 0; i < pl; i++)
-		result += CalculatePointLight(pointLights[i], normal, viewDir);
+	for(uint i = 0; i < cluster.y; i++)
+		result += CalculatePointLight(pointLights[lightIndices[cluster.x + i]], normal, viewDir);
 	
 	//Cubemap TODO: fix
-	vec3 I = vec3(0.0);
-	vec3 R = vec3(0.0);
-	vec4 cubeColor = vec4(0.0);
-	float glossyFactor = 0.0;
-	vec4 glossyColor = vec4(0.0);
-	vec4 resultCube = vec4(0.0);
-	if(hasCubeTex == 1)
-	{
-		I = viewDir;
-		R = reflect(I, normal);
-		cubeColor = texture(cubeTex, R);
-		if(hasSpecularTex == 1)
-		{
-			glossyColor = texture(specularTex, texcoords);
-			glossyFactor = glossyness * glossyColor.x;
-		}
-		else
-		{
-			glossyFactor = glossyness;
-		}		
-		
-		resultCube = (1.0-glossyFactor)* vec4(result, 1.0) + (glossyFactor)*cubeColor;
-		outColor = resultCube;
-	}
-	else
-	{
-		outColor = vec4(result, 1.0);
-	}
+#ifdef HAS_CUBE_TEX
+	vec3 R = reflect(viewDir, normal);
+	vec4 cubeColor = texture(cubeTex, R);
+#ifdef HAS_SPECULAR_TEX
+	float glossyFactor = glossyness * texture(specularTex, SPECULAR_COORDS).x;
+#else
+	float glossyFactor = glossyness;
+#endif
+	
+	outColor = (1.0-glossyFactor)* vec4(result, 1.0) + (glossyFactor)*cubeColor;
+#else
+	outColor = vec4(result, 1.0);
+#endif
+}
+
+vec3 Albedo()
+{
+#ifdef HAS_DIFFUSE_TEX
+	return texture(diffuseTex, DIFFUSE_COORDS).rgb;
+#else
+	return vec3(1.0);
+#endif
+}
+
+vec3 Specular()
+{
+#ifdef HAS_SPECULAR_TEX
+	return texture(specularTex, SPECULAR_COORDS).rgb;
+#else
+	return vec3(1.0);
+#endif
 }
 
 vec3 CalculateDirectionLight(DirLight light, vec3 normal, vec3 viewDir)
 {
-	vec3 lightDir= vec3(0.0);
-	if(hasNormalTex == 1)
-	{
-		lightDir = TBNVout * normalize(-light.direction.xyz);
-	}
-	else
-	{
-		lightDir = normalize(-light.direction.xyz);
-	}
+#ifdef HAS_NORMAL_TEX
+	vec3 lightDir = TBNVout * normalize(-light.direction.xyz);
+#else
+	vec3 lightDir = normalize(-light.direction.xyz);
+#endif
 	// Diffuse shading
 	float diff = max(dot(normal, lightDir), 0.0);
 	
@@ -141,31 +175,19 @@ vec3 CalculateDirectionLight(DirLight light, vec3 normal, vec3 viewDir)
 	float spec = pow(specAngle, shininessVout);
 	
 	// Combine results
-	vec3 ambient = light.ambient.xyz * texture(diffuseTex, texcoords).rgb;
-	vec3 diffuse = light.diffuse.xyz * diff * texture(diffuseTex, texcoords).rgb;
-	vec3 specular = vec3(0.0);
-	if(hasSpecularTex == 1)
-	{	
-		specular = light.specular.xyz * spec * texture(specularTex, texcoords).rgb;
-	}
-	else
-	{
-		specular = light.specular.xyz * spec;
-	}
+	vec3 ambient = light.ambient.xyz * Albedo();
+	vec3 diffuse = light.diffuse.xyz * diff * Albedo();
+	vec3 specular = light.specular.xyz * spec * Specular();
 	return (ambient + diffuse + specular);
 }
 
 vec3 CalculatePointLight(PointLight light, vec3 normal, vec3 viewDir)
 {
-	vec3 lightDir= vec3(0.0);
-	if(hasNormalTex == 1)
-	{
-		lightDir = TBNVout * normalize(light.position.xyz - fragPosition);
-	}
-	else
-	{
-		lightDir = normalize(light.position.xyz - fragPosition);
-	}
+#ifdef HAS_NORMAL_TEX
+	vec3 lightDir = TBNVout * normalize(light.position.xyz - fragPosition);
+#else
+	vec3 lightDir = normalize(light.position.xyz - fragPosition);
+#endif
 	
 	//Blinn phong specular shading
 	vec3 halfDir = normalize(lightDir + viewDir);
@@ -179,19 +201,24 @@ vec3 CalculatePointLight(PointLight light, vec3 normal, vec3 viewDir)
 	float distance = length(light.position.xyz - fragPosition);
 	float attenuation = 1.0f / (light.constant + light.mylinear * distance + light.quadratic * (distance * distance));
 	// Combine results
-	vec3 ambient = light.ambient.xyz * texture(diffuseTex, texcoords).rgb;
-	vec3 diffuse = light.diffuse.xyz * diff * texture(diffuseTex, texcoords).rgb;
-	vec3 specular = vec3(0.0);
-	if(hasSpecularTex == 1)
-	{
-		specular = light.specular.xyz * spec * texture(specularTex, texcoords).rgb;
-	}
-	else
-	{
-		specular = light.specular.xyz * spec;
-	}
+	vec3 ambient = light.ambient.xyz * Albedo();
+	vec3 diffuse = light.diffuse.xyz * diff * Albedo();
+	vec3 specular = light.specular.xyz * spec * Specular();
 	ambient *= attenuation;
 	diffuse *= attenuation;
 	specular *= attenuation;
 	return (ambient + diffuse + specular);
 }
+
+uvec2 FindCluster()
+{
+	float depth = dot(viewDepth, vec4(fragPosition, 1.0));
+	float slice = clusterDepth.z > 0.5 ? log(max(depth, 1e-5)) : depth;
+	
+	ivec3 cell;
+	cell.xy = ivec2((gl_FragCoord.xy - clusterTile.xy) / clusterTile.zw);
+	cell.z = int(floor(slice * clusterDepth.x + clusterDepth.y));
+	cell = clamp(cell, ivec3(0), clusterGrid.xyz - 1);
+	
+	return clusters[clusterGrid.w + (cell.z * clusterGrid.y + cell.y) * clusterGrid.x + cell.x];
+}
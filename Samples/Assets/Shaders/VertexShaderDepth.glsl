@@ -0,0 +1,22 @@
+#version 440 core
+
+layout(location = 0) in vec3 inPosition;
+
+layout (std140, binding = 0) uniform MVPUniform
+{
+	mat4 PV;
+	mat4 M;
+	float shininess;
+	vec4 positionScale;
+	vec4 positionOffset;
+	int packedVertices;
+};
+
+// Must match VertexShaderLights.glsl exactly, the main pass tests depth for equality.
+invariant gl_Position;
+
+void main()
+{
+	vec3 position = inPosition * positionScale.xyz + positionOffset.xyz;
+	gl_Position = PV * M * vec4(position, 1.0);
+}
@@ -0,0 +1,38 @@
+#version 440 core
+#extension GL_ARB_shader_draw_parameters : require
+
+layout(location = 0) in vec3 inPosition;
+
+layout (std140, binding = 0) uniform MVPUniform
+{
+	mat4 PV;
+	mat4 M;
+	float shininess;
+	vec4 positionScale;
+	vec4 positionOffset;
+	int packedVertices;
+};
+
+// One entry per draw of the multi-draw call, the draw's base instance indexes it.
+struct DrawData
+{
+	mat4 M;
+	vec4 positionScale;
+	vec4 positionOffset;
+};
+
+layout(binding = 4, std430) readonly buffer DrawDataBuffer
+{
+	DrawData draws[];
+};
+
+// Must match VertexShaderLights.glsl exactly, the main pass tests depth for equality.
+invariant gl_Position;
+
+void main()
+{
+	DrawData draw = draws[gl_BaseInstanceARB];
+
+	vec3 position = inPosition * draw.positionScale.xyz + draw.positionOffset.xyz;
+	gl_Position = PV * draw.M * vec4(position, 1.0);
+}
@@ -12,22 +12,60 @@ out vec3 fragPosition;
 out mat3 TBNVout;
 out float shininessVout;
 
+#ifdef HAS_TEXTURE_ARRAYS
+flat out int materialVout;
+#endif
+
 layout (std140, binding = 0) uniform MVPUniform
 {
 	mat4 PV;
 	mat4 M;
 	float shininess;
+	// Identity for float vertices, the mesh bounds for packed ones.
+	vec4 positionScale;
+	vec4 positionOffset;
+	int packedVertices;
+	int material;		// Entry of the mesh in the material table of the texture arrays.
 };
 
+// The depth pre-pass computes the same position in VertexShaderDepth.glsl.
+invariant gl_Position;
+
+// Inverse of the octahedral encoding in ModelResource.cpp.
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+
+	if (n.z < 0.0)
+	{
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	}
+
+	return normalize(n);
+}
+
 void main()
 {
-	gl_Position = PV * M * vec4(inPosition, 1.0);
-	vec3 fragPos = vec3(M * vec4(inPosition, 1.0));
+	vec3 position = inPosition * positionScale.xyz + positionOffset.xyz;
+	vec3 normal = inNormal;
+	vec3 tangent = inTangent;
+	vec3 bitangent = inBitangent;
+
+	// Packed vertices carry two octahedral components each and the sign of the bitangent.
+	if (packedVertices != 0)
+	{
+		normal = decodeOctahedral(inNormal.xy);
+		tangent = decodeOctahedral(inTangent.xy);
+		bitangent = cross(normal, tangent) * (inBitangent.x < 0.0 ? -1.0 : 1.0);
+	}
+
+	gl_Position = PV * M * vec4(position, 1.0);
+	vec3 fragPos = vec3(M * vec4(position, 1.0));
 	texcoords = inTexcoords;
 	mat3 normalMatrix = transpose(inverse(mat3(M)));
-	vec3 T = normalize(normalMatrix * inTangent);
-	vec3 B = normalize(normalMatrix * inBitangent);
-	vec3 N = normalize(normalMatrix * inNormal);
+	vec3 T = normalize(normalMatrix * tangent);
+	vec3 B = normalize(normalMatrix * bitangent);
+	vec3 N = normalize(normalMatrix * normal);
 	
 	mat3 TBN = transpose(mat3(T, B, N));
 	fragPosition = fragPos;
@@ -35,4 +73,7 @@ void main()
 	TBNVout = TBN;
 	normals = N;
 	shininessVout = shininess;
+#ifdef HAS_TEXTURE_ARRAYS
+	materialVout = material;
+#endif
 }
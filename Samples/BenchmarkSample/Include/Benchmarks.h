@@ -0,0 +1,6 @@
+#pragma once
+
+// CPU benchmarks that run without a window or a graphics context.
+// Each benchmark prints its own timings to the standard output.
+
+void runBVHBenchmark();
@@ -0,0 +1,210 @@
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "Benchmarks.h"
+
+#include "Core/Bounds.h"
+#include "Core/Random.h"
+
+#include "Game/BoundsComponent.h"
+#include "Game/ComponentFactory.h"
+#include "Game/EntityManager.h"
+#include "Game/SpatialSystem.h"
+#include "Game/TransformComponent.h"
+
+namespace
+{
+	const size_t OBJECT_COUNT = 100000;
+	const size_t MOVING_COUNT = OBJECT_COUNT / 100;
+	const size_t FRAME_COUNT = 200;
+	const size_t CAMERA_COUNT = 4;
+	const size_t SPHERE_COUNT = 32;
+	const size_t RAY_COUNT = 32;
+	const float WORLD_SIZE = 1000.0f;
+
+	using Clock = std::chrono::high_resolution_clock;
+
+	double milliseconds(Clock::time_point start, Clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	sge::math::vec3 randomPosition()
+	{
+		return sge::math::vec3(
+			sge::random(0.0f, WORLD_SIZE),
+			sge::random(0.0f, WORLD_SIZE * 0.1f),
+			sge::random(0.0f, WORLD_SIZE));
+	}
+
+	sge::math::mat4 cameraViewProj(size_t index, size_t frame)
+	{
+		float angle = 0.01f * frame + index * 1.5f;
+		sge::math::vec3 position(WORLD_SIZE * 0.5f, 20.0f, WORLD_SIZE * 0.5f);
+		sge::math::vec3 front(cos(angle), 0.0f, sin(angle));
+
+		return sge::math::perspective(sge::math::radians(60.0f), 16.0f / 9.0f, 0.1f, 300.0f) *
+			sge::math::lookAt(position, position + front, sge::math::vec3(0.0f, 1.0f, 0.0f));
+	}
+}
+
+void runBVHBenchmark()
+{
+	sge::setSeed(1234);
+
+	sge::EntityManager entityManager;
+	sge::ComponentFactory<sge::TransformComponent> transformFactory;
+	sge::ComponentFactory<sge::BoundsComponent> boundsFactory;
+	sge::SpatialSystem spatialSystem(0.5f);
+
+	std::vector<sge::TransformComponent*> transforms;
+	std::vector<sge::BoundsComponent*> bounds;
+
+	transforms.reserve(OBJECT_COUNT);
+	bounds.reserve(OBJECT_COUNT);
+
+	Clock::time_point start = Clock::now();
+
+	for (size_t i = 0; i < OBJECT_COUNT; i++)
+	{
+		sge::Entity* entity = entityManager.createEntity();
+
+		auto transform = transformFactory.create(entity);
+		transform->setPosition(randomPosition());
+		transform->setScale(sge::math::vec3(sge::random(0.5f, 2.0f)));
+
+		auto component = boundsFactory.create(entity);
+		spatialSystem.addComponent(component);
+
+		transforms.push_back(transform);
+		bounds.push_back(component);
+	}
+
+	Clock::time_point end = Clock::now();
+
+	std::cout << "BVH: inserted " << OBJECT_COUNT << " objects in " << milliseconds(start, end) << " ms, tree height "
+		<< spatialSystem.getTree().getHeight() << std::endl;
+
+	double updateTime = 0.0;
+	double frustumTime = 0.0;
+	double batchedFrustumTime = 0.0;
+	double bruteForceTime = 0.0;
+	double sphereTime = 0.0;
+	double rayTime = 0.0;
+	size_t reinserts = 0;
+	size_t visible = 0;
+	size_t bruteForceVisible = 0;
+
+	std::vector<void*> frustumResults[CAMERA_COUNT];
+	std::vector<void*> sphereResults[SPHERE_COUNT];
+	std::vector<sge::RayHit> rayResults[RAY_COUNT];
+
+	for (size_t frame = 0; frame < FRAME_COUNT; frame++)
+	{
+		// Move 1% of the objects.
+		for (size_t i = 0; i < MOVING_COUNT; i++)
+		{
+			size_t index = sge::random(0, static_cast<int>(OBJECT_COUNT) - 1);
+			sge::math::vec3 velocity(sge::random(-1.0f, 1.0f), sge::random(-0.1f, 0.1f), sge::random(-1.0f, 1.0f));
+
+			transforms[index]->addPosition(velocity);
+		}
+
+		start = Clock::now();
+		spatialSystem.update();
+		end = Clock::now();
+
+		updateTime += milliseconds(start, end);
+		reinserts += spatialSystem.getReinsertCount();
+
+		sge::Frustum frustums[CAMERA_COUNT];
+
+		for (size_t i = 0; i < CAMERA_COUNT; i++)
+		{
+			frustums[i] = sge::Frustum(cameraViewProj(i, frame));
+			frustumResults[i].clear();
+		}
+
+		// One traversal per frustum.
+		start = Clock::now();
+		for (size_t i = 0; i < CAMERA_COUNT; i++)
+		{
+			spatialSystem.getTree().queryFrustum(frustums[i], frustumResults[i]);
+		}
+		end = Clock::now();
+
+		frustumTime += milliseconds(start, end);
+
+		for (size_t i = 0; i < CAMERA_COUNT; i++)
+		{
+			visible += frustumResults[i].size();
+			frustumResults[i].clear();
+		}
+
+		// All frustums in one traversal.
+		start = Clock::now();
+		spatialSystem.getTree().queryFrustums(CAMERA_COUNT, frustums, frustumResults);
+		end = Clock::now();
+
+		batchedFrustumTime += milliseconds(start, end);
+
+		// Linear reference.
+		start = Clock::now();
+		for (size_t i = 0; i < CAMERA_COUNT; i++)
+		{
+			for (auto component : bounds)
+			{
+				if (frustums[i].intersects(component->getWorldBounds()))
+				{
+					bruteForceVisible++;
+				}
+			}
+		}
+		end = Clock::now();
+
+		bruteForceTime += milliseconds(start, end);
+
+		sge::Sphere spheres[SPHERE_COUNT];
+		sge::Ray rays[RAY_COUNT];
+
+		for (size_t i = 0; i < SPHERE_COUNT; i++)
+		{
+			spheres[i] = { randomPosition(), 10.0f };
+			sphereResults[i].clear();
+		}
+
+		for (size_t i = 0; i < RAY_COUNT; i++)
+		{
+			sge::math::vec3 direction(sge::random(-1.0f, 1.0f), sge::random(-0.2f, 0.2f), sge::random(-1.0f, 1.0f));
+
+			rays[i] = { randomPosition(), sge::math::normalize(direction), 200.0f };
+			rayResults[i].clear();
+		}
+
+		start = Clock::now();
+		spatialSystem.getTree().querySpheres(SPHERE_COUNT, spheres, sphereResults);
+		end = Clock::now();
+
+		sphereTime += milliseconds(start, end);
+
+		start = Clock::now();
+		spatialSystem.getTree().queryRays(RAY_COUNT, rays, rayResults);
+		end = Clock::now();
+
+		rayTime += milliseconds(start, end);
+	}
+
+	spatialSystem.getTree().validate();
+
+	std::cout << "BVH: " << FRAME_COUNT << " frames, " << MOVING_COUNT << " moving objects per frame" << std::endl;
+	std::cout << "  update:                 " << updateTime / FRAME_COUNT << " ms/frame, "
+		<< reinserts / FRAME_COUNT << " reinserts/frame" << std::endl;
+	std::cout << "  " << CAMERA_COUNT << " frustums, separate:   " << frustumTime / FRAME_COUNT << " ms/frame, "
+		<< visible / FRAME_COUNT << " visible" << std::endl;
+	std::cout << "  " << CAMERA_COUNT << " frustums, batched:    " << batchedFrustumTime / FRAME_COUNT << " ms/frame" << std::endl;
+	std::cout << "  " << CAMERA_COUNT << " frustums, linear:     " << bruteForceTime / FRAME_COUNT << " ms/frame, "
+		<< bruteForceVisible / FRAME_COUNT << " visible" << std::endl;
+	std::cout << "  " << SPHERE_COUNT << " spheres, batched:    " << sphereTime / FRAME_COUNT << " ms/frame" << std::endl;
+	std::cout << "  " << RAY_COUNT << " rays, batched:       " << rayTime / FRAME_COUNT << " ms/frame" << std::endl;
+}
@@ -0,0 +1,8 @@
+#include "Benchmarks.h"
+
+int main(int argc, char** argv)
+{
+	runBVHBenchmark();
+
+	return 0;
+}
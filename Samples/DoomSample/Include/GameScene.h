@@ -9,6 +9,7 @@
 #include "Game/TextComponent.h"
 #include "Game/PhysicsSystem.h"
 #include "Game/ModelComponent.h"
+#include "Game/BoundsComponent.h"
 #include "Game/DirLightComponent.h"
 #include "Game/LightComponent.h"
 #include "Game/PointLightComponent.h"
@@ -69,6 +70,7 @@ private:
 	//// Other values ////
 	float alpha;
 	float cubeX, cubeY, cubeZ;
+	size_t frameCount;
 	////
 
 	//// Entities ////
@@ -132,6 +134,7 @@ private:
 	sge::ComponentFactory<sge::CameraComponent> cameraFactory;
 	sge::ComponentFactory<sge::TextComponent> textFactory;
 	sge::ComponentFactory<sge::ModelComponent> modelFactory;
+	sge::ComponentFactory<sge::BoundsComponent> boundsFactory;
 	sge::ComponentFactory<sge::PointLightComponent> pLightFactory;
 	////
 
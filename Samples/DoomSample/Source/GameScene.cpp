@@ -30,15 +30,16 @@ GameScene::GameScene(sge::Spade* engine) :
 	alpha(0.0f),
 	cubeX(0.5f),
 	cubeY(1.0f),
-	cubeZ(1.0f)
+	cubeZ(1.0f),
+	frameCount(0)
 {
 	sge::VertexLayoutDescription vertexLayoutDescription = { 5,
 	{
-		{ 0, 3, sge::VertexSemantic::POSITION },
-		{ 0, 3, sge::VertexSemantic::NORMAL },
-		{ 0, 3, sge::VertexSemantic::TANGENT },
-		{ 0, 3, sge::VertexSemantic::TANGENT },
-		{ 0, 2, sge::VertexSemantic::TEXCOORD }
+		{ 0, 3, sge::VertexSemantic::POSITION, sge::VertexFormat::FLOAT },
+		{ 0, 3, sge::VertexSemantic::NORMAL, sge::VertexFormat::FLOAT },
+		{ 0, 3, sge::VertexSemantic::TANGENT, sge::VertexFormat::FLOAT },
+		{ 0, 3, sge::VertexSemantic::TANGENT, sge::VertexFormat::FLOAT },
+		{ 0, 2, sge::VertexSemantic::TEXCOORD, sge::VertexFormat::FLOAT }
 	} };
 
 	std::vector<char> pShaderDataNormals;
@@ -47,7 +48,7 @@ GameScene::GameScene(sge::Spade* engine) :
 #ifdef DIRECTX11
 	loadBinaryShader("../../Shaders/Compiled/VertexShaderLights.cso", vShaderDataNormals);
 	loadBinaryShader("../../Shaders/Compiled/PixelShaderLights.cso", pShaderDataNormals);
-#elif OPENGL4
+#elif defined(OPENGL4) || defined(HEADLESS)
 	loadTextShader("../Assets/Shaders/VertexShaderLights.glsl", vShaderDataNormals);
 	loadTextShader("../Assets/Shaders/PixelShaderLights.glsl", pShaderDataNormals);
 #endif
@@ -60,6 +61,9 @@ GameScene::GameScene(sge::Spade* engine) :
 
 	//// Systems ////
 	physicsSystem = new sge::PhysicsSystem();
+
+	// The room and cube textures share 16 MB of video memory.
+	renderer->setTextureBudget(16 * 1024 * 1024);
 	
 	//// Entities //// Creating entities without difficult components
 
@@ -183,6 +187,7 @@ GameScene::GameScene(sge::Spade* engine) :
 	cubeTrans->setRotationVector(sge::math::vec3(0.0f, 0.0f, 1.0f));
 	cubeModel->setPipeline(pipelineNormals);
 	cubeModelHandle.getResource<sge::ModelResource>()->createBuffers();
+	boundsFactory.create(largeCube)->setLocalBounds(cubeModelHandle.getResource<sge::ModelResource>()->getBounds());
 	
 	// Room
 
@@ -195,6 +200,7 @@ GameScene::GameScene(sge::Spade* engine) :
 	roomTrans->setScale(sge::math::vec3(0.6f));
 	roomModel->setPipeline(pipelineNormals);
 	roomModelHandle.getResource<sge::ModelResource>()->createBuffers();
+	boundsFactory.create(room)->setLocalBounds(roomModelHandle.getResource<sge::ModelResource>()->getBounds());
 
 	//// Bullet ////
 
@@ -204,6 +210,8 @@ GameScene::GameScene(sge::Spade* engine) :
 	boxShape = new btBoxShape(btVector3(1, 1, 1));
 	cubePhys->createBody(boxShape, btQuaternion(0, 0, 0, 1), btVector3(0, 0, 0), mass, btVector3(0, 0, 0));
 	physicsSystem->addBody(cubePhys->getBody<btRigidBody>());
+
+	std::cout << "F3: toggle occlusion culling" << std::endl;
 }
 
 GameScene::~GameScene()
@@ -347,6 +355,19 @@ void GameScene::update(float step)
 		engine->stop();
 	}
 
+	if (engine->keyboardInput->keyWasPressed(sge::KEYBOARD_F3))
+	{
+		renderer->setOcclusionCulling(!renderer->getOcclusionCulling());
+		std::cout << "Occlusion culling " << (renderer->getOcclusionCulling() ? "on" : "off") << std::endl;
+	}
+
+	if (++frameCount % 120 == 0 && renderer->getOcclusionCulling())
+	{
+		const sge::RenderStats& stats = renderer->getStats();
+
+		std::cout << stats.occludedModels << " models occluded, " << stats.occlusionQueries << " boxes tested" << std::endl;
+	}
+
 	///////////////
 
 	alpha += 0.01f;
@@ -0,0 +1,73 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "Resources/ModelResource.h"
+
+// Cooks models into the files ModelResource maps in place of them:
+//
+//	ModelCooker model...
+//
+// Prints how long the model takes to import and how long the cooked file takes to load, both
+// with the textures of the model, which load the same way either way.
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage: ModelCooker model..." << std::endl;
+
+		return 1;
+	}
+
+	int failed = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string path = argv[i];
+		std::string cookedPath = sge::ModelResource::getCookedPath(path);
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		{
+			sge::ModelResource imported(path, false);
+		}
+
+		auto importEnd = std::chrono::high_resolution_clock::now();
+
+		if (!sge::ModelResource::cook(path, cookedPath))
+		{
+			failed++;
+
+			continue;
+		}
+
+		auto loadStart = std::chrono::high_resolution_clock::now();
+
+		sge::ModelResource model(path);
+
+		auto loadEnd = std::chrono::high_resolution_clock::now();
+
+		if (!model.isCooked())
+		{
+			std::cout << "Error cooking model " << path << " : the cooked file doesn't load" << std::endl;
+			failed++;
+
+			continue;
+		}
+
+		size_t vertices = 0;
+
+		for (auto mesh : model.getMeshes())
+		{
+			vertices += mesh->vertices.size();
+		}
+
+		double importTime = std::chrono::duration<double, std::milli>(importEnd - start).count();
+		double loadTime = std::chrono::duration<double, std::milli>(loadEnd - loadStart).count();
+
+		std::cout << "Cooked " << path << " (" << model.getMeshes().size() << " meshes, " << vertices << " vertices): import " <<
+			importTime << " ms, cooked load " << loadTime << " ms, " << importTime / loadTime << " times faster" << std::endl;
+	}
+
+	return failed == 0 ? 0 : 1;
+}
@@ -1,3 +1,6 @@
+#include <chrono>
+#include <vector>
+
 #include "Game/Scene.h"
 
 #include "Game/ComponentFactory.h"
@@ -50,6 +53,8 @@ private:
     sge::Entity* createSprite(int x, int y, unsigned int width, unsigned int height, sge::Texture* texture);
 	sge::Entity* createSpaceShip();
 	sge::Entity* createMoon();
+    void createLightRing(size_t count);
+    void measureFrameTime();
 
     sge::Entity* earth;
     sge::Entity* overviewCamera;
@@ -65,6 +70,19 @@ private:
 	sge::Entity* earthScreen;
 	sge::Entity* spaceShipScreen;
 
+    // Point lights circling the sun, toggled to compare the render paths under load.
+    std::vector<sge::Entity*> lightRing;
+    bool lightRingEnabled;
+
+    // Image in the corner streamed in by the renderer, F10 streams the next one.
+    sge::Entity* streamedSprite;
+    sge::Texture* streamedTexture;
+    size_t streamedImage;
+
+    std::chrono::high_resolution_clock::time_point previousFrame;
+    double frameTimeSum;
+    size_t frameCount;
+
 	sge::RenderTarget* fullScreenTarget;
     sge::RenderTarget* overviewScreenTarget;
 	sge::RenderTarget* earthScreenTarget;
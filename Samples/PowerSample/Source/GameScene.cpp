@@ -1,8 +1,13 @@
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
 #include "GameScene.h"
 
 #include "Game/Entity.h"
 #include "Game/CameraComponent.h"
 #include "Game/ModelComponent.h"
+#include "Game/PointLightComponent.h"
 #include "Game/SpriteComponent.h"
 #include "Game/TransformComponent.h"
 #include "Game/RenderSystem.h"
@@ -15,6 +20,26 @@
 
 #include "Spade/Spade.h"
 
+// Video memory of the model textures, F8 switches between it and no limit.
+const size_t TEXTURE_BUDGET = 32 * 1024 * 1024;
+
+// Images F10 streams in turn.
+const char* const STREAMED_IMAGES[] = { "../Assets/spade.png", "../Assets/Sun_diffuse.png", "../Assets/Earth_diffuse.png" };
+const size_t STREAMED_IMAGE_COUNT = sizeof(STREAMED_IMAGES) / sizeof(STREAMED_IMAGES[0]);
+
+namespace
+{
+    // Creates the buffers of a lit model and reports how much packing its vertices saved.
+    void createPackedBuffers(sge::ModelResource* model)
+    {
+        size_t packedBytes = model->createBuffers(true);
+        size_t unpackedBytes = model->getVertexCount() * sizeof(Vertex);
+
+        std::cout << "Packed " << model->getResourcePath() << ": " << packedBytes << " vertex bytes instead of " << unpackedBytes
+            << ", saved " << unpackedBytes - packedBytes << std::endl;
+    }
+}
+
 /*
 TODO enko
 
@@ -24,17 +49,25 @@ Instanced rendering do!
 Deferred rendering do!
 Kameralle lookAt!
 Optimoi bulletscenea (nykii ihan vitusti)
-    - Esim valojen dataa ei tarvii vied joka objektille erikseen
+    - Esim valojen dataa ei tarvii viedä joka objektille erikseen
     - Sorttaus takasin kuntoon jos tarviijaksaahaluaa
-Tee se demo ja siihen kaikkea hauskaa (blur, hdr voe pojat efektej)
+Tee se demo ja siihen kaikkea hauskaa (blur, hdr voe pojat efektejä)
 DX11 fixes go!
 */
 
 GameScene::GameScene(sge::Spade* engine) :
+    lightRingEnabled(false),
+    streamedSprite(nullptr),
+    streamedTexture(nullptr),
+    streamedImage(0),
+    frameTimeSum(0.0),
+    frameCount(0),
     engine(engine),
     renderer(engine->getRenderer()),
     device(renderer->getDevice())
 {
+    renderer->setTextureBudget(TEXTURE_BUDGET);
+
     initPipelines();
     initResources();
 
@@ -55,6 +88,15 @@ GameScene::GameScene(sge::Spade* engine) :
 
 	spaceShip = createSpaceShip();
 	moon = createMoon();
+
+    streamedTexture = renderer->streamTexture(STREAMED_IMAGES[streamedImage]);
+    streamedSprite = createSprite(1142, 552, 128, 128, streamedTexture);
+
+    createLightRing(256);
+
+    previousFrame = std::chrono::high_resolution_clock::now();
+
+    std::cout << "F1: switch between forward and deferred rendering, F2: toggle " << lightRing.size() << " point lights, F3: toggle the depth pre-pass, F4: toggle multithreaded recording, F5: toggle the render thread, F6: toggle indirect depth pre-pass draws, F7: toggle GPU culling of the indirect draws, F8: toggle the texture budget, F9: toggle texture arrays, F10: stream the next corner image" << std::endl;
 }
 
 GameScene::~GameScene()
@@ -67,6 +109,8 @@ GameScene::~GameScene()
 
     device->deleteCubeMap(skyBoxCubeMap);
 
+    renderer->deleteStreamedTexture(streamedTexture);
+
     device->deleteShader(vertexShader);
     device->deleteShader(pixelShader);
     device->deleteShader(skyBoxPixelShader);
@@ -89,6 +133,94 @@ void GameScene::update(float step)
         engine->stop();
     }
 
+    if (engine->keyboardInput->keyWasPressed(sge::KEYBOARD_F1))
+    {
+        bool deferred = renderer->getRenderPath() == sge::RenderPath::DEFERRED;
+
+        renderer->setRenderPath(deferred ? sge::RenderPath::FORWARD : sge::RenderPath::DEFERRED);
+        frameTimeSum = 0.0;
+        frameCount = 0;
+    }
+
+    if (engine->keyboardInput->keyWasPressed(sge::KEYBOARD_F2))
+    {
+        lightRingEnabled = !lightRingEnabled;
+        frameTimeSum = 0.0;
+        frameCount = 0;
+    }
+
+    if (engine->keyboardInput->keyWasPressed(sge::KEYBOARD_F3))
+    {
+        renderer->setDepthPrePass(!renderer->getDepthPrePass());
+        frameTimeSum = 0.0;
+        frameCount = 0;
+    }
+
+    if (engine->keyboardInput->keyWasPressed(sge::KEYBOARD_F4))
+    {
+        size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+        renderer->setRecordThreads(renderer->getRecordThreads() ? 0 : threads);
+        frameTimeSum = 0.0;
+        frameCount = 0;
+    }
+
+    if (engine->keyboardInput->keyWasPressed(sge::KEYBOARD_F5))
+    {
+        renderer->setPipelined(!renderer->isPipelined());
+        frameTimeSum = 0.0;
+        frameCount = 0;
+    }
+
+    if (engine->keyboardInput->keyWasPressed(sge::KEYBOARD_F6))
+    {
+        renderer->setIndirectDraws(!renderer->getIndirectDraws());
+        frameTimeSum = 0.0;
+        frameCount = 0;
+    }
+
+    if (engine->keyboardInput->keyWasPressed(sge::KEYBOARD_F7))
+    {
+        renderer->setGpuCulling(!renderer->getGpuCulling());
+        frameTimeSum = 0.0;
+        frameCount = 0;
+    }
+
+    if (engine->keyboardInput->keyWasPressed(sge::KEYBOARD_F8))
+    {
+        renderer->setTextureBudget(renderer->getTextureBudget() ? 0 : TEXTURE_BUDGET);
+        frameTimeSum = 0.0;
+        frameCount = 0;
+    }
+
+    if (engine->keyboardInput->keyWasPressed(sge::KEYBOARD_F9))
+    {
+        renderer->setTextureArrays(!renderer->getTextureArrays());
+        frameTimeSum = 0.0;
+        frameCount = 0;
+    }
+
+    // The previous image may still be streaming when it is deleted.
+    if (engine->keyboardInput->keyWasPressed(sge::KEYBOARD_F10))
+    {
+        streamedImage = (streamedImage + 1) % STREAMED_IMAGE_COUNT;
+
+        sge::Texture* texture = renderer->streamTexture(STREAMED_IMAGES[streamedImage]);
+        streamedSprite->getComponent<sge::SpriteComponent>()->setTexture(texture);
+
+        renderer->deleteStreamedTexture(streamedTexture);
+        streamedTexture = texture;
+    }
+
+    for (size_t i = 0; i < lightRing.size(); i++)
+    {
+        float angle = alpha * 0.5f + 6.2831853f * i / lightRing.size();
+        float radius = 3.0f + 4.0f * (i % 4) / 3.0f;
+
+        lightRing[i]->getComponent<sge::TransformComponent>()->setPosition(sge::math::vec3(radius * cos(angle), 0.5f * sin(angle * 3.0f), radius * sin(angle)));
+        lightRing[i]->getComponent<sge::PointLightComponent>()->update();
+    }
+
     earth->getComponent<sge::TransformComponent>()->setPosition(sge::math::vec3(5.0f*cos(alpha), 0.0f, 5.0f*sin(alpha)));
     earth->getComponent<sge::TransformComponent>()->addAngle(0.025f);
 
@@ -116,6 +248,8 @@ void GameScene::update(float step)
 
 void GameScene::draw()
 {
+    measureFrameTime();
+
 	// Render overview camera.
 	renderer->addCameras(1, &overviewCamera);
 	renderer->setRenderTarget(overviewScreenTarget);
@@ -124,6 +258,11 @@ void GameScene::draw()
 
     renderer->begin();
     renderer->renderLights(1, &sun);
+
+    if (lightRingEnabled)
+    {
+        renderer->renderLights(lightRing.size(), lightRing.data());
+    }
     renderer->renderModels(1, &earth);
     renderer->renderModels(1, &sun);
     renderer->renderModels(1, &skybox);
@@ -158,6 +297,7 @@ void GameScene::draw()
 	renderer->renderSprites(1, &overviewScreen);
 	renderer->renderSprites(1, &earthScreen);
 	renderer->renderSprites(1, &spaceShipScreen);
+	renderer->renderSprites(1, &streamedSprite);
 	renderer->end();
 
 	//renderer->render();
@@ -271,6 +411,7 @@ sge::Entity* GameScene::createSun()
 	dirlight->setLightData(dirlightData);
 
     model->setPipeline(noLightsPipeline);
+    model->setLit(false);
     model->setShininess(256.0f);
     model->setRenderer(renderer);
     model->setModelResource(&sunResource);
@@ -280,6 +421,63 @@ sge::Entity* GameScene::createSun()
     return entity;
 }
 
+void GameScene::createLightRing(size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        sge::Entity* entity = entityManager.createEntity();
+
+        transformFactory.create(entity);
+        auto light = pointLightFactory.create(entity);
+
+        float hue = 6.2831853f * i / count;
+
+        sge::PointLight lightData;
+
+        lightData.position = sge::math::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        lightData.constant = 1.0f;
+        lightData.mylinear = 0.7f;
+        lightData.quadratic = 1.8f;
+        lightData.pad = 0.0f;
+        lightData.ambient = sge::math::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        lightData.diffuse = sge::math::vec4(0.5f + 0.5f * cos(hue), 0.5f + 0.5f * cos(hue + 2.094f), 0.5f + 0.5f * cos(hue + 4.189f), 1.0f);
+        lightData.specular = lightData.diffuse;
+
+        light->setLightData(lightData);
+
+        lightRing.push_back(entity);
+    }
+}
+
+void GameScene::measureFrameTime()
+{
+    auto now = std::chrono::high_resolution_clock::now();
+
+    frameTimeSum += std::chrono::duration<double, std::milli>(now - previousFrame).count();
+    previousFrame = now;
+
+    if (++frameCount == 120)
+    {
+        const sge::RenderStats& stats = renderer->getStats();
+
+        std::cout << (renderer->getRenderPath() == sge::RenderPath::DEFERRED ? "Deferred" : "Forward")
+            << (renderer->getDepthPrePass() ? " with depth pre-pass" : "")
+            << (renderer->getDepthPrePass() && renderer->getIndirectDraws() ? " in " + std::to_string(stats.indirectCalls) + " indirect calls" : "")
+            << (renderer->getDepthPrePass() && renderer->getIndirectDraws() && renderer->getGpuCulling() ? " culled on the GPU" : "")
+            << (renderer->getRecordThreads() ? ", recorded by " + std::to_string(renderer->getRecordThreads()) + " threads" : "")
+            << (renderer->isPipelined() ? ", render thread" : "")
+            << ", " << (lightRingEnabled ? lightRing.size() + 1 : 1) << " point lights: "
+            << frameTimeSum / frameCount << " ms/frame, "
+            << stats.drawCalls << " + " << stats.depthDrawCalls << " draws, "
+            << stats.samples << " samples, overdraw " << stats.getOverdraw() << ", "
+            << renderer->getTextureMemory() / 1024 << " KB of textures" << (renderer->getTextureArrays() ? " in arrays" : "") << ", "
+            << stats.textureBinds << " texture binds" << std::endl;
+
+        frameTimeSum = 0.0;
+        frameCount = 0;
+    }
+}
+
 sge::Entity* GameScene::createSkyBox()
 {
     sge::Handle<sge::TextureResource> texture;
@@ -307,6 +505,7 @@ sge::Entity* GameScene::createSkyBox()
     transform->setUp({ 0.0f, 0.0f, 0.0f });
 
     model->setPipeline(skyBoxPipeline);
+    model->setLit(false);
     model->setRenderer(renderer);
     model->setModelResource(&skyBoxResource);
     model->setCubeMap(skyBoxCubeMap);
@@ -396,7 +595,7 @@ void GameScene::initPipelines()
     skyBoxPixelShaderHandle = sge::ResourceManager::getMgr().load<sge::ShaderResource>("../Assets/Shaders/PixelSkyBox.cso");
     noLightsVertexShaderHandle = sge::ResourceManager::getMgr().load<sge::ShaderResource>("../Assets/Shaders/VertexShaderNoLights.cso");
     noLightsPixelShaderHandle = sge::ResourceManager::getMgr().load<sge::ShaderResource>("../Assets/Shaders/PixelShaderNoLights.cso");
-#elif OPENGL4
+#elif defined(OPENGL4) || defined(HEADLESS)
     vertexShaderHandle = sge::ResourceManager::getMgr().load<sge::ShaderResource>("../Assets/Shaders/VertexShaderLights.glsl");
     pixelShaderHandle = sge::ResourceManager::getMgr().load<sge::ShaderResource>("../Assets/Shaders/PixelShaderLights.glsl");
     skyBoxVertexShaderHandle = sge::ResourceManager::getMgr().load<sge::ShaderResource>("../Assets/Shaders/VertexSkyBox.glsl");
@@ -425,14 +624,17 @@ void GameScene::initPipelines()
 
     sge::VertexLayoutDescription vertexLayoutDescription = { 5,
     {
-        { 0, 3, sge::VertexSemantic::POSITION },
-        { 0, 3, sge::VertexSemantic::NORMAL },
-        { 0, 3, sge::VertexSemantic::TANGENT },
-        { 0, 3, sge::VertexSemantic::TANGENT },
-        { 0, 2, sge::VertexSemantic::TEXCOORD }
+        { 0, 3, sge::VertexSemantic::POSITION, sge::VertexFormat::FLOAT },
+        { 0, 3, sge::VertexSemantic::NORMAL, sge::VertexFormat::FLOAT },
+        { 0, 3, sge::VertexSemantic::TANGENT, sge::VertexFormat::FLOAT },
+        { 0, 3, sge::VertexSemantic::TANGENT, sge::VertexFormat::FLOAT },
+        { 0, 2, sge::VertexSemantic::TEXCOORD, sge::VertexFormat::FLOAT }
     } };
 
-    pipeline = device->createPipeline(&vertexLayoutDescription, vertexShader, pixelShader);
+    // The lit models are packed, VertexShaderLights.glsl decodes them.
+    sge::VertexLayoutDescription packedLayoutDescription = sge::Mesh::getPackedLayout();
+
+    pipeline = device->createPipeline(&packedLayoutDescription, vertexShader, pixelShader);
     skyBoxPipeline = device->createPipeline(&vertexLayoutDescription, skyBoxVertexShader, skyBoxPixelShader);
     noLightsPipeline = device->createPipeline(&vertexLayoutDescription, noLightsVertexShader, noLightsPixelShader);
 }
@@ -442,15 +644,15 @@ void GameScene::initResources()
     device->bindPipeline(pipeline);
     earthResource = sge::ResourceManager::getMgr().load<sge::ModelResource>("../Assets/liteEarthDiffuseSpecular.dae");
     earthResource.getResource<sge::ModelResource>()->setDevice(device);
-    earthResource.getResource<sge::ModelResource>()->createBuffers();
+    createPackedBuffers(earthResource.getResource<sge::ModelResource>());
 
 	spaceShipResource = sge::ResourceManager::getMgr().load<sge::ModelResource>("../Assets/SpaceShip.dae");
 	spaceShipResource.getResource<sge::ModelResource>()->setDevice(device);
-	spaceShipResource.getResource<sge::ModelResource>()->createBuffers();
+	createPackedBuffers(spaceShipResource.getResource<sge::ModelResource>());
 
 	moonResource = sge::ResourceManager::getMgr().load<sge::ModelResource>("../Assets/moonSphere.dae");
 	moonResource.getResource<sge::ModelResource>()->setDevice(device);
-	moonResource.getResource<sge::ModelResource>()->createBuffers();
+	createPackedBuffers(moonResource.getResource<sge::ModelResource>());
 
     device->debindPipeline(pipeline);
 
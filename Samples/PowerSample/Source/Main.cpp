@@ -1,3 +1,6 @@
+#include <chrono>
+#include <iostream>
+
 #include "Spade/Spade.h"
 #include "GameScene.h"
 
@@ -5,7 +8,12 @@ int main(int argc, char** argv)
 {
     sge::Spade spade;
 
+    spade.getRenderer()->setProgramCache("../Assets/ShaderCache");
+
+    // Compare a first start against one reading the program cache.
+    auto start = std::chrono::high_resolution_clock::now();
     spade.init();
+    std::cout << "Engine initialized in " << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() << " ms" << std::endl;
     spade.run(new GameScene(&spade));
     spade.quit();
 
@@ -190,7 +190,7 @@ int main(int argc, char** argv)
 #ifdef DIRECTX11
 	loadBinaryShader("../Assets/Shaders/VertexShader.cso", vShaderData);
 	loadBinaryShader("../Assets/Shaders/PixelShader.cso", pShaderData);
-#elif OPENGL4
+#elif defined(OPENGL4) || defined(HEADLESS)
 	loadTextShader("../Assets/Shaders/VertexShader.glsl", vShaderData);
 	loadTextShader("../Assets/Shaders/PixelShader.glsl", pShaderData);
 #endif
@@ -219,11 +219,11 @@ int main(int argc, char** argv)
 
 	sge::VertexLayoutDescription vertexLayoutDescription = { 5,
 	{
-		{ 0, 3, sge::VertexSemantic::POSITION },
-		{ 0, 3, sge::VertexSemantic::NORMAL },
-		{ 0, 3, sge::VertexSemantic::TANGENT },
-		{ 0, 3, sge::VertexSemantic::TANGENT },
-		{ 0, 2, sge::VertexSemantic::TEXCOORD }
+		{ 0, 3, sge::VertexSemantic::POSITION, sge::VertexFormat::FLOAT },
+		{ 0, 3, sge::VertexSemantic::NORMAL, sge::VertexFormat::FLOAT },
+		{ 0, 3, sge::VertexSemantic::TANGENT, sge::VertexFormat::FLOAT },
+		{ 0, 3, sge::VertexSemantic::TANGENT, sge::VertexFormat::FLOAT },
+		{ 0, 2, sge::VertexSemantic::TEXCOORD, sge::VertexFormat::FLOAT }
 	} };
 
 	sge::Shader* vertexShader = device.createShader(sge::ShaderType::VERTEX, vShaderData.data(), vShaderData.size());
@@ -145,11 +145,11 @@ BulletTestScene::BulletTestScene(sge::Spade* engine) : engine(engine), renderer(
 	// Creating pipeline
 	sge::VertexLayoutDescription vertexLayoutDescription = { 5,
 	{
-		{ 0, 3, sge::VertexSemantic::POSITION },
-		{ 0, 3, sge::VertexSemantic::NORMAL },
-		{ 0, 3, sge::VertexSemantic::TANGENT },
-		{ 0, 3, sge::VertexSemantic::TANGENT },
-		{ 0, 2, sge::VertexSemantic::TEXCOORD }
+		{ 0, 3, sge::VertexSemantic::POSITION, sge::VertexFormat::FLOAT },
+		{ 0, 3, sge::VertexSemantic::NORMAL, sge::VertexFormat::FLOAT },
+		{ 0, 3, sge::VertexSemantic::TANGENT, sge::VertexFormat::FLOAT },
+		{ 0, 3, sge::VertexSemantic::TANGENT, sge::VertexFormat::FLOAT },
+		{ 0, 2, sge::VertexSemantic::TEXCOORD, sge::VertexFormat::FLOAT }
 	} };
 
 	std::vector<char> pShaderDataNormals;
@@ -158,7 +158,7 @@ BulletTestScene::BulletTestScene(sge::Spade* engine) : engine(engine), renderer(
 #ifdef DIRECTX11
 	loadBinaryShader("../../Shaders/Compiled/VertexShaderLights.cso", vShaderDataNormals);
 	loadBinaryShader("../../Shaders/Compiled/PixelShaderLights.cso", pShaderDataNormals);
-#elif OPENGL4
+#elif defined(OPENGL4) || defined(HEADLESS)
 	loadTextShader("../Assets/Shaders/VertexShaderLights.glsl", vShaderDataNormals);
 	loadTextShader("../Assets/Shaders/PixelShaderLights.glsl", pShaderDataNormals);
 #endif
@@ -111,7 +111,7 @@ TestScene::TestScene(sge::Spade* engine) : engine(engine)
 #ifdef DIRECTX11
 	loadBinaryShader("../Assets/Shaders/VertexShader.cso", vShaderData);
 	loadBinaryShader("../Assets/Shaders/PixelShader.cso", pShaderData);
-#elif OPENGL4
+#elif defined(OPENGL4) || defined(HEADLESS)
 	loadTextShader("../Assets/Shaders/VertexShader.glsl", vShaderData);
 	loadTextShader("../Assets/Shaders/PixelShader.glsl", pShaderData);
 #endif
@@ -155,11 +155,11 @@ TestScene::TestScene(sge::Spade* engine) : engine(engine)
 
 	sge::VertexLayoutDescription vertexLayoutDescription = { 5,
 	{
-		{ 0, 3, sge::VertexSemantic::POSITION },
-		{ 0, 3, sge::VertexSemantic::NORMAL },
-		{ 0, 3, sge::VertexSemantic::TANGENT },
-		{ 0, 3, sge::VertexSemantic::TANGENT },
-		{ 0, 2, sge::VertexSemantic::TEXCOORD }
+		{ 0, 3, sge::VertexSemantic::POSITION, sge::VertexFormat::FLOAT },
+		{ 0, 3, sge::VertexSemantic::NORMAL, sge::VertexFormat::FLOAT },
+		{ 0, 3, sge::VertexSemantic::TANGENT, sge::VertexFormat::FLOAT },
+		{ 0, 3, sge::VertexSemantic::TANGENT, sge::VertexFormat::FLOAT },
+		{ 0, 2, sge::VertexSemantic::TEXCOORD, sge::VertexFormat::FLOAT }
 	} };
 
 	vertexShader = engine->getRenderer()->getDevice()->createShader(sge::ShaderType::VERTEX, vShaderData.data(), vShaderData.size());
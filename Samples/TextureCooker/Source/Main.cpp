@@ -0,0 +1,77 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "stb_image.h"
+
+#include "Resources/BlockCompression.h"
+#include "Resources/TextureResource.h"
+
+// Cooks images into the files TextureResource loads in place of them:
+//
+//	TextureCooker [-auto | -bc1 | -bc3 | -bc5 | -rgba] image...
+//
+// A format applies to the images after it. The default picks BC3 for images with an alpha
+// channel and BC1 for the rest. BC5 keeps only red and green, for shaders that rebuild the
+// third normal component themselves.
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage: TextureCooker [-auto | -bc1 | -bc3 | -bc5 | -rgba] image..." << std::endl;
+
+		return 1;
+	}
+
+	bool automatic = true;
+	sge::Format format = sge::Format::BC1;
+	int failed = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+
+		if (argument == "-auto") { automatic = true; continue; }
+		if (argument == "-bc1") { automatic = false; format = sge::Format::BC1; continue; }
+		if (argument == "-bc3") { automatic = false; format = sge::Format::BC3; continue; }
+		if (argument == "-bc5") { automatic = false; format = sge::Format::BC5; continue; }
+		if (argument == "-rgba") { automatic = false; format = sge::Format::RGBA; continue; }
+
+		int width, height, components;
+
+		if (!stbi_info(argument.c_str(), &width, &height, &components))
+		{
+			std::cout << "Error cooking texture " << argument << " : not an image" << std::endl;
+			failed++;
+
+			continue;
+		}
+
+		sge::Format imageFormat = format;
+
+		if (automatic)
+		{
+			imageFormat = components == 4 ? sge::Format::BC3 : sge::Format::BC1;
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		if (!sge::TextureResource::cook(argument, sge::TextureResource::getCookedPath(argument), imageFormat))
+		{
+			failed++;
+
+			continue;
+		}
+
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		const char* names[] = { "BC1", "BC3", "BC5" };
+		const char* name = imageFormat == sge::Format::RGBA ? "RGBA" : names[static_cast<int>(imageFormat) - static_cast<int>(sge::Format::BC1)];
+
+		std::cout << "Cooked " << argument << " (" << width << "x" << height << ") as " << name << ", " <<
+			sge::getImageSize(sge::Format::RGBA, width, height) / 1024 << " KB -> " <<
+			sge::getImageSize(imageFormat, width, height) / 1024 << " KB in the first level, " << ms << " ms" << std::endl;
+	}
+
+	return failed == 0 ? 0 : 1;
+}
@@ -1,8 +1,33 @@
+#include <chrono>
+#include <cstdlib>
+
 #include "Spade/Spade.h"
 #include "Game/Scene.h"
+#include "Renderer/Headless/CommandLog.h"
 
 namespace sge
 {
+#ifdef HEADLESS
+	namespace
+	{
+		// Frames rendered by a headless run, SGE_HEADLESS_FRAMES overrides the default.
+		size_t getHeadlessFrameLimit()
+		{
+			const char* frames = SDL_getenv("SGE_HEADLESS_FRAMES");
+
+			return frames ? std::strtoul(frames, nullptr, 10) : 1000;
+		}
+
+		// SGE_RENDER_THREAD=1 runs a headless benchmark with a pipelined renderer.
+		bool getHeadlessRenderThread()
+		{
+			const char* renderThread = SDL_getenv("SGE_RENDER_THREAD");
+
+			return renderThread && std::strtoul(renderThread, nullptr, 10) != 0;
+		}
+	}
+#endif
+
 	Spade::Spade() : 
         window("Spade Game Engine", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 1280, 720),
         renderer(window),
@@ -63,24 +88,67 @@ namespace sge
 	void Spade::run(Scene* scene)
 	{
 		float deltaTime = 0.0f;
+
+#ifndef HEADLESS
 		float newTime = 0.0f;
 		float currentTime = SDL_GetTicks() / 1000.0f;
+#endif
 
 		sceneManager->change(scene);
 		sceneManager->handleScenes();
 
+#ifdef HEADLESS
+		size_t frameLimit = getHeadlessFrameLimit();
+		size_t frames = 0;
+		auto start = std::chrono::high_resolution_clock::now();
+
+		renderer.setPipelined(getHeadlessRenderThread());
+#endif
+
 		while (running)
 		{
+#ifdef HEADLESS
+			// Every frame advances exactly one step, so runs can be compared with each other.
+			deltaTime = step;
+#else
 			newTime = SDL_GetTicks() / 1000.0f;
 			deltaTime = std::min(newTime - currentTime, 0.25f);
 			currentTime = newTime;
+#endif
 
 			handleEvents();
 			update(deltaTime);
 			draw();
 
-			sceneManager->handleScenes();
+			// Scenes create and delete graphics resources, which a pipelined renderer only allows on its render thread.
+			if (sceneManager->hasPendingAction())
+			{
+				renderer.runOnDevice([this]() { sceneManager->handleScenes(); });
+			}
+
+			// So do the callbacks of resources loaded in the background, which usually create their buffers and textures.
+			if (ResourceManager::getMgr().hasFinishedLoads())
+			{
+				renderer.runOnDevice([]() { ResourceManager::getMgr().update(); });
+			}
+
+#ifdef HEADLESS
+			if (++frames >= frameLimit)
+			{
+				running = false;
+			}
+#endif
 		}
+
+		// The scenes are deleted on this thread when quitting.
+		renderer.setPipelined(false);
+
+#ifdef HEADLESS
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		std::cout << "CPU time per frame: " << milliseconds / std::max(frames, static_cast<size_t>(1)) << " ms" << std::endl;
+		renderer.getDevice()->getCommandLog().print(std::cout);
+#endif
 	}
 
 	void Spade::handleEvents()
@@ -2,6 +2,7 @@
 
 cd Build
 
-premake4 gmake
+# Options such as --headless are passed on to premake.
+premake4 "$@" gmake
 make clean
 make